@@ -0,0 +1,23 @@
+meta:
+	ADDON_NAME = ofxWarp
+	ADDON_DESCRIPTION = Editable bilinear and perspective warps for projection mapping
+	ADDON_AUTHOR = Elie Zananiri
+	ADDON_TAGS = "warp" "projection mapping" "edge blending"
+	ADDON_URL = https://github.com/prisonerjohn/ofxWarp
+
+linux64:
+	# shm_open for CalibrationChannel.
+	ADDON_LDFLAGS = -lrt
+
+linux:
+	ADDON_LDFLAGS = -lrt
+
+linuxarmv6l:
+	ADDON_LDFLAGS = -lrt
+
+linuxarmv7l:
+	ADDON_LDFLAGS = -lrt
+
+msys2:
+	# Sockets for RemoteControl.
+	ADDON_LDFLAGS = -lws2_32
@@ -0,0 +1,960 @@
+#include "ofApp.h"
+
+namespace
+{
+	//--------------------------------------------------------------
+	// Reference: the float Gaussian elimination previously used by WarpPerspective::getPerspectiveTransform().
+	void gaussianElimination(float * input, int n)
+	{
+		auto i = 0;
+		auto j = 0;
+		auto m = n - 1;
+
+		while (i < m && j < n)
+		{
+			auto iMax = i;
+			for (auto k = i + 1; k < m; ++k)
+			{
+				if (fabs(input[k * n + j]) > fabs(input[iMax * n + j]))
+				{
+					iMax = k;
+				}
+			}
+
+			if (input[iMax * n + j] != 0)
+			{
+				if (i != iMax)
+				{
+					for (auto k = 0; k < n; ++k)
+					{
+						auto ikIn = input[i * n + k];
+						input[i * n + k] = input[iMax * n + k];
+						input[iMax * n + k] = ikIn;
+					}
+				}
+
+				float ijIn = input[i * n + j];
+				for (auto k = 0; k < n; ++k)
+				{
+					input[i * n + k] /= ijIn;
+				}
+
+				for (auto u = i + 1; u < m; ++u)
+				{
+					auto ujIn = input[u * n + j];
+					for (auto k = 0; k < n; ++k)
+					{
+						input[u * n + k] -= ujIn * input[i * n + k];
+					}
+				}
+
+				++i;
+			}
+			++j;
+		}
+
+		for (auto i = m - 2; i >= 0; --i)
+		{
+			for (auto j = i + 1; j < n - 1; ++j)
+			{
+				input[i * n + m] -= input[i * n + j] * input[j * n + m];
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	glm::mat4 getPerspectiveTransform(const glm::vec2 src[4], const glm::vec2 dst[4])
+	{
+		float p[8][9] =
+		{
+			{ -src[0][0], -src[0][1], -1, 0, 0, 0, src[0][0] * dst[0][0], src[0][1] * dst[0][0], -dst[0][0] },
+			{ 0, 0, 0, -src[0][0], -src[0][1], -1, src[0][0] * dst[0][1], src[0][1] * dst[0][1], -dst[0][1] },
+			{ -src[1][0], -src[1][1], -1, 0, 0, 0, src[1][0] * dst[1][0], src[1][1] * dst[1][0], -dst[1][0] },
+			{ 0, 0, 0, -src[1][0], -src[1][1], -1, src[1][0] * dst[1][1], src[1][1] * dst[1][1], -dst[1][1] },
+			{ -src[2][0], -src[2][1], -1, 0, 0, 0, src[2][0] * dst[2][0], src[2][1] * dst[2][0], -dst[2][0] },
+			{ 0, 0, 0, -src[2][0], -src[2][1], -1, src[2][0] * dst[2][1], src[2][1] * dst[2][1], -dst[2][1] },
+			{ -src[3][0], -src[3][1], -1, 0, 0, 0, src[3][0] * dst[3][0], src[3][1] * dst[3][0], -dst[3][0] },
+			{ 0, 0, 0, -src[3][0], -src[3][1], -1, src[3][0] * dst[3][1], src[3][1] * dst[3][1], -dst[3][1] },
+		};
+
+		gaussianElimination(&p[0][0], 9);
+
+		return glm::mat4(p[0][8], p[3][8], 0, p[6][8],
+						 p[1][8], p[4][8], 0, p[7][8],
+						 0, 0, 1, 0,
+						 p[2][8], p[5][8], 0, 1);
+	}
+
+	//--------------------------------------------------------------
+	glm::dvec2 transformPoint(const glm::mat4 & m, const glm::vec2 & pt)
+	{
+		auto p = glm::dvec4(m * glm::vec4(pt.x, pt.y, 0.0f, 1.0f));
+		return glm::dvec2(p.x, p.y) / p.w;
+	}
+
+	//--------------------------------------------------------------
+	// Reference: the blend curve of WarpBilinear.frag and WarpPerspective.frag, evaluated in double precision for one channel.
+	double evaluateBlendCurveReference(double a, double luminance, double exponent, double gamma)
+	{
+		auto blend = (a < 0.5) ? (luminance * pow(2.0 * a, exponent)) : 1.0 - (1.0 - luminance) * pow(2.0 * (1.0 - a), exponent);
+		return pow(blend, 1.0 / gamma);
+	}
+
+	//--------------------------------------------------------------
+	// Sample one channel of the blend LUT like the shaders do: at (a * (size - 1) + 0.5) / size, with linear filtering and clamp to edge.
+	double sampleBlendLut(const std::vector<float> & lut, size_t size, size_t channel, double a)
+	{
+		auto coord = (a * (size - 1) + 0.5) / size;
+		auto texel = coord * size - 0.5;
+		auto i0 = (int)floor(texel);
+		auto t = texel - i0;
+		auto i1 = MIN(MAX(i0 + 1, 0), (int)size - 1);
+		i0 = MIN(MAX(i0, 0), (int)size - 1);
+		return lut[i0 * 3 + channel] * (1.0 - t) + lut[i1 * 3 + channel] * t;
+	}
+
+	//--------------------------------------------------------------
+	// Exposes the mesh building steps of the bilinear warp, which are otherwise only run when drawing.
+	class BenchmarkWarpBilinear
+		: public ofxWarp::WarpBilinear
+	{
+	public:
+		using WarpBilinear::BLEND_LUT_SIZE;
+
+		void runSetupMesh()
+		{
+			auto meshQuads = this->getMeshQuads();
+			this->setupMesh(meshQuads.x, meshQuads.y);
+		}
+
+		void runUpdateMesh()
+		{
+			this->dirty = true;
+			this->updateMesh();
+		}
+
+		int getNumVertices() const
+		{
+			return this->resolutionX * this->resolutionY;
+		}
+
+		void runMeshGeneric(std::vector<glm::vec3> & vertices) const
+		{
+			vertices.resize(this->getNumVertices());
+			this->updateMeshGeneric(0, this->resolutionX, vertices.data());
+		}
+
+		bool runMeshFixed(std::vector<glm::vec3> & vertices) const
+		{
+			vertices.resize(this->getNumVertices());
+			return this->updateMeshFixed(0, this->resolutionX, vertices.data());
+		}
+	};
+
+	//--------------------------------------------------------------
+	// Exposes the control point selection of the controller, which is otherwise only run from mouse events.
+	class BenchmarkController
+		: public ofxWarp::Controller
+	{
+	public:
+		using Controller::selectClosestControlPoint;
+	};
+
+	//--------------------------------------------------------------
+	void randomQuad(const glm::vec2 & size, glm::vec2 quad[4])
+	{
+		quad[0] = glm::vec2(ofRandom(0.0f, 0.45f), ofRandom(0.0f, 0.45f)) * size;
+		quad[1] = glm::vec2(ofRandom(0.55f, 1.0f), ofRandom(0.0f, 0.45f)) * size;
+		quad[2] = glm::vec2(ofRandom(0.55f, 1.0f), ofRandom(0.55f, 1.0f)) * size;
+		quad[3] = glm::vec2(ofRandom(0.0f, 0.45f), ofRandom(0.55f, 1.0f)) * size;
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::setup()
+{
+	ofSetLogLevel(OF_LOG_NOTICE);
+	ofSeedRandom(1);
+
+	this->sink = 0.0;
+	this->failed = false;
+
+	this->benchmarkHomography();
+	this->benchmarkInverseMapping();
+	this->benchmarkWarpIndex();
+	this->benchmarkSoftwareRenderer();
+	this->benchmarkMesh();
+	this->benchmarkFixedGrids();
+	this->benchmarkBlendCurve();
+	this->benchmarkGridFitter();
+	this->benchmarkControlPoints();
+	this->benchmarkPerspective();
+	this->benchmarkClip();
+	this->benchmarkSerialization();
+
+	this->saveResults(ofToDataPath("benchmark.json", true));
+
+	ofLogNotice("Benchmark") << "Done (" << this->sink << ")";
+	ofExit(this->failed ? 1 : 0);
+}
+
+//--------------------------------------------------------------
+void ofApp::draw()
+{}
+
+//--------------------------------------------------------------
+void ofApp::saveResults(const std::string & filePath)
+{
+	nlohmann::json json;
+	json["timestamp"] = ofGetTimestampString("%Y-%m-%dT%H:%M:%S");
+	json["openframeworks"] = ofGetVersionInfo();
+	json["threads"] = std::thread::hardware_concurrency();
+#ifdef NDEBUG
+	json["build"] = "release";
+#else
+	json["build"] = "debug";
+#endif
+	json["results"] = this->results;
+
+	auto file = ofFile(filePath, ofFile::WriteOnly);
+	file << json.dump(4);
+
+	ofLogNotice("Benchmark") << "Wrote " << this->results.size() << " results to " << filePath;
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkHomography()
+{
+	static const size_t numQuads = 1000;
+
+	for (auto canvas : { glm::vec2(1920.0f, 1080.0f), glm::vec2(16384.0f, 9216.0f), glm::vec2(32768.0f, 18432.0f) })
+	{
+		std::vector<glm::vec2> srcQuads(numQuads * 4);
+		std::vector<glm::vec2> dstQuads(numQuads * 4);
+		std::vector<glm::dvec2> srcQuadsD(numQuads * 4);
+		std::vector<glm::dvec2> dstQuadsD(numQuads * 4);
+		for (size_t i = 0; i < numQuads; ++i)
+		{
+			srcQuads[i * 4 + 0] = glm::vec2(0.0f, 0.0f);
+			srcQuads[i * 4 + 1] = glm::vec2(canvas.x, 0.0f);
+			srcQuads[i * 4 + 2] = glm::vec2(canvas.x, canvas.y);
+			srcQuads[i * 4 + 3] = glm::vec2(0.0f, canvas.y);
+			randomQuad(canvas, &dstQuads[i * 4]);
+		}
+		for (size_t i = 0; i < srcQuads.size(); ++i)
+		{
+			srcQuadsD[i] = glm::dvec2(srcQuads[i]);
+			dstQuadsD[i] = glm::dvec2(dstQuads[i]);
+		}
+
+		auto label = ofToString(canvas.x, 0) + "x" + ofToString(canvas.y, 0);
+
+		// Accuracy: maximum distance between the mapped and expected corners, and after a round trip through the inverse.
+		auto errorElimination = 0.0;
+		auto errorEliminationInverse = 0.0;
+		auto errorClosedForm = 0.0;
+		auto errorClosedFormInverse = 0.0;
+		for (size_t i = 0; i < numQuads; ++i)
+		{
+			auto src = &srcQuads[i * 4];
+			auto dst = &dstQuads[i * 4];
+
+			auto transform = getPerspectiveTransform(src, dst);
+			auto transformInverted = glm::inverse(transform);
+
+			auto homography = ofxWarp::Homography::quadToQuad(&srcQuadsD[i * 4], &dstQuadsD[i * 4]);
+			auto homographyInverted = ofxWarp::Homography::invert(homography);
+
+			for (int j = 0; j < 4; ++j)
+			{
+				errorElimination = MAX(errorElimination, glm::distance(transformPoint(transform, src[j]), glm::dvec2(dst[j])));
+				errorEliminationInverse = MAX(errorEliminationInverse, glm::distance(transformPoint(transformInverted, dst[j]), glm::dvec2(src[j])));
+
+				errorClosedForm = MAX(errorClosedForm, glm::distance(ofxWarp::Homography::transform(homography, srcQuadsD[i * 4 + j]), dstQuadsD[i * 4 + j]));
+				errorClosedFormInverse = MAX(errorClosedFormInverse, glm::distance(ofxWarp::Homography::transform(homographyInverted, dstQuadsD[i * 4 + j]), srcQuadsD[i * 4 + j]));
+			}
+		}
+		ofLogNotice("Benchmark") << "Homography " << label << " max error, elimination: " << errorElimination << " px (inverse " << errorEliminationInverse << " px), closed form: " << errorClosedForm << " px (inverse " << errorClosedFormInverse << " px)";
+
+		// Throughput.
+		this->measure("Homography " + label + " elimination + inverse", 100, [&]()
+		{
+			for (size_t i = 0; i < numQuads; ++i)
+			{
+				auto transform = getPerspectiveTransform(&srcQuads[i * 4], &dstQuads[i * 4]);
+				this->sink += glm::inverse(transform)[0][0];
+			}
+		});
+
+		this->measure("Homography " + label + " closed form + inverse", 100, [&]()
+		{
+			for (size_t i = 0; i < numQuads; ++i)
+			{
+				auto homography = ofxWarp::Homography::quadToQuad(&srcQuadsD[i * 4], &dstQuadsD[i * 4]);
+				this->sink += ofxWarp::Homography::invert(homography)[0][0];
+			}
+		});
+
+		std::vector<glm::dmat3> transforms(numQuads);
+		std::vector<glm::dmat3> inverses(numQuads);
+		this->measure("Homography " + label + " closed form batch", 100, [&]()
+		{
+			ofxWarp::Homography::quadToQuad(srcQuadsD.data(), dstQuadsD.data(), numQuads, transforms.data(), inverses.data());
+			this->sink += inverses[0][0][0];
+		});
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkInverseMapping()
+{
+	static const size_t numPoints = 10000;
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	auto warpBilinear = std::make_shared<ofxWarpBilinear>();
+	warpBilinear->setNumControlsX(9);
+	warpBilinear->setNumControlsY(9);
+	auto warpLinear = std::make_shared<ofxWarpBilinear>();
+	warpLinear->setNumControlsX(9);
+	warpLinear->setNumControlsY(9);
+	warpLinear->setLinear(true);
+	auto warpPerspective = std::make_shared<ofxWarpPerspective>();
+	auto warpPerspectiveBilinear = std::make_shared<ofxWarpPerspectiveBilinear>();
+	warpPerspectiveBilinear->setNumControlsX(5);
+	warpPerspectiveBilinear->setNumControlsY(5);
+
+	std::vector<std::pair<std::string, std::shared_ptr<ofxWarp::WarpBase>>> warps = 
+	{
+		{ "bilinear 9x9", warpBilinear },
+		{ "linear 9x9", warpLinear },
+		{ "perspective", warpPerspective },
+		{ "perspective bilinear 5x5", warpPerspectiveBilinear }
+	};
+
+	for (auto & entry : warps)
+	{
+		auto warp = entry.second;
+		warp->handleWindowResize(windowSize.x, windowSize.y);
+		warp->setSize(windowSize);
+
+		// Distort the warp without folding it over itself.
+		for (size_t i = 0; i < warp->getNumControlPoints(); ++i)
+		{
+			warp->setControlPoint(i, warp->getControlPoint(i) * 0.8f + 0.1f + glm::vec2(ofRandom(-0.02f, 0.02f), ofRandom(-0.02f, 0.02f)));
+		}
+
+		std::vector<glm::vec2> content(numPoints);
+		for (auto & pt : content)
+		{
+			pt = glm::vec2(ofRandom(windowSize.x), ofRandom(windowSize.y));
+		}
+		std::vector<glm::vec2> screen(numPoints);
+		std::vector<glm::vec2> roundTrip(numPoints);
+		auto valid = std::unique_ptr<bool[]>(new bool[numPoints]);
+
+		// Accuracy: round trip from content to screen and back.
+		warp->mapContentToScreen(content.data(), screen.data(), numPoints);
+		auto numCovered = warp->mapScreenToContent(screen.data(), roundTrip.data(), valid.get(), numPoints);
+		auto maxError = 0.0f;
+		for (size_t i = 0; i < numPoints; ++i)
+		{
+			if (valid[i])
+			{
+				maxError = MAX(maxError, glm::distance(content[i], roundTrip[i]));
+			}
+		}
+		ofLogNotice("Benchmark") << "Inverse mapping " << entry.first << " round trip: " << numCovered << " / " << numPoints << " covered, max error " << maxError << " px";
+
+		// Throughput.
+		this->measure("Inverse mapping " + entry.first + " content to screen x" + ofToString(numPoints), 100, [&]()
+		{
+			warp->mapContentToScreen(content.data(), screen.data(), numPoints);
+			this->sink += screen[0].x;
+		});
+		this->measure("Inverse mapping " + entry.first + " screen to content x" + ofToString(numPoints), 100, [&]()
+		{
+			this->sink += warp->mapScreenToContent(screen.data(), roundTrip.data(), nullptr, numPoints);
+		});
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkWarpIndex()
+{
+	static const size_t numPoints = 256;
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	for (auto numWarps : { 16, 128, 512 })
+	{
+		// Small overlapping warps of all types scattered over the window.
+		ofxWarpController controller;
+		for (auto i = 0; i < numWarps; ++i)
+		{
+			auto warp = ofxWarpController::makeWarp((ofxWarp::WarpBase::Type)(ofxWarp::WarpBase::TYPE_BILINEAR + i % 3));
+			warp->handleWindowResize(windowSize.x, windowSize.y);
+			warp->setSize(windowSize);
+			auto scale = glm::vec2(ofRandom(0.05f, 0.2f), ofRandom(0.05f, 0.2f));
+			warp->reset(scale, glm::vec2(ofRandom(1.0f - scale.x), ofRandom(1.0f - scale.y)));
+			controller.addWarp(warp);
+		}
+
+		std::vector<glm::vec2> points(numPoints);
+		for (auto & pt : points)
+		{
+			pt = glm::vec2(ofRandom(windowSize.x), ofRandom(windowSize.y));
+		}
+		std::vector<ofxWarp::WarpIndex::Hit> hits(numPoints);
+
+		// Reference: test every warp from the top down.
+		auto findLinear = [&](const glm::vec2 & pos, ofxWarp::WarpIndex::Hit & hit)
+		{
+			for (int i = controller.getNumWarps() - 1; i >= 0; --i)
+			{
+				if (controller.getWarp(i)->mapScreenToContent(pos, hit.content))
+				{
+					hit.warpIndex = i;
+					return true;
+				}
+			}
+			return false;
+		};
+
+		// Accuracy: the hierarchy must agree with the reference.
+		size_t numFound = controller.findWarpAt(points.data(), hits.data(), numPoints);
+		size_t numMismatches = 0;
+		for (size_t i = 0; i < numPoints; ++i)
+		{
+			ofxWarp::WarpIndex::Hit hit;
+			findLinear(points[i], hit);
+			if (hit.warpIndex != hits[i].warpIndex)
+			{
+				++numMismatches;
+			}
+		}
+		auto label = ofToString(numWarps) + " warps";
+		ofLogNotice("Benchmark") << "Warp index " << label << ": " << numFound << " / " << numPoints << " points covered, " << numMismatches << " mismatches";
+
+		// Throughput.
+		this->measure("Warp index " + label + " linear x" + ofToString(numPoints), 100, [&]()
+		{
+			for (size_t i = 0; i < numPoints; ++i)
+			{
+				ofxWarp::WarpIndex::Hit hit;
+				this->sink += findLinear(points[i], hit);
+			}
+		});
+		this->measure("Warp index " + label + " hierarchy x" + ofToString(numPoints), 100, [&]()
+		{
+			this->sink += controller.findWarpAt(points.data(), hits.data(), numPoints);
+		});
+		this->measure("Warp index " + label + " move one warp and refit", 100, [&]()
+		{
+			auto warp = controller.getWarp(ofRandom(numWarps));
+			warp->moveControlPoint(0, glm::vec2(ofRandom(-0.01f, 0.01f), ofRandom(-0.01f, 0.01f)));
+			this->sink += controller.findWarpAt(points[0], hits[0]);
+		});
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkSoftwareRenderer()
+{
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	// Gradient content with some high frequency detail.
+	ofPixels source;
+	source.allocate(windowSize.x, windowSize.y, OF_PIXELS_RGBA);
+	for (size_t y = 0; y < source.getHeight(); ++y)
+	{
+		for (size_t x = 0; x < source.getWidth(); ++x)
+		{
+			source.setColor(x, y, ofColor(x * 255 / source.getWidth(), y * 255 / source.getHeight(), ((x / 8 + y / 8) % 2) * 255, 255));
+		}
+	}
+
+	ofxWarp::SoftwareRenderer renderer;
+
+	// Accuracy: an undistorted warp without blending must reproduce the source.
+	{
+		auto warp = std::make_shared<ofxWarpPerspective>();
+		warp->handleWindowResize(windowSize.x, windowSize.y);
+		warp->setSize(windowSize);
+
+		ofPixels target;
+		renderer.render(source, warp, target);
+
+		auto maxError = 0;
+		for (size_t i = 0; i < source.size(); ++i)
+		{
+			maxError = MAX(maxError, abs((int)source[i] - (int)target[i]));
+		}
+		ofLogNotice("Benchmark") << "Software renderer identity max error: " << maxError;
+	}
+
+	auto warpBilinear = std::make_shared<ofxWarpBilinear>();
+	warpBilinear->setNumControlsX(5);
+	warpBilinear->setNumControlsY(5);
+	auto warpPerspective = std::make_shared<ofxWarpPerspective>();
+	auto warpPerspectiveBilinear = std::make_shared<ofxWarpPerspectiveBilinear>();
+	warpPerspectiveBilinear->setNumControlsX(5);
+	warpPerspectiveBilinear->setNumControlsY(5);
+
+	std::vector<std::pair<std::string, std::shared_ptr<ofxWarp::WarpBase>>> warps =
+	{
+		{ "bilinear 5x5", warpBilinear },
+		{ "perspective", warpPerspective },
+		{ "perspective bilinear 5x5", warpPerspectiveBilinear }
+	};
+
+	auto maxThreads = MAX(1u, std::thread::hardware_concurrency());
+	for (auto & entry : warps)
+	{
+		auto warp = entry.second;
+		warp->handleWindowResize(windowSize.x, windowSize.y);
+		warp->setSize(windowSize);
+		warp->setEdges(glm::vec4(0.2f, 0.0f, 0.2f, 0.0f));
+		for (size_t i = 0; i < warp->getNumControlPoints(); ++i)
+		{
+			warp->setControlPoint(i, warp->getControlPoint(i) * 0.8f + 0.1f + glm::vec2(ofRandom(-0.02f, 0.02f), ofRandom(-0.02f, 0.02f)));
+		}
+
+		// Throughput, from a single thread up to all cores.
+		ofPixels target;
+		for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+		{
+			renderer.setNumThreads(numThreads);
+			this->measure("Software renderer " + entry.first + " 1920x1080 " + ofToString(numThreads) + " threads", 20, [&]()
+			{
+				renderer.render(source, warp, target);
+				this->sink += target[0];
+			});
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkMesh()
+{
+	for (auto windowSize : { glm::vec2(1920.0f, 1080.0f), glm::vec2(3840.0f, 2160.0f) })
+	{
+		for (auto numControls : { 2, 5, 17, 128 })
+		{
+			for (auto linear : { true, false })
+			{
+				BenchmarkWarpBilinear warp;
+				warp.handleWindowResize(windowSize.x, windowSize.y);
+				warp.setSize(windowSize.x, windowSize.y);
+				warp.setNumControlsX(numControls);
+				warp.setNumControlsY(numControls);
+				warp.setLinear(linear);
+				warp.runSetupMesh();
+
+				auto label = std::string(linear ? "linear " : "curved ") + ofToString(windowSize.x, 0) + "x" + ofToString(windowSize.y, 0) + " " + ofToString(numControls) + "x" + ofToString(numControls) + " (" + ofToString(warp.getNumVertices()) + " vertices)";
+				this->measure("WarpBilinear::updateMesh " + label, 100, [&]()
+				{
+					warp.runUpdateMesh();
+				});
+
+				// Only depends on the mesh resolution, not on the interpolation.
+				if (linear)
+				{
+					this->measure("WarpBilinear::setupMesh " + label, 100, [&]()
+					{
+						warp.runSetupMesh();
+					});
+				}
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkFixedGrids()
+{
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	std::vector<glm::vec3> genericVertices;
+	std::vector<glm::vec3> fixedVertices;
+	for (auto numControls : { 2, 3, 5, 9 })
+	{
+		for (auto linear : { true, false })
+		{
+			BenchmarkWarpBilinear warp;
+			warp.handleWindowResize(windowSize.x, windowSize.y);
+			warp.setSize(windowSize.x, windowSize.y);
+			warp.setNumControlsX(numControls);
+			warp.setNumControlsY(numControls);
+			warp.setLinear(linear);
+			warp.runSetupMesh();
+
+			// Jitter the grid so that the extrapolated edges are not trivial.
+			auto controlPoints = warp.getControlPoints();
+			for (auto & pt : controlPoints)
+			{
+				pt += glm::vec2(ofRandom(-0.02f, 0.02f), ofRandom(-0.02f, 0.02f));
+			}
+			warp.setControlPoints(controlPoints);
+
+			auto label = std::string(linear ? "linear " : "curved ") + ofToString(numControls) + "x" + ofToString(numControls) + " (" + ofToString(warp.getNumVertices()) + " vertices)";
+			this->measure("WarpBilinear mesh generic " + label, 100, [&]()
+			{
+				warp.runMeshGeneric(genericVertices);
+			});
+			this->measure("WarpBilinear mesh fixed " + label, 100, [&]()
+			{
+				warp.runMeshFixed(fixedVertices);
+			});
+
+			// Both paths share their arithmetic, so the vertices should match exactly.
+			if (genericVertices != fixedVertices)
+			{
+				ofLogError("ofApp::benchmarkFixedGrids") << "Fixed kernel differs from the generic path for " << label;
+				this->failed = true;
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkBlendCurve()
+{
+	static const size_t lutSize = BenchmarkWarpBilinear::BLEND_LUT_SIZE;
+	static const size_t numSamples = 65536;
+
+	// The error documented at WarpBase::setBlendLutEnabled(), the first texel covers the steep start of curves with gamma above 1.
+	static const double maxFirstTexelError = 12.0 / 255.0;
+	static const double maxLutError = 1.5 / 255.0;
+	static const double maxCurveError = 1e-5;
+
+	std::vector<float> lut(lutSize * 3);
+	this->measure("Blend curve bake", 1000, [&]()
+	{
+		ofxWarp::WarpBase::bakeBlendCurve(lut.data(), lutSize, glm::vec3(0.5f), 2.0f, glm::vec3(2.2f));
+	});
+
+	// Sweep the range documented for the LUT, one setting per channel, against the shader formula in double precision.
+	double worstFirstTexelError = 0.0;
+	double worstLutError = 0.0;
+	double worstCurveError = 0.0;
+	for (auto luminance : { glm::vec3(0.2f, 0.5f, 0.8f), glm::vec3(0.3f, 0.4f, 0.7f) })
+	{
+		for (auto exponent : { 1.0f, 1.5f, 2.0f, 3.0f, 4.0f })
+		{
+			for (auto gamma : { glm::vec3(0.8f, 1.0f, 1.8f), glm::vec3(2.2f, 2.5f, 1.0f) })
+			{
+				ofxWarp::WarpBase::bakeBlendCurve(lut.data(), lutSize, luminance, exponent, gamma);
+
+				for (size_t c = 0; c < 3; ++c)
+				{
+					double firstTexelError = 0.0;
+					double lutError = 0.0;
+					double curveError = 0.0;
+					double lutErrorAt = 0.0;
+					for (size_t i = 0; i <= numSamples; ++i)
+					{
+						auto a = i / double(numSamples);
+						auto expected = evaluateBlendCurveReference(a, luminance[c], exponent, gamma[c]);
+
+						auto error = fabs(sampleBlendLut(lut, lutSize, c, a) - expected);
+						if (a * (lutSize - 1) < 1.0)
+						{
+							firstTexelError = MAX(firstTexelError, error);
+						}
+						else if (error > lutError)
+						{
+							lutError = error;
+							lutErrorAt = a;
+						}
+
+						curveError = MAX(curveError, fabs(ofxWarp::WarpBase::evaluateBlendCurve(a, luminance, exponent, gamma)[c] - expected));
+					}
+
+					worstFirstTexelError = MAX(worstFirstTexelError, firstTexelError);
+					worstLutError = MAX(worstLutError, lutError);
+					worstCurveError = MAX(worstCurveError, curveError);
+
+					auto label = "luminance " + ofToString(luminance[c]) + ", exponent " + ofToString(exponent) + ", gamma " + ofToString(gamma[c]);
+					if (firstTexelError > maxFirstTexelError || lutError > maxLutError)
+					{
+						ofLogError("ofApp::benchmarkBlendCurve") << "Blend LUT is off by " << ofToString(firstTexelError * 255.0, 2) << " / 255 in the first texel and " << ofToString(lutError * 255.0, 2) << " / 255 at " << ofToString(lutErrorAt, 4) << " for " << label;
+						this->failed = true;
+					}
+					if (curveError > maxCurveError)
+					{
+						ofLogError("ofApp::benchmarkBlendCurve") << "Blend curve is off by " << curveError << " for " << label;
+						this->failed = true;
+					}
+				}
+			}
+		}
+	}
+
+	ofLogNotice("Benchmark") << "Blend LUT max error: " << ofToString(worstFirstTexelError * 255.0, 2) << " / 255 in the first texel, " << ofToString(worstLutError * 255.0, 2) << " / 255 elsewhere, curve max error " << worstCurveError;
+
+	nlohmann::json result;
+	result["name"] = "Blend curve error";
+	result["max_first_texel_error"] = worstFirstTexelError;
+	result["max_lut_error"] = worstLutError;
+	result["max_curve_error"] = worstCurveError;
+	this->results.push_back(result);
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkGridFitter()
+{
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+	static const size_t numControls = 64;
+	static const size_t numSamples = 100000;
+
+	// A 64x64 grid from 100k samples should fit in well under a second.
+	static const double maxFitTime = 1000.0;
+	static const double maxGridError = 1e-4;
+
+	ofxWarp::GridFitter fitter;
+	for (auto linear : { true, false })
+	{
+		// Known grid, a smooth distortion of the regular one, and the regular grid to start the fit from.
+		std::vector<glm::vec2> knownPoints(numControls * numControls);
+		std::vector<glm::vec2> startPoints(numControls * numControls);
+		for (size_t col = 0; col < numControls; ++col)
+		{
+			for (size_t row = 0; row < numControls; ++row)
+			{
+				auto uv = glm::vec2(col, row) / float(numControls - 1);
+				knownPoints[col * numControls + row] = uv + glm::vec2(0.03f * sinf(5.0f * uv.y + 2.0f * uv.x), 0.03f * cosf(4.0f * uv.x));
+				startPoints[col * numControls + row] = uv;
+			}
+		}
+
+		// Synthetic correspondences, evaluated through the known grid with the weights of the mesh.
+		std::vector<glm::vec2> content(numSamples);
+		std::vector<glm::vec2> targets(numSamples);
+		size_t indices[ofxWarp::GridFitter::MAX_WEIGHTS];
+		double weights[ofxWarp::GridFitter::MAX_WEIGHTS];
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			content[i] = glm::vec2(ofRandom(1.0f), ofRandom(1.0f));
+
+			auto count = ofxWarp::GridFitter::getWeights(numControls, numControls, linear, content[i], indices, weights);
+			glm::dvec2 target(0.0);
+			for (size_t j = 0; j < count; ++j)
+			{
+				target += weights[j] * glm::dvec2(knownPoints[indices[j]]);
+			}
+			targets[i] = glm::vec2(target);
+		}
+
+		auto label = std::string(linear ? "linear " : "curved ") + ofToString(numControls) + "x" + ofToString(numControls) + " from " + ofToString(numSamples) + " samples";
+
+		std::vector<glm::vec2> controlPoints;
+		ofxWarp::GridFitter::Result fitResult;
+		auto converged = true;
+		this->measure("GridFitter fit " + label, 10, [&]()
+		{
+			controlPoints = startPoints;
+			converged &= fitter.fit(numControls, numControls, linear, content, targets, controlPoints, std::vector<bool>(), &fitResult) && fitResult.converged;
+		});
+		auto fitTime = this->results.back()["ns_per_op"].get<double>() * 1e-6;
+
+		float gridError = 0.0f;
+		for (size_t i = 0; i < controlPoints.size(); ++i)
+		{
+			gridError = MAX(gridError, glm::distance(controlPoints[i], knownPoints[i]));
+		}
+
+		ofLogNotice("Benchmark") << "GridFitter " << label << ": assemble " << ofToString(fitResult.assembleTime, 1) << " ms, solve " << ofToString(fitResult.solveTime, 1) << " ms in " << fitResult.numIterations << " iterations, "
+			<< "rms residual " << fitResult.rmsError << ", max residual " << fitResult.maxError << ", recovered grid error " << gridError << " (" << ofToString(gridError * windowSize.x, 4) << " px at " << windowSize.x << " px)";
+
+		auto & result = this->results.back();
+		result["assemble_ms"] = fitResult.assembleTime;
+		result["solve_ms"] = fitResult.solveTime;
+		result["iterations"] = fitResult.numIterations;
+		result["rms_residual"] = fitResult.rmsError;
+		result["max_residual"] = fitResult.maxError;
+		result["max_grid_error"] = gridError;
+
+		if (!converged || gridError > maxGridError)
+		{
+			ofLogError("ofApp::benchmarkGridFitter") << "Fit did not recover the known grid for " << label;
+			this->failed = true;
+		}
+		if (fitTime > maxFitTime)
+		{
+#ifdef NDEBUG
+			ofLogError("ofApp::benchmarkGridFitter") << "Fit took " << ofToString(fitTime, 1) << " ms for " << label;
+			this->failed = true;
+#else
+			ofLogWarning("ofApp::benchmarkGridFitter") << "Fit took " << ofToString(fitTime, 1) << " ms for " << label << " in a debug build";
+#endif
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkControlPoints()
+{
+	static const size_t numPoints = 1000;
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	std::vector<glm::vec2> points(numPoints);
+	for (auto & pt : points)
+	{
+		pt = glm::vec2(ofRandom(windowSize.x), ofRandom(windowSize.y));
+	}
+
+	for (auto numControls : { 5, 17, 33 })
+	{
+		auto label = ofToString(numControls) + "x" + ofToString(numControls);
+
+		ofxWarpBilinear warp;
+		warp.handleWindowResize(windowSize.x, windowSize.y);
+		warp.setSize(windowSize.x, windowSize.y);
+		warp.setNumControlsX(numControls);
+		warp.setNumControlsY(numControls);
+
+		// Alternate between two sizes, so that every call resamples the grid.
+		auto toggle = false;
+		this->measure("WarpBilinear::setNumControlsX " + label, 100, [&]()
+		{
+			toggle = !toggle;
+			warp.setNumControlsX(numControls + (toggle ? 1 : 0));
+		});
+		warp.setNumControlsX(numControls);
+		this->measure("WarpBilinear::setNumControlsY " + label, 100, [&]()
+		{
+			toggle = !toggle;
+			warp.setNumControlsY(numControls + (toggle ? 1 : 0));
+		});
+		warp.setNumControlsY(numControls);
+
+		this->measure("WarpBase::findClosestControlPoint " + label + " x" + ofToString(numPoints), 100, [&]()
+		{
+			float distance;
+			for (const auto & pt : points)
+			{
+				this->sink += warp.findClosestControlPoint(pt, &distance);
+			}
+		});
+	}
+
+	for (auto numWarps : { 4, 16, 64 })
+	{
+		BenchmarkController controller;
+		for (auto i = 0; i < numWarps; ++i)
+		{
+			auto warp = controller.buildWarp<ofxWarpBilinear>();
+			warp->handleWindowResize(windowSize.x, windowSize.y);
+			warp->setSize(windowSize.x, windowSize.y);
+			warp->setNumControlsX(17);
+			warp->setNumControlsY(17);
+			auto scale = glm::vec2(ofRandom(0.2f, 0.5f), ofRandom(0.2f, 0.5f));
+			warp->reset(scale, glm::vec2(ofRandom(1.0f - scale.x), ofRandom(1.0f - scale.y)));
+			warp->setEditing(true);
+		}
+
+		this->measure("Controller::selectClosestControlPoint " + ofToString(numWarps) + " warps 17x17 x" + ofToString(numPoints), 100, [&]()
+		{
+			for (const auto & pt : points)
+			{
+				controller.selectClosestControlPoint(pt);
+			}
+		});
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkPerspective()
+{
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	ofxWarpPerspective warp;
+	warp.handleWindowResize(windowSize.x, windowSize.y);
+	warp.setSize(windowSize);
+
+	// Moving a corner invalidates the transform, the next call recomputes it.
+	size_t index = 0;
+	this->measure("WarpPerspective::getTransform after moving a corner", 1000, [&]()
+	{
+		warp.setControlPoint(index, glm::vec2(ofRandom(1.0f), ofRandom(1.0f)));
+		index = (index + 1) % 4;
+		this->sink += warp.getTransform()[0][0];
+	});
+	this->measure("WarpPerspective::getTransform cached", 1000, [&]()
+	{
+		this->sink += warp.getTransform()[0][0];
+	});
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkClip()
+{
+	static const size_t numRects = 1000;
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	ofxWarpPerspective warp;
+	warp.handleWindowResize(windowSize.x, windowSize.y);
+	warp.setSize(windowSize);
+
+	// Source and destination rectangles reaching past the content on any side.
+	std::vector<ofRectangle> srcRects(numRects);
+	std::vector<ofRectangle> dstRects(numRects);
+	for (size_t i = 0; i < numRects; ++i)
+	{
+		srcRects[i] = ofRectangle(ofRandom(-200.0f, windowSize.x), ofRandom(-200.0f, windowSize.y), ofRandom(100.0f, windowSize.x), ofRandom(100.0f, windowSize.y));
+		dstRects[i] = ofRectangle(ofRandom(-200.0f, windowSize.x), ofRandom(-200.0f, windowSize.y), ofRandom(100.0f, windowSize.x), ofRandom(100.0f, windowSize.y));
+	}
+
+	this->measure("WarpBase::clip x" + ofToString(numRects), 100, [&]()
+	{
+		for (size_t i = 0; i < numRects; ++i)
+		{
+			auto srcBounds = srcRects[i];
+			auto dstBounds = dstRects[i];
+			this->sink += warp.clip(srcBounds, dstBounds);
+		}
+	});
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkSerialization()
+{
+	static const auto windowSize = glm::vec2(1920.0f, 1080.0f);
+
+	for (auto numWarps : { 8, 64 })
+	{
+		for (auto numControls : { 5, 33 })
+		{
+			// Bilinear warps dominate the size of the settings, so only use those.
+			ofxWarpController controller;
+			for (auto i = 0; i < numWarps; ++i)
+			{
+				auto warp = controller.buildWarp<ofxWarpBilinear>();
+				warp->handleWindowResize(windowSize.x, windowSize.y);
+				warp->setSize(windowSize.x, windowSize.y);
+				warp->setNumControlsX(numControls);
+				warp->setNumControlsY(numControls);
+				for (size_t j = 0; j < warp->getNumControlPoints(); ++j)
+				{
+					warp->setControlPoint(j, warp->getControlPoint(j) + glm::vec2(ofRandom(-0.01f, 0.01f), ofRandom(-0.01f, 0.01f)));
+				}
+			}
+
+			nlohmann::json json;
+			controller.serialize(json);
+			auto text = json.dump(4);
+
+			auto label = ofToString(numWarps) + " warps " + ofToString(numControls) + "x" + ofToString(numControls) + " (" + ofToString(text.size() / 1024) + " KB)";
+			this->measure("Controller::serialize " + label, 20, [&]()
+			{
+				nlohmann::json json;
+				controller.serialize(json);
+				this->sink += json.dump(4).size();
+			});
+			this->measure("Controller::deserialize " + label, 20, [&]()
+			{
+				controller.deserialize(nlohmann::json::parse(text));
+				this->sink += controller.getNumWarps();
+			});
+		}
+	}
+}
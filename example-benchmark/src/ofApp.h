@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxWarp.h"
+
+class ofApp
+	: public ofBaseApp
+{
+public:
+	void setup();
+	void draw();
+
+protected:
+	//! run the function for the number of iterations in a few samples, log the median time per iteration and record it in the results
+	template<typename Func>
+	void measure(const std::string & name, size_t iterations, Func func)
+	{
+		static const size_t numSamples = 5;
+
+		// Warm up.
+		func();
+
+		auto iterationsPerSample = MAX(iterations / numSamples, (size_t)1);
+		std::vector<double> samples(numSamples);
+		for (auto & sample : samples)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < iterationsPerSample; ++i)
+			{
+				func();
+			}
+			sample = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / iterationsPerSample;
+		}
+		std::sort(samples.begin(), samples.end());
+		auto median = samples[numSamples / 2];
+
+		ofLogNotice("Benchmark") << name << ": " << ofToString(median, 1) << " ns/op (" << iterationsPerSample * numSamples << " iterations)";
+
+		nlohmann::json result;
+		result["name"] = name;
+		result["ns_per_op"] = median;
+		result["min_ns_per_op"] = samples.front();
+		result["max_ns_per_op"] = samples.back();
+		result["iterations"] = iterationsPerSample * numSamples;
+		this->results.push_back(result);
+	}
+
+	//! write the results as json, so that runs can be compared over time
+	void saveResults(const std::string & filePath);
+
+	void benchmarkHomography();
+	void benchmarkInverseMapping();
+	void benchmarkWarpIndex();
+	void benchmarkSoftwareRenderer();
+	void benchmarkMesh();
+	void benchmarkFixedGrids();
+	void benchmarkBlendCurve();
+	void benchmarkGridFitter();
+	void benchmarkControlPoints();
+	void benchmarkPerspective();
+	void benchmarkClip();
+	void benchmarkSerialization();
+
+	std::vector<nlohmann::json> results;
+
+	double sink;
+	//! set when a correctness check fails, the app then exits with a non-zero status
+	bool failed;
+};
@@ -0,0 +1,181 @@
+#include "ofApp.h"
+
+static const std::string kChannelName = "ofxWarp-calibration";
+static const std::string kStressChannelName = "ofxWarp-calibration-stress";
+static const size_t kNumControlsX = 5;
+static const size_t kNumControlsY = 5;
+
+//--------------------------------------------------------------
+void ofApp::setup()
+{
+	ofSetLogLevel(OF_LOG_NOTICE);
+	ofDisableArbTex();
+	ofBackground(ofColor::black);
+
+	// Share the shaders of the main example.
+	ofxWarp::WarpBase::setShaderPath(std::filesystem::path("..") / ".." / ".." / "example" / "bin" / "data" / "shaders" / "ofxWarp");
+
+	// Checkerboard content.
+	ofPixels pixels;
+	pixels.allocate(512, 512, OF_PIXELS_RGB);
+	for (auto y = 0; y < pixels.getHeight(); ++y)
+	{
+		for (auto x = 0; x < pixels.getWidth(); ++x)
+		{
+			pixels.setColor(x, y, ((x / 32 + y / 32) % 2) ? ofColor::white : ofColor::darkSlateGray);
+		}
+	}
+	this->texture.loadData(pixels);
+
+	// The solver side owns the channel, in practice this lives in another process.
+	this->producerChannel = std::make_shared<ofxWarp::CalibrationChannel>();
+	if (!this->producerChannel->create(kChannelName, kNumControlsX * kNumControlsY))
+	{
+		ofLogError("ofApp::setup") << "Could not create calibration channel!";
+		return;
+	}
+	this->producerRunning = true;
+	this->producerThread = std::thread(&ofApp::runProducer, this);
+
+	// The warp maps the same channel by name.
+	this->consumerChannel = std::make_shared<ofxWarp::CalibrationChannel>();
+	this->consumerChannel->open(kChannelName);
+
+	auto warp = this->warpController.buildWarp<ofxWarpBilinear>();
+	warp->setSize(this->texture.getWidth(), this->texture.getHeight());
+	warp->setCalibrationChannel(this->consumerChannel);
+}
+
+//--------------------------------------------------------------
+void ofApp::exit()
+{
+	this->producerRunning = false;
+	if (this->producerThread.joinable())
+	{
+		this->producerThread.join();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::update()
+{
+	ofSetWindowTitle(ofToString(ofGetFrameRate(), 2) + " FPS");
+}
+
+//--------------------------------------------------------------
+void ofApp::draw()
+{
+	for (auto warp : this->warpController.getWarps())
+	{
+		warp->draw(this->texture);
+	}
+
+	std::ostringstream oss;
+	oss << ofToString(ofGetFrameRate(), 2) << " fps" << endl;
+	oss << "calibration frame: " << (this->consumerChannel ? this->consumerChannel->getLatestFrame() : 0) << endl;
+	oss << "[s]tress test: " << (this->stressResult.empty() ? "not run" : this->stressResult);
+	ofSetColor(ofColor::white);
+	ofDrawBitmapStringHighlight(oss.str(), 10, 20);
+}
+
+//--------------------------------------------------------------
+void ofApp::keyPressed(int key)
+{
+	if (key == 's')
+	{
+		this->runStressTest();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::runProducer()
+{
+	std::vector<glm::vec2> points(kNumControlsX * kNumControlsY);
+	auto start = std::chrono::steady_clock::now();
+	while (this->producerRunning)
+	{
+		auto time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+		// Column major, like the warps.
+		for (size_t x = 0; x < kNumControlsX; ++x)
+		{
+			for (size_t y = 0; y < kNumControlsY; ++y)
+			{
+				auto u = x / (float)(kNumControlsX - 1);
+				auto v = y / (float)(kNumControlsY - 1);
+				auto wave = 0.02f * sinf(time * 2.0f + u * 6.0f + v * 3.0f);
+				points[x * kNumControlsY + y] = glm::vec2(0.1f + 0.8f * u + wave, 0.1f + 0.8f * v - wave);
+			}
+		}
+		this->producerChannel->write(kNumControlsX, kNumControlsY, points.data());
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(33));
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::runStressTest()
+{
+	static const size_t maxControlPoints = 64 * 64;
+	static const auto duration = std::chrono::seconds(5);
+
+	ofxWarp::CalibrationChannel writer;
+	ofxWarp::CalibrationChannel reader;
+	if (!writer.create(kStressChannelName, maxControlPoints) || !reader.open(kStressChannelName))
+	{
+		this->stressResult = "could not create channel";
+		return;
+	}
+
+	// Every point of a frame holds the frame number and the grid size, so any mix of two frames is detected.
+	std::atomic<bool> running(true);
+	std::thread writerThread([&]()
+	{
+		std::vector<glm::vec2> points(maxControlPoints);
+		uint32_t frame = 0;
+		while (running)
+		{
+			++frame;
+			auto numControlsX = 2 + frame % 63;
+			auto numControlsY = 2 + (frame / 63) % 63;
+			auto value = glm::vec2(frame % 1000000, numControlsX * numControlsY);
+			std::fill(points.begin(), points.begin() + numControlsX * numControlsY, value);
+			writer.write(numControlsX, numControlsY, points.data());
+		}
+	});
+
+	size_t numReads = 0;
+	size_t numTorn = 0;
+	uint64_t frame = 0;
+	size_t numControlsX;
+	size_t numControlsY;
+	std::vector<glm::vec2> points;
+	auto start = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < duration)
+	{
+		auto previousFrame = frame;
+		if (!reader.read(frame, numControlsX, numControlsY, points)) continue;
+
+		++numReads;
+		auto expected = glm::vec2(frame % 1000000, numControlsX * numControlsY);
+		auto torn = (frame <= previousFrame || points.size() != numControlsX * numControlsY);
+		for (const auto & point : points)
+		{
+			torn |= (point != expected);
+		}
+		if (torn) ++numTorn;
+	}
+
+	running = false;
+	writerThread.join();
+
+	this->stressResult = ofToString(writer.getLatestFrame()) + " frames written, " + ofToString(numReads) + " read, " + ofToString(reader.getNumRetries()) + " retries, " + ofToString(numTorn) + " torn";
+	if (numTorn > 0)
+	{
+		ofLogError("ofApp::runStressTest") << this->stressResult;
+	}
+	else
+	{
+		ofLogNotice("ofApp::runStressTest") << this->stressResult;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxWarp.h"
+
+//! feeds a bilinear warp from a shared memory calibration channel, with a stand-in for the external solver
+class ofApp
+	: public ofBaseApp
+{
+public:
+	void setup();
+	void exit();
+
+	void update();
+	void draw();
+
+	void keyPressed(int key);
+
+protected:
+	//! write an animated grid at 30 Hz, like a camera based solver would
+	void runProducer();
+	//! hammer a channel from a writer thread while reading it from another one, and count torn frames
+	void runStressTest();
+
+	std::shared_ptr<ofxWarp::CalibrationChannel> producerChannel;
+	std::shared_ptr<ofxWarp::CalibrationChannel> consumerChannel;
+	std::thread producerThread;
+	std::atomic<bool> producerRunning;
+
+	ofxWarpController warpController;
+	ofTexture texture;
+
+	std::string stressResult;
+};
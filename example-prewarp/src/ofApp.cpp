@@ -0,0 +1,118 @@
+#include "ofApp.h"
+
+static const size_t kOutputWidth = 1920;
+static const size_t kOutputHeight = 1080;
+static const size_t kNumTestFrames = 120;
+
+//--------------------------------------------------------------
+void ofApp::setup()
+{
+	ofSetLogLevel(OF_LOG_NOTICE);
+	ofBackground(ofColor::black);
+
+	// Use the warps of the main example if they were saved, otherwise blend two projectors side by side.
+	if (!this->warpController.loadSettings("settings.json"))
+	{
+		auto warpLeft = this->warpController.buildWarp<ofxWarpPerspectiveBilinear>();
+		warpLeft->setEdges(glm::vec4(0.0f, 0.0f, 0.2f, 0.0f));
+		auto warpRight = this->warpController.buildWarp<ofxWarpPerspectiveBilinear>();
+		warpRight->setEdges(glm::vec4(0.2f, 0.0f, 0.0f, 0.0f));
+	}
+
+	// The output sequences are rendered at the resolution of the projectors, not of this window.
+	// Each warp shows its slice of the content, overlapping its neighbours by the blended edges.
+	auto numWarps = this->warpController.getNumWarps();
+	auto overlap = 0.1f;
+	auto sliceWidth = (1.0f + overlap * (numWarps - 1)) / numWarps;
+	for (size_t i = 0; i < numWarps; ++i)
+	{
+		this->warpController.getWarp(i)->handleWindowResize(kOutputWidth, kOutputHeight);
+		this->srcAreas.push_back(ofRectangle(i * (sliceWidth - overlap), 0.0f, sliceWidth, 1.0f));
+	}
+
+	auto inputFolder = ofToDataPath("input", true);
+	this->framePaths = ofxWarp::PrewarpPipeline::listFrames(inputFolder, "png");
+	if (this->framePaths.empty())
+	{
+		this->writeTestSequence(inputFolder, kNumTestFrames);
+		this->framePaths = ofxWarp::PrewarpPipeline::listFrames(inputFolder, "png");
+	}
+
+	// The warps are not touched by the app while the pipeline runs.
+	this->pipelineRunning = true;
+	this->pipelineResult = false;
+	this->pipelineSeconds = 0.0f;
+	this->pipelineThread = std::thread([this]()
+	{
+		auto start = std::chrono::steady_clock::now();
+		this->pipelineResult = this->pipeline.run(this->framePaths, this->warpController.getWarps(), this->srcAreas, ofToDataPath("output", true));
+		this->pipelineSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+		this->pipelineRunning = false;
+	});
+}
+
+//--------------------------------------------------------------
+void ofApp::exit()
+{
+	this->pipeline.cancel();
+	if (this->pipelineThread.joinable())
+	{
+		this->pipelineThread.join();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw()
+{
+	auto numFramesDone = this->pipeline.getNumFramesDone();
+
+	// Progress bar.
+	auto progress = this->framePaths.empty() ? 0.0f : numFramesDone / (float)this->framePaths.size();
+	ofSetColor(ofColor::darkSlateGray);
+	ofDrawRectangle(10, ofGetHeight() - 30, (ofGetWidth() - 20) * progress, 20);
+
+	std::ostringstream oss;
+	oss << this->warpController.getNumWarps() << " warps at " << kOutputWidth << "x" << kOutputHeight << endl;
+	oss << "frames: " << numFramesDone << " / " << this->framePaths.size() << ", failed: " << this->pipeline.getNumFramesFailed() << endl;
+	if (this->pipelineRunning)
+	{
+		oss << "[c]ancel";
+	}
+	else
+	{
+		oss << (this->pipelineResult ? "done" : "stopped") << " in " << ofToString(this->pipelineSeconds, 1) << " s (" << ofToString(numFramesDone / MAX(this->pipelineSeconds, 0.001f), 1) << " fps)";
+	}
+	ofSetColor(ofColor::white);
+	ofDrawBitmapStringHighlight(oss.str(), 10, 20);
+}
+
+//--------------------------------------------------------------
+void ofApp::keyPressed(int key)
+{
+	if (key == 'c')
+	{
+		this->pipeline.cancel();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::writeTestSequence(const std::string & folder, size_t numFrames)
+{
+	ofDirectory::createDirectory(folder, false, true);
+
+	// A checkerboard scrolling under a frame counter.
+	ofPixels pixels;
+	pixels.allocate(kOutputWidth * 2, kOutputHeight, OF_PIXELS_RGB);
+	for (size_t i = 0; i < numFrames; ++i)
+	{
+		for (size_t y = 0; y < pixels.getHeight(); ++y)
+		{
+			for (size_t x = 0; x < pixels.getWidth(); ++x)
+			{
+				auto checker = (((x + i * 8) / 64 + y / 64) % 2) != 0;
+				pixels.setColor(x, y, checker ? ofColor::white : ofColor::fromHsb((i * 2) % 255, 200, 200));
+			}
+		}
+		ofSaveImage(pixels, ofFilePath::join(folder, "frame_" + ofToString(i, 5, '0') + ".png"));
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxWarp.h"
+
+//! pre-warps the image sequence in data/input through the warps in data/settings.json, into one sequence per warp in data/output
+class ofApp
+	: public ofBaseApp
+{
+public:
+	void setup();
+	void exit();
+
+	void draw();
+
+	void keyPressed(int key);
+
+protected:
+	//! write a short synthetic sequence to warp when there is no input
+	void writeTestSequence(const std::string & folder, size_t numFrames);
+
+	ofxWarpController warpController;
+	ofxWarp::PrewarpPipeline pipeline;
+
+	std::vector<std::string> framePaths;
+	std::vector<ofRectangle> srcAreas;
+	std::thread pipelineThread;
+	std::atomic<bool> pipelineRunning;
+	bool pipelineResult;
+	float pipelineSeconds;
+};
@@ -0,0 +1,138 @@
+#include "ofApp.h"
+
+static const std::string kHost = "127.0.0.1";
+static const int kReplyPort = ofxWarp::RemoteControl::DEFAULT_PORT + 1;
+static const size_t kMessagesPerFrame = 32;
+static const size_t kPointsPerMessage = 64;
+static const uint64_t kDuration = 10 * 1000 * 1000;
+
+//--------------------------------------------------------------
+void ofApp::setup()
+{
+	ofSetLogLevel(OF_LOG_NOTICE);
+	ofSetFrameRate(0);
+	ofSetVerticalSync(false);
+
+	this->sender.Create();
+	this->sender.Connect(kHost.c_str(), ofxWarp::RemoteControl::DEFAULT_PORT);
+	this->sender.SetNonBlocking(true);
+
+	this->receiver.Create();
+	this->receiver.Bind(kReplyPort);
+	this->receiver.SetNonBlocking(true);
+
+	this->receiveBuffer.resize(ofxWarp::RemoteControl::MAX_MESSAGE_SIZE);
+
+	this->sequence = 0;
+	this->numPointsSent = 0;
+	this->numAcks = 0;
+	this->startTime = ofGetElapsedTimeMicros();
+	this->done = false;
+}
+
+//--------------------------------------------------------------
+void ofApp::update()
+{
+	if (this->done) return;
+
+	this->receiveAcks();
+
+	if (ofGetElapsedTimeMicros() - this->startTime < kDuration)
+	{
+		this->sendMessages();
+	}
+	else if (this->sendTimes.empty() || ofGetElapsedTimeMicros() - this->startTime > kDuration + 1000 * 1000)
+	{
+		// Give the last acknowledgments a second to come back.
+		this->logResults();
+		this->done = true;
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw()
+{
+	ofBackground(ofColor::black);
+
+	auto elapsed = (ofGetElapsedTimeMicros() - this->startTime) / 1000000.0;
+	std::ostringstream oss;
+	oss << "messages sent: " << this->sequence << endl;
+	oss << "acks received: " << this->numAcks << endl;
+	oss << "points/s: " << ofToString(this->numPointsSent / MAX(elapsed, 0.001), 0) << endl;
+	oss << (this->done ? "done, see log" : "running...");
+	ofSetColor(ofColor::white);
+	ofDrawBitmapStringHighlight(oss.str(), 10, 20);
+}
+
+//--------------------------------------------------------------
+void ofApp::sendMessages()
+{
+	for (size_t i = 0; i < kMessagesPerFrame; ++i)
+	{
+		// Alternate the direction so the warp ends up where it started.
+		auto shift = glm::vec2((this->sequence % 2) ? -0.001f : 0.001f, 0.0f);
+
+		ofxWarp::RemoteControl::writeHeader(this->sendBuffer, ofxWarp::RemoteControl::OP_MOVE_POINTS, 0, this->sequence, kReplyPort);
+		for (size_t j = 0; j < kPointsPerMessage; ++j)
+		{
+			// Every warp has at least 4 control points.
+			ofxWarp::RemoteControl::writePoint(this->sendBuffer, j % 4, shift);
+		}
+
+		this->sendTimes[this->sequence] = ofGetElapsedTimeMicros();
+		if (this->sender.Send(this->sendBuffer.data(), this->sendBuffer.size()) > 0)
+		{
+			this->numPointsSent += kPointsPerMessage;
+		}
+		++this->sequence;
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::receiveAcks()
+{
+	while (true)
+	{
+		auto size = this->receiver.Receive(this->receiveBuffer.data(), this->receiveBuffer.size());
+		if (size <= 0) break;
+
+		ofxWarp::RemoteControl::Header header;
+		if (!ofxWarp::RemoteControl::readHeader(this->receiveBuffer.data(), size, header)) continue;
+		if (header.opcode != ofxWarp::RemoteControl::OP_ACK) continue;
+
+		auto it = this->sendTimes.find(header.sequence);
+		if (it == this->sendTimes.end()) continue;
+
+		this->latencies.push_back(ofGetElapsedTimeMicros() - it->second);
+		this->sendTimes.erase(it);
+		++this->numAcks;
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::logResults()
+{
+	auto elapsed = kDuration / 1000000.0;
+	ofLogNotice("Remote") << "Sent " << this->sequence << " messages, " << this->numAcks << " acknowledged, " << this->sendTimes.size() << " lost";
+	ofLogNotice("Remote") << "Throughput: " << ofToString(this->numAcks / elapsed, 0) << " messages/s, " << ofToString(this->numAcks * kPointsPerMessage / elapsed, 0) << " points/s";
+
+	if (this->latencies.empty())
+	{
+		ofLogWarning("Remote") << "No acknowledgments received, is the warp app running with setupRemote()?";
+		return;
+	}
+
+	std::sort(this->latencies.begin(), this->latencies.end());
+	uint64_t total = 0;
+	for (auto latency : this->latencies)
+	{
+		total += latency;
+	}
+	auto percentile = [this](float p)
+	{
+		return this->latencies[MIN(this->latencies.size() - 1, (size_t)(p * this->latencies.size()))];
+	};
+
+	// Acknowledgments are sent when the message is applied, just before the warps are drawn, so this includes the wait for the next frame.
+	ofLogNotice("Remote") << "Latency (us): min " << this->latencies.front() << ", avg " << (total / this->latencies.size()) << ", p50 " << percentile(0.5f) << ", p99 " << percentile(0.99f) << ", max " << this->latencies.back();
+}
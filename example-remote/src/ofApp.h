@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxNetwork.h"
+#include "ofxWarp.h"
+
+//! loopback client for ofxWarp::RemoteControl, run it next to an app that called Controller::setupRemote()
+class ofApp
+	: public ofBaseApp
+{
+public:
+	void setup();
+	void update();
+	void draw();
+
+protected:
+	//! send a burst of point batches to the first warp
+	void sendMessages();
+	//! collect the acknowledgments and record their round trip time
+	void receiveAcks();
+	//! log the latency and throughput results
+	void logResults();
+
+	ofxUDPManager sender;
+	ofxUDPManager receiver;
+
+	std::vector<char> sendBuffer;
+	std::vector<char> receiveBuffer;
+
+	//! send time in microseconds by sequence number
+	std::unordered_map<uint32_t, uint64_t> sendTimes;
+	std::vector<uint64_t> latencies;
+
+	uint32_t sequence;
+	size_t numPointsSent;
+	size_t numAcks;
+	uint64_t startTime;
+	bool done;
+};
@@ -0,0 +1,157 @@
+#include "ofApp.h"
+
+static const size_t kCameraWidth = 4000;
+static const size_t kCameraHeight = 3000;
+
+//--------------------------------------------------------------
+void ofApp::setup()
+{
+	ofSetLogLevel(OF_LOG_NOTICE);
+	ofDisableArbTex();
+	ofBackground(ofColor::black);
+
+	// Share the shaders of the main example.
+	ofxWarp::WarpBase::setShaderPath(std::filesystem::path("..") / ".." / ".." / "example" / "bin" / "data" / "shaders" / "ofxWarp");
+
+	// Checkerboard content.
+	ofPixels pixels;
+	pixels.allocate(1280, 800, OF_PIXELS_RGB);
+	for (auto y = 0; y < pixels.getHeight(); ++y)
+	{
+		for (auto x = 0; x < pixels.getWidth(); ++x)
+		{
+			pixels.setColor(x, y, ((x / 40 + y / 40) % 2) ? ofColor::white : ofColor::darkSlateGray);
+		}
+	}
+	this->texture.loadData(pixels);
+
+	this->warpBilinear = this->warpController.buildWarp<ofxWarpBilinear>();
+	this->warpBilinear->setSize(this->texture.getWidth(), this->texture.getHeight());
+	this->warpBilinear->setNumControlsX(9);
+	this->warpBilinear->setNumControlsY(9);
+
+	this->warpPerspective = this->warpController.buildWarp<ofxWarpPerspective>();
+	this->warpPerspective->setSize(this->texture.getWidth(), this->texture.getHeight());
+
+	this->warp = this->warpBilinear;
+
+	this->structuredLight.setup(this->texture.getWidth(), this->texture.getHeight());
+
+	this->patternIndex = -1;
+}
+
+//--------------------------------------------------------------
+void ofApp::update()
+{
+	ofSetWindowTitle(ofToString(ofGetFrameRate(), 2) + " FPS");
+}
+
+//--------------------------------------------------------------
+void ofApp::draw()
+{
+	if (this->patternIndex >= 0)
+	{
+		this->structuredLight.drawPattern(this->patternIndex, this->warp);
+	}
+	else
+	{
+		this->warp->draw(this->texture);
+	}
+
+	std::ostringstream oss;
+	oss << "[p]attern: " << (this->patternIndex >= 0 ? ofToString(this->patternIndex) + " / " + ofToString(this->structuredLight.getNumPatterns()) : "off") << endl;
+	oss << "[w]arp: " << (this->warp == this->warpBilinear ? "bilinear" : "perspective") << endl;
+	oss << "[c]alibrate from synthetic " << kCameraWidth << "x" << kCameraHeight << " captures" << endl;
+	oss << this->result;
+	ofSetColor(ofColor::white);
+	ofDrawBitmapStringHighlight(oss.str(), 10, 20);
+}
+
+//--------------------------------------------------------------
+void ofApp::keyPressed(int key)
+{
+	if (key == 'p')
+	{
+		// Step through the patterns as a projector would show them to the camera.
+		++this->patternIndex;
+		if (this->patternIndex >= this->structuredLight.getNumPatterns())
+		{
+			this->patternIndex = -1;
+		}
+	}
+	else if (key == 'w')
+	{
+		// Perspective warps only take the corners, bilinear warps fit their whole grid.
+		if (this->warp == this->warpBilinear)
+		{
+			this->warp = this->warpPerspective;
+		}
+		else
+		{
+			this->warp = this->warpBilinear;
+		}
+		this->result.clear();
+	}
+	else if (key == 'c')
+	{
+		this->calibrateSynthetic();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::calibrateSynthetic()
+{
+	// The decode is in the content space of the warp, which matches screen space once reset.
+	this->warp->reset();
+
+	// A camera looking at the projection at an angle, the projected content covers this quad of the camera image.
+	glm::dvec2 cameraQuad[4] = { glm::dvec2(600, 450), glm::dvec2(3500, 300), glm::dvec2(3300, 2700), glm::dvec2(500, 2500) };
+	glm::dvec2 contentQuad[4] = { glm::dvec2(0, 0), glm::dvec2(this->texture.getWidth(), 0), glm::dvec2(this->texture.getWidth(), this->texture.getHeight()), glm::dvec2(0, this->texture.getHeight()) };
+	auto cameraToContent = ofxWarp::Homography::quadToQuad(cameraQuad, contentQuad);
+
+	std::vector<ofPixels> captures(this->structuredLight.getNumPatterns());
+	for (auto i = 0; i < captures.size(); ++i)
+	{
+		this->structuredLight.simulateCapture(i, cameraToContent, kCameraWidth, kCameraHeight, captures[i]);
+	}
+
+	ofxWarp::StructuredLight::Decoded decoded;
+	auto start = std::chrono::high_resolution_clock::now();
+	this->structuredLight.decode(captures, decoded);
+	auto decodeTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// Compare against the known mapping.
+	size_t numValid = 0;
+	double maxError = 0.0;
+	for (size_t y = 0; y < kCameraHeight; y += 4)
+	{
+		for (size_t x = 0; x < kCameraWidth; x += 4)
+		{
+			auto i = y * kCameraWidth + x;
+			if (!decoded.valid[i]) continue;
+
+			auto expected = ofxWarp::Homography::transform(cameraToContent, glm::dvec2(x + 0.5, y + 0.5));
+			if (expected.x < 1.0 || expected.y < 1.0 || expected.x > decoded.contentWidth - 1 || expected.y > decoded.contentHeight - 1) continue;
+
+			++numValid;
+			maxError = MAX(maxError, MAX(fabs(decoded.codeX[i] + 0.5 - expected.x), fabs(decoded.codeY[i] + 0.5 - expected.y)));
+		}
+	}
+
+	// Make the content fill an upright rectangle in the camera image.
+	glm::vec2 targetQuad[4] = { glm::vec2(1000, 800), glm::vec2(3000, 800), glm::vec2(3000, 2200), glm::vec2(1000, 2200) };
+	ofxWarp::GridFitter::Result fitResult;
+	auto numFitted = this->structuredLight.fitGrid(decoded, targetQuad, this->warp, 2, &fitResult);
+
+	std::ostringstream oss;
+	oss << "decode: " << ofToString(decodeTime, 1) << " ms for " << captures.size() << " captures" << endl;
+	oss << "max decode error: " << ofToString(maxError, 2) << " px over " << numValid << " samples" << endl;
+	oss << "fitted " << numFitted << " / " << this->warp->getNumControlPoints() << " control points";
+	if (this->warp == this->warpBilinear)
+	{
+		oss << " to " << fitResult.numSamples << " samples";
+		oss << " in " << ofToString(fitResult.assembleTime + fitResult.solveTime, 1) << " ms, rms error " << ofToString(fitResult.rmsError * decoded.contentWidth, 2) << " px";
+	}
+	this->result = oss.str();
+	ofLogNotice("ofApp::calibrateSynthetic") << this->result;
+}
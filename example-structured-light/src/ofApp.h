@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxWarp.h"
+
+//! calibrates a bilinear or perspective warp from synthetic structured light captures
+class ofApp
+	: public ofBaseApp
+{
+public:
+	void setup();
+
+	void update();
+	void draw();
+
+	void keyPressed(int key);
+
+protected:
+	//! render captures through a known camera mapping, decode them and fit the warp
+	void calibrateSynthetic();
+
+	ofxWarpController warpController;
+	std::shared_ptr<ofxWarpBilinear> warpBilinear;
+	std::shared_ptr<ofxWarpPerspective> warpPerspective;
+	//! warp being calibrated, one of the above
+	std::shared_ptr<ofxWarpBase> warp;
+	ofxWarp::StructuredLight structuredLight;
+
+	ofTexture texture;
+
+	//! pattern drawn through the warp, -1 to draw the content
+	int patternIndex;
+	std::string result;
+};
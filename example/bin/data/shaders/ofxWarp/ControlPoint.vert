@@ -9,6 +9,8 @@ in vec2 texcoord;
 in vec4 color;
 
 // App uniforms and attributes
+uniform float uPulseTime;
+
 in vec4 iPositionScale;
 in vec4 iColor;
 
@@ -19,5 +21,8 @@ void main(void)
 {
 	vTexCoord = texcoord;
 	vColor = globalColor * iColor;
-	gl_Position = modelViewProjectionMatrix * vec4(position.xy * iPositionScale.z + iPositionScale.xy, position.zw);
+
+	// The selected flag is in w, selected points pulse over time.
+	float scale = iPositionScale.z * mix(1.0, 0.9 + 0.2 * sin(6.0 * uPulseTime), iPositionScale.w);
+	gl_Position = modelViewProjectionMatrix * vec4(position.xy * scale + iPositionScale.xy, position.zw);
 }
@@ -1,11 +1,27 @@
 #version 150
 
+// Features are enabled by the warp with #defines inserted after the version directive:
+// EDGE_LEFT, EDGE_TOP, EDGE_RIGHT, EDGE_BOTTOM, GAMMA, BLEND_LUT, TINT
+
+#if defined(EDGE_LEFT) || defined(EDGE_TOP) || defined(EDGE_RIGHT) || defined(EDGE_BOTTOM)
+#define BLEND
+#endif
+
 uniform sampler2D uTexture;
-uniform vec3 uLuminance;
-uniform vec3 uGamma;
-uniform vec4 uEdges;
+
+#ifdef BLEND
 uniform vec4 uCorners;
+uniform vec4 uEdges;
+#ifdef BLEND_LUT
+uniform sampler2D uBlendLut;
+#else
+uniform vec3 uLuminance;
 uniform float uExponent;
+#ifdef GAMMA
+uniform vec3 uGamma;
+#endif
+#endif
+#endif
 
 in vec2 vTexCoord;
 in vec4 vColor;
@@ -21,18 +37,42 @@ void main(void)
 {
 	vec4 texColor = texture(uTexture, vTexCoord);
 
+#ifdef BLEND
 	vec2 mapCoord = vec2(map(vTexCoord.x, uCorners.x, uCorners.z, 0.0, 1.0), map(vTexCoord.y, uCorners.y, uCorners.w, 0.0, 1.0));
 
 	float a = 1.0;
-	if (uEdges.x > 0.0) a *= clamp(mapCoord.x / uEdges.x, 0.0, 1.0);
-	if (uEdges.y > 0.0) a *= clamp(mapCoord.y / uEdges.y, 0.0, 1.0);
-	if (uEdges.z > 0.0) a *= clamp((1.0 - mapCoord.x) / uEdges.z, 0.0, 1.0);
-	if (uEdges.w > 0.0) a *= clamp((1.0 - mapCoord.y) / uEdges.w, 0.0, 1.0);
+#ifdef EDGE_LEFT
+	a *= clamp(mapCoord.x / uEdges.x, 0.0, 1.0);
+#endif
+#ifdef EDGE_TOP
+	a *= clamp(mapCoord.y / uEdges.y, 0.0, 1.0);
+#endif
+#ifdef EDGE_RIGHT
+	a *= clamp((1.0 - mapCoord.x) / uEdges.z, 0.0, 1.0);
+#endif
+#ifdef EDGE_BOTTOM
+	a *= clamp((1.0 - mapCoord.y) / uEdges.w, 0.0, 1.0);
+#endif
 
+#ifdef BLEND_LUT
+	// Sample the baked curve at texel centers.
+	float lutSize = float(textureSize(uBlendLut, 0).x);
+	texColor.rgb *= texture(uBlendLut, vec2((a * (lutSize - 1.0) + 0.5) / lutSize, 0.5)).rgb;
+#else
 	const vec3 one = vec3(1.0);
 	vec3 blend = (a < 0.5) ? (uLuminance * pow(2.0 * a, uExponent)) : one - (one - uLuminance) * pow(2.0 * (1.0 - a), uExponent);
 
+#ifdef GAMMA
 	texColor.rgb *= pow(blend, one / uGamma);
+#else
+	texColor.rgb *= blend;
+#endif
+#endif
+#endif
+
+#ifdef TINT
+	texColor *= vColor;
+#endif
 
-	fragColor = texColor * vColor;
+	fragColor = texColor;
 }
@@ -49,6 +49,7 @@ void ofApp::setup()
 	this->keyPressed('a');
 	
 	this->useBeginEnd = false;
+	this->gpuTiming = false;
 }
 
 //--------------------------------------------------------------
@@ -93,6 +94,23 @@ void ofApp::draw()
 	oss << ofToString(ofGetFrameRate(), 2) << " fps" << endl;
 	oss << "[a]rea mode: " << areaName << endl;
 	oss << "[d]raw mode: " << (this->useBeginEnd ? "begin()/end()" : "draw()") << endl;
+	const auto & counters = this->warpController.getFrameCounters();
+	oss << "last frame: " << counters.numDrawCalls << " draw calls, " << counters.numBytesUploaded << " bytes uploaded, " << counters.numMeshRebuilds << " mesh rebuilds" << endl;
+	const auto memoryUsage = this->warpController.getMemoryUsage();
+	oss << "memory: " << ofToString(memoryUsage.getGpuBytes() / (1024.0f * 1024.0f), 1) << " MB gpu (" << ofToString((memoryUsage.fboColorBytes + memoryUsage.fboDepthBytes + memoryUsage.fboStencilBytes) / (1024.0f * 1024.0f), 1) << " MB fbo), " << ofToString(memoryUsage.cpuBytes / 1024.0f, 1) << " KB cpu" << endl;
+	if (this->gpuTiming)
+	{
+		for (size_t i = 0; i < this->warpController.getNumWarps(); ++i)
+		{
+			ofxWarp::GpuTimer::Stats contentStats;
+			ofxWarp::GpuTimer::Stats warpStats;
+			this->warpController.getGpuStats(i, contentStats, warpStats);
+			oss << "warp " << i << " gpu: content " << ofToString(contentStats.avg, 3) << " ms, warp " << ofToString(warpStats.avg, 3) << " ms (" << ofToString(warpStats.min, 3) << " - " << ofToString(warpStats.max, 3) << ")" << endl;
+		}
+	}
+	oss << "[g]pu timing: " << (this->gpuTiming ? "on" : "off") << endl;
+	oss << "[n]etwork remote: " << (this->warpController.getRemote().isConnected() ? "listening" : "off") << endl;
+	oss << "[t]race: " << (ofxWarp::Trace::isRecording() ? "recording" : "off") << endl;
 	oss << "[w]arp edit: " << (this->warpController.getWarp(0)->isEditing() ? "on" : "off");
 	ofSetColor(ofColor::white);
 	ofDrawBitmapStringHighlight(oss.str(), 10, 20);
@@ -169,6 +187,37 @@ void ofApp::keyPressed(int key)
 	{
 		this->useBeginEnd ^= 1;
 	}
+	else if (key == 'g')
+	{
+		this->gpuTiming ^= 1;
+		this->warpController.setGpuTimingEnabled(this->gpuTiming);
+	}
+	else if (key == 'n')
+	{
+		// Accept calibration messages from other processes on this machine, see example-remote.
+		if (this->warpController.getRemote().isConnected())
+		{
+			this->warpController.closeRemote();
+		}
+		else
+		{
+			this->warpController.setupRemote();
+		}
+	}
+	else if (key == 't')
+	{
+		// Only records when the addon is built with OFXWARP_ENABLE_TRACING.
+		if (ofxWarp::Trace::isRecording())
+		{
+			ofxWarp::Trace::stop();
+			ofxWarp::Trace::save(ofToDataPath("trace.json"));
+			ofxWarp::Trace::clear();
+		}
+		else
+		{
+			ofxWarp::Trace::start();
+		}
+	}
 }
 
 //--------------------------------------------------------------
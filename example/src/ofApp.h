@@ -26,6 +26,7 @@ public:
 	void gotMessage(ofMessage msg);
 
 	bool useBeginEnd;
+	bool gpuTiming;
 	ofxWarpController warpController;
 	ofTexture texture;
 	std::vector<ofRectangle> srcAreas;
@@ -1,8 +1,18 @@
 #pragma once
 
+#include "ofxWarp/CalibrationChannel.h"
 #include "ofxWarp/Controller.h"
+#include "ofxWarp/GpuTimer.h"
+#include "ofxWarp/GridFitter.h"
+#include "ofxWarp/Homography.h"
+#include "ofxWarp/PrewarpPipeline.h"
+#include "ofxWarp/RemoteControl.h"
+#include "ofxWarp/SoftwareRenderer.h"
+#include "ofxWarp/StructuredLight.h"
+#include "ofxWarp/Trace.h"
 #include "ofxWarp/WarpBase.h"
 #include "ofxWarp/WarpBilinear.h"
+#include "ofxWarp/WarpIndex.h"
 #include "ofxWarp/WarpPerspective.h"
 #include "ofxWarp/WarpPerspectiveBilinear.h"
 
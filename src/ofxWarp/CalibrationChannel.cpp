@@ -0,0 +1,299 @@
+#include "CalibrationChannel.h"
+
+#include "ofLog.h"
+
+#ifndef TARGET_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ofxWarp
+{
+	//--------------------------------------------------------------
+	CalibrationChannel::CalibrationChannel()
+		: owner(false)
+		, data(nullptr)
+		, size(0)
+		, header(nullptr)
+		, numSlots(0)
+		, slotSize(0)
+		, maxControlPoints(0)
+		, numRetries(0)
+	{}
+
+	//--------------------------------------------------------------
+	CalibrationChannel::~CalibrationChannel()
+	{
+		this->close();
+	}
+
+	//--------------------------------------------------------------
+	bool CalibrationChannel::create(const std::string & name, size_t maxControlPoints, size_t numSlots)
+	{
+		this->close();
+
+		// Need at least one slot to write into while the latest one is being read.
+		numSlots = MAX(numSlots, 2);
+
+		// Keep slots on separate cache lines.
+		auto slotSize = sizeof(SlotHeader) + maxControlPoints * sizeof(glm::vec2);
+		slotSize = (slotSize + 63) & ~size_t(63);
+		auto headerSize = CalibrationChannel::getHeaderSize();
+
+		if (!this->map(name, headerSize + numSlots * slotSize, true)) return false;
+		this->owner = true;
+
+		this->header = new (this->data) SharedHeader();
+		this->header->magic = MAGIC;
+		this->header->version = VERSION;
+		this->header->maxControlPoints = maxControlPoints;
+		this->header->numSlots = numSlots;
+		this->header->slotSize = slotSize;
+		this->header->latestFrame.store(0, std::memory_order_relaxed);
+
+		this->numSlots = numSlots;
+		this->slotSize = slotSize;
+		this->maxControlPoints = maxControlPoints;
+
+		for (size_t i = 0; i < numSlots; ++i)
+		{
+			auto slot = new (static_cast<char *>(this->data) + headerSize + i * slotSize) SlotHeader();
+			slot->sequence.store(0, std::memory_order_relaxed);
+			slot->numControlsX = 0;
+			slot->numControlsY = 0;
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	bool CalibrationChannel::open(const std::string & name)
+	{
+		this->close();
+
+		if (!this->map(name, 0, false)) return false;
+		this->owner = false;
+
+		this->header = static_cast<SharedHeader *>(this->data);
+		if (this->size < sizeof(SharedHeader) || this->header->magic != MAGIC || this->header->version != VERSION)
+		{
+			ofLogError("CalibrationChannel::open") << "Shared memory " << name << " is not a calibration channel";
+			this->close();
+			return false;
+		}
+
+		// The layout comes from another process, make sure every slot lies within the mapping and holds its points.
+		auto numSlots = this->header->numSlots;
+		auto slotSize = this->header->slotSize;
+		auto maxControlPoints = this->header->maxControlPoints;
+		auto headerSize = CalibrationChannel::getHeaderSize();
+		auto valid = (numSlots >= 2 && slotSize >= sizeof(SlotHeader) && slotSize % alignof(SlotHeader) == 0 && this->size >= headerSize);
+		valid = valid && (numSlots <= (this->size - headerSize) / slotSize);
+		valid = valid && (maxControlPoints <= (slotSize - sizeof(SlotHeader)) / sizeof(glm::vec2));
+		if (!valid)
+		{
+			ofLogError("CalibrationChannel::open") << "Shared memory " << name << " of " << this->size << " bytes does not fit " << numSlots << " slots of " << slotSize << " bytes for " << maxControlPoints << " points";
+			this->close();
+			return false;
+		}
+
+		this->numSlots = numSlots;
+		this->slotSize = slotSize;
+		this->maxControlPoints = maxControlPoints;
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void CalibrationChannel::close()
+	{
+#ifndef TARGET_WIN32
+		if (this->data)
+		{
+			munmap(this->data, this->size);
+		}
+		if (this->owner)
+		{
+			shm_unlink(this->name.c_str());
+		}
+#endif
+
+		this->data = nullptr;
+		this->size = 0;
+		this->header = nullptr;
+		this->owner = false;
+
+		this->numSlots = 0;
+		this->slotSize = 0;
+		this->maxControlPoints = 0;
+	}
+
+	//--------------------------------------------------------------
+	bool CalibrationChannel::isOpen() const
+	{
+		return (this->header != nullptr);
+	}
+
+	//--------------------------------------------------------------
+	bool CalibrationChannel::write(size_t numControlsX, size_t numControlsY, const glm::vec2 * points)
+	{
+		if (!this->owner) return false;
+
+		auto numPoints = numControlsX * numControlsY;
+		if (numPoints > this->maxControlPoints)
+		{
+			ofLogWarning("CalibrationChannel::write") << "Grid of " << numPoints << " points does not fit in " << this->maxControlPoints;
+			return false;
+		}
+
+		// Write into the slot after the latest one, readers are only ever directed to complete slots.
+		auto frame = this->header->latestFrame.load(std::memory_order_relaxed) + 1;
+		auto slot = this->getSlot(frame);
+
+		slot->sequence.store(frame * 2 - 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot->numControlsX = numControlsX;
+		slot->numControlsY = numControlsY;
+		memcpy(this->getSlotPoints(slot), points, numPoints * sizeof(glm::vec2));
+
+		slot->sequence.store(frame * 2, std::memory_order_release);
+		this->header->latestFrame.store(frame, std::memory_order_release);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	bool CalibrationChannel::read(uint64_t & frame, size_t & numControlsX, size_t & numControlsY, std::vector<glm::vec2> & points) const
+	{
+		if (!this->header) return false;
+
+		for (auto i = 0; i < MAX_READ_RETRIES; ++i)
+		{
+			auto latestFrame = this->header->latestFrame.load(std::memory_order_acquire);
+			if (latestFrame == 0 || latestFrame <= frame) return false;
+
+			auto slot = this->getSlot(latestFrame);
+			auto sequence = slot->sequence.load(std::memory_order_acquire);
+			if (sequence == latestFrame * 2)
+			{
+				// The counts may be torn or garbage, check them in 64 bits against the slot before copying.
+				size_t nx = slot->numControlsX;
+				size_t ny = slot->numControlsY;
+				if (uint64_t(nx) * uint64_t(ny) <= this->maxControlPoints)
+				{
+					points.resize(nx * ny);
+					memcpy(points.data(), this->getSlotPoints(slot), points.size() * sizeof(glm::vec2));
+
+					// The copy is only valid if the producer did not start rewriting the slot meanwhile.
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (slot->sequence.load(std::memory_order_relaxed) == sequence)
+					{
+						numControlsX = nx;
+						numControlsY = ny;
+						frame = latestFrame;
+						return true;
+					}
+				}
+			}
+
+			// The producer lapped the ring, try again with the newest frame.
+			++this->numRetries;
+		}
+
+		return false;
+	}
+
+	//--------------------------------------------------------------
+	uint64_t CalibrationChannel::getLatestFrame() const
+	{
+		if (!this->header) return 0;
+		return this->header->latestFrame.load(std::memory_order_acquire);
+	}
+
+	//--------------------------------------------------------------
+	size_t CalibrationChannel::getMaxControlPoints() const
+	{
+		return this->maxControlPoints;
+	}
+
+	//--------------------------------------------------------------
+	size_t CalibrationChannel::getNumRetries() const
+	{
+		return this->numRetries;
+	}
+
+	//--------------------------------------------------------------
+	size_t CalibrationChannel::getHeaderSize()
+	{
+		return (sizeof(SharedHeader) + 63) & ~size_t(63);
+	}
+
+	//--------------------------------------------------------------
+	CalibrationChannel::SlotHeader * CalibrationChannel::getSlot(uint64_t frame) const
+	{
+		auto index = frame % this->numSlots;
+		return reinterpret_cast<SlotHeader *>(static_cast<char *>(this->data) + CalibrationChannel::getHeaderSize() + index * this->slotSize);
+	}
+
+	//--------------------------------------------------------------
+	glm::vec2 * CalibrationChannel::getSlotPoints(SlotHeader * slot) const
+	{
+		return reinterpret_cast<glm::vec2 *>(slot + 1);
+	}
+
+	//--------------------------------------------------------------
+	bool CalibrationChannel::map(const std::string & name, size_t size, bool create)
+	{
+#ifdef TARGET_WIN32
+		ofLogError("CalibrationChannel::map") << "POSIX shared memory is not available on this platform";
+		return false;
+#else
+		// POSIX shared memory names start with a single slash.
+		this->name = (name.empty() || name[0] != '/') ? ("/" + name) : name;
+
+		int fd;
+		if (create)
+		{
+			shm_unlink(this->name.c_str());
+			fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd >= 0 && ftruncate(fd, size) != 0)
+			{
+				::close(fd);
+				fd = -1;
+			}
+		}
+		else
+		{
+			// Readers also need write access, the sequence counters are atomics.
+			fd = shm_open(this->name.c_str(), O_RDWR, 0600);
+			struct stat info;
+			if (fd >= 0 && fstat(fd, &info) == 0)
+			{
+				size = info.st_size;
+			}
+		}
+		if (fd < 0)
+		{
+			ofLogError("CalibrationChannel::map") << "Could not open shared memory " << this->name;
+			return false;
+		}
+
+		auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (data == MAP_FAILED)
+		{
+			ofLogError("CalibrationChannel::map") << "Could not map shared memory " << this->name;
+			if (create) shm_unlink(this->name.c_str());
+			return false;
+		}
+
+		this->data = data;
+		this->size = size;
+		return true;
+#endif
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+
+#include "ofConstants.h"
+#include "ofVectorMath.h"
+
+namespace ofxWarp
+{
+	//! ring of control point grids in POSIX shared memory, written by an external solver and read by the warps
+	//! each slot is guarded by a sequence lock, so a single producer never waits and readers only ever see complete frames
+	class CalibrationChannel
+	{
+	public:
+		CalibrationChannel();
+		~CalibrationChannel();
+
+		//! create the named channel as the producer, replacing any existing one with the same name
+		bool create(const std::string & name, size_t maxControlPoints = 4096, size_t numSlots = 3);
+		//! open an existing named channel as a reader
+		bool open(const std::string & name);
+		//! unmap the channel, the producer also removes the name
+		void close();
+		//! return whether the channel is mapped
+		bool isOpen() const;
+
+		//! publish a whole grid of normalized control points, column major like the warps, producer only
+		bool write(size_t numControlsX, size_t numControlsY, const glm::vec2 * points);
+
+		//! copy the latest complete frame if it is newer than the frame, which is then updated
+		//! return false if there is no newer frame, or if it kept being overwritten while reading
+		bool read(uint64_t & frame, size_t & numControlsX, size_t & numControlsY, std::vector<glm::vec2> & points) const;
+
+		//! return the number of the latest published frame, 0 if none
+		uint64_t getLatestFrame() const;
+		//! return the maximum number of control points per frame
+		size_t getMaxControlPoints() const;
+		//! return the number of reads that had to be retried because the producer overwrote the slot
+		size_t getNumRetries() const;
+
+	protected:
+		typedef struct SharedHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t maxControlPoints;
+			uint32_t numSlots;
+			uint64_t slotSize;
+			//! number of the latest complete frame
+			std::atomic<uint64_t> latestFrame;
+		} SharedHeader;
+
+		typedef struct SlotHeader
+		{
+			//! odd while the slot is being written, 2 * frame once it is complete
+			std::atomic<uint64_t> sequence;
+			uint32_t numControlsX;
+			uint32_t numControlsY;
+		} SlotHeader;
+
+		static const uint32_t MAGIC = 0x4C435746; // "FWCL"
+		static const uint32_t VERSION = 1;
+		static const int MAX_READ_RETRIES = 4;
+
+		//! return the size of the shared header, padded to a cache line
+		static size_t getHeaderSize();
+
+		//! return the header of the slot holding the frame
+		SlotHeader * getSlot(uint64_t frame) const;
+		//! return the control points stored right after the slot header
+		glm::vec2 * getSlotPoints(SlotHeader * slot) const;
+
+		//! map the shared memory object, creating and sizing it if requested
+		bool map(const std::string & name, size_t size, bool create);
+
+	protected:
+		std::string name;
+		bool owner;
+
+		void * data;
+		size_t size;
+		SharedHeader * header;
+
+		//! layout of the slots, validated against the mapped size and kept here so the other process cannot change it later
+		size_t numSlots;
+		size_t slotSize;
+		size_t maxControlPoints;
+
+		mutable size_t numRetries;
+	};
+}
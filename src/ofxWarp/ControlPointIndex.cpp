@@ -0,0 +1,266 @@
+#include "ControlPointIndex.h"
+
+namespace ofxWarp
+{
+	//--------------------------------------------------------------
+	ControlPointIndex::ControlPointIndex(float cellSize)
+		: cellSize(cellSize)
+		, numPoints(0)
+		, minCell(std::numeric_limits<int>::max())
+		, maxCell(std::numeric_limits<int>::min())
+		, boundsDirty(false)
+	{}
+
+	//--------------------------------------------------------------
+	void ControlPointIndex::update(const std::vector<std::shared_ptr<WarpBase>> & warps)
+	{
+		// Rebuild from scratch if warps were added, removed or reordered.
+		auto rebuild = (warps.size() != this->entries.size());
+		for (size_t i = 0; i < warps.size() && !rebuild; ++i)
+		{
+			rebuild = (warps[i].get() != this->entries[i].warp);
+		}
+		if (rebuild)
+		{
+			this->clear();
+
+			this->entries.resize(warps.size());
+			for (size_t i = 0; i < warps.size(); ++i)
+			{
+				this->entries[i].warp = warps[i].get();
+				this->entries[i].revision = -1;
+				this->entries[i].indexed = false;
+			}
+		}
+
+		for (size_t i = 0; i < warps.size(); ++i)
+		{
+			auto & entry = this->entries[i];
+			const auto & warp = warps[i];
+
+			// Only editing warps can be selected.
+			if (!warp->isEditing())
+			{
+				this->removeWarp(i);
+				continue;
+			}
+
+			auto revision = warp->getControlPointsRevision();
+			if (entry.indexed && revision == entry.revision) continue;
+
+			const auto & controlPoints = warp->getControlPoints();
+			const auto & windowSize = warp->getWindowSize();
+
+			if (entry.indexed && entry.points.size() == controlPoints.size())
+			{
+				// Incremental update: only re-bucket points that moved to a different cell.
+				for (size_t j = 0; j < controlPoints.size(); ++j)
+				{
+					auto pos = controlPoints[j] * windowSize;
+					if (pos == entry.points[j]) continue;
+
+					auto cell = this->getCell(pos);
+					auto key = this->getKey(cell.x, cell.y);
+					if (key != entry.keys[j])
+					{
+						this->removePoint(i, j);
+						entry.points[j] = pos;
+						this->insertPoint(i, j);
+					}
+					else
+					{
+						entry.points[j] = pos;
+					}
+				}
+			}
+			else
+			{
+				// The grid was resized, re-insert all of the points.
+				this->removeWarp(i);
+
+				entry.points.resize(controlPoints.size());
+				entry.keys.resize(controlPoints.size());
+				for (size_t j = 0; j < controlPoints.size(); ++j)
+				{
+					entry.points[j] = controlPoints[j] * windowSize;
+					this->insertPoint(i, j);
+				}
+				entry.indexed = true;
+			}
+
+			entry.revision = revision;
+		}
+
+		if (this->boundsDirty)
+		{
+			this->updateBounds();
+		}
+	}
+
+	//--------------------------------------------------------------
+	void ControlPointIndex::clear()
+	{
+		this->entries.clear();
+		this->cells.clear();
+		this->numPoints = 0;
+		this->minCell = glm::ivec2(std::numeric_limits<int>::max());
+		this->maxCell = glm::ivec2(std::numeric_limits<int>::min());
+		this->boundsDirty = false;
+	}
+
+	//--------------------------------------------------------------
+	bool ControlPointIndex::findClosest(const glm::vec2 & pos, size_t & warpIndex, size_t & pointIndex, float & distance) const
+	{
+		if (this->numPoints == 0) return false;
+
+		auto bestDistance2 = std::numeric_limits<float>::max();
+		auto found = false;
+
+		auto center = this->getCell(pos);
+
+		// Search rings of cells around the position, until no unvisited cell can hold a closer point.
+		auto maxRing = MAX(MAX(center.x - this->minCell.x, this->maxCell.x - center.x), MAX(center.y - this->minCell.y, this->maxCell.y - center.y));
+		for (auto ring = 0; ring <= maxRing; ++ring)
+		{
+			for (auto row = center.y - ring; row <= center.y + ring; ++row)
+			{
+				if (row < this->minCell.y || row > this->maxCell.y) continue;
+
+				// Inner rows only need the first and last column of the ring.
+				auto onEdge = (row == center.y - ring || row == center.y + ring);
+				auto step = (onEdge || ring == 0) ? 1 : 2 * ring;
+				for (auto col = center.x - ring; col <= center.x + ring; col += step)
+				{
+					if (col < this->minCell.x || col > this->maxCell.x) continue;
+
+					auto it = this->cells.find(this->getKey(col, row));
+					if (it == this->cells.end()) continue;
+
+					for (const auto & item : it->second)
+					{
+						auto delta = pos - this->entries[item.warpIndex].points[item.pointIndex];
+						auto candidate = glm::dot(delta, delta);
+
+						// Prefer the last drawn warp and the lowest point index on ties, like a linear search would.
+						if (!found || candidate < bestDistance2 ||
+							(candidate == bestDistance2 && (item.warpIndex > warpIndex || (item.warpIndex == warpIndex && item.pointIndex < pointIndex))))
+						{
+							bestDistance2 = candidate;
+							warpIndex = item.warpIndex;
+							pointIndex = item.pointIndex;
+							found = true;
+						}
+					}
+				}
+			}
+
+			// Points in the next ring are at least this far away.
+			if (found)
+			{
+				auto ringDistance = ring * this->cellSize;
+				if (bestDistance2 < ringDistance * ringDistance) break;
+			}
+		}
+
+		if (found)
+		{
+			distance = sqrtf(bestDistance2);
+		}
+		return found;
+	}
+
+	//--------------------------------------------------------------
+	size_t ControlPointIndex::getNumPoints() const
+	{
+		return this->numPoints;
+	}
+
+	//--------------------------------------------------------------
+	glm::ivec2 ControlPointIndex::getCell(const glm::vec2 & pos) const
+	{
+		return glm::ivec2(floorf(pos.x / this->cellSize), floorf(pos.y / this->cellSize));
+	}
+
+	//--------------------------------------------------------------
+	uint64_t ControlPointIndex::getKey(int col, int row) const
+	{
+		return (uint64_t(uint32_t(col)) << 32) | uint32_t(row);
+	}
+
+	//--------------------------------------------------------------
+	glm::ivec2 ControlPointIndex::getCell(uint64_t key) const
+	{
+		return glm::ivec2(int32_t(uint32_t(key >> 32)), int32_t(uint32_t(key)));
+	}
+
+	//--------------------------------------------------------------
+	void ControlPointIndex::updateBounds()
+	{
+		this->minCell = glm::ivec2(std::numeric_limits<int>::max());
+		this->maxCell = glm::ivec2(std::numeric_limits<int>::min());
+		for (const auto & it : this->cells)
+		{
+			auto cell = this->getCell(it.first);
+			this->minCell = glm::min(this->minCell, cell);
+			this->maxCell = glm::max(this->maxCell, cell);
+		}
+		this->boundsDirty = false;
+	}
+
+	//--------------------------------------------------------------
+	void ControlPointIndex::insertPoint(size_t warpIndex, size_t pointIndex)
+	{
+		auto & entry = this->entries[warpIndex];
+
+		auto cell = this->getCell(entry.points[pointIndex]);
+		auto key = this->getKey(cell.x, cell.y);
+		this->cells[key].emplace_back(warpIndex, pointIndex);
+		entry.keys[pointIndex] = key;
+
+		this->minCell = glm::min(this->minCell, cell);
+		this->maxCell = glm::max(this->maxCell, cell);
+
+		++this->numPoints;
+	}
+
+	//--------------------------------------------------------------
+	void ControlPointIndex::removePoint(size_t warpIndex, size_t pointIndex)
+	{
+		auto it = this->cells.find(this->entries[warpIndex].keys[pointIndex]);
+		if (it == this->cells.end()) return;
+
+		auto & items = it->second;
+		auto itemIt = std::find(items.begin(), items.end(), Item(warpIndex, pointIndex));
+		if (itemIt != items.end())
+		{
+			// Order within a cell does not matter.
+			*itemIt = items.back();
+			items.pop_back();
+			--this->numPoints;
+		}
+
+		// Only keep occupied cells, and shrink the bounds once a cell on the boundary empties.
+		if (items.empty())
+		{
+			auto cell = this->getCell(it->first);
+			if (cell.x == this->minCell.x || cell.y == this->minCell.y || cell.x == this->maxCell.x || cell.y == this->maxCell.y)
+			{
+				this->boundsDirty = true;
+			}
+			this->cells.erase(it);
+		}
+	}
+
+	//--------------------------------------------------------------
+	void ControlPointIndex::removeWarp(size_t warpIndex)
+	{
+		auto & entry = this->entries[warpIndex];
+		if (!entry.indexed) return;
+
+		for (size_t j = 0; j < entry.points.size(); ++j)
+		{
+			this->removePoint(warpIndex, j);
+		}
+		entry.indexed = false;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "WarpBase.h"
+
+namespace ofxWarp
+{
+	//! uniform grid over the screen space control points of all editing warps, for fast nearest point queries
+	class ControlPointIndex
+	{
+	public:
+		ControlPointIndex(float cellSize = 64.0f);
+
+		//! bring the index up to date with the control points of the editing warps, only moving points that changed cells
+		void update(const std::vector<std::shared_ptr<WarpBase>> & warps);
+		//! remove all points from the index
+		void clear();
+
+		//! find the closest control point to the position in pixels, return false if the index is empty
+		bool findClosest(const glm::vec2 & pos, size_t & warpIndex, size_t & pointIndex, float & distance) const;
+
+		//! return the number of indexed control points
+		size_t getNumPoints() const;
+
+	protected:
+		typedef struct Item
+		{
+			uint32_t warpIndex;
+			uint32_t pointIndex;
+
+			Item(size_t warpIndex, size_t pointIndex)
+				: warpIndex(warpIndex)
+				, pointIndex(pointIndex)
+			{}
+
+			bool operator==(const Item & other) const
+			{
+				return (this->warpIndex == other.warpIndex && this->pointIndex == other.pointIndex);
+			}
+		} Item;
+
+		typedef struct WarpEntry
+		{
+			const WarpBase * warp;
+			size_t revision;
+			bool indexed;
+			//! control points in pixels
+			std::vector<glm::vec2> points;
+			//! cell key of each control point
+			std::vector<uint64_t> keys;
+		} WarpEntry;
+
+		//! return the cell coordinates of the position in pixels
+		glm::ivec2 getCell(const glm::vec2 & pos) const;
+		//! return the hash map key for the cell coordinates
+		uint64_t getKey(int col, int row) const;
+		//! return the cell coordinates of the hash map key
+		glm::ivec2 getCell(uint64_t key) const;
+
+		//! recompute the bounds from the occupied cells
+		void updateBounds();
+
+		void insertPoint(size_t warpIndex, size_t pointIndex);
+		void removePoint(size_t warpIndex, size_t pointIndex);
+		void removeWarp(size_t warpIndex);
+
+	protected:
+		float cellSize;
+
+		std::vector<WarpEntry> entries;
+		std::unordered_map<uint64_t, std::vector<Item>> cells;
+		size_t numPoints;
+
+		//! bounds of the occupied cells, recomputed after points leave a cell on the boundary
+		glm::ivec2 minCell;
+		glm::ivec2 maxCell;
+		bool boundsDirty;
+	};
+}
@@ -1,5 +1,6 @@
 #include "Controller.h"
 
+#include "Trace.h"
 #include "WarpBilinear.h"
 #include "WarpPerspective.h"
 #include "WarpPerspectiveBilinear.h"
@@ -11,6 +12,11 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	Controller::Controller()
 		: focusedIndex(-1)
+		, coalesceInput(false)
+		, pendingMove(false)
+		, pendingDrag(false)
+		, numInputEventsReceived(0)
+		, numInputEventsApplied(0)
 	{
 		ofAddListener(ofEvents().mouseMoved, this, &Controller::onMouseMoved);
 		ofAddListener(ofEvents().mousePressed, this, &Controller::onMousePressed);
@@ -21,6 +27,8 @@ namespace ofxWarp
 		ofAddListener(ofEvents().keyReleased, this, &Controller::onKeyReleased);
 
 		ofAddListener(ofEvents().windowResized, this, &Controller::onWindowResized);
+
+		ofAddListener(ofEvents().draw, this, &Controller::onDraw, OF_EVENT_ORDER_BEFORE_APP);
 	}
 	
 	//--------------------------------------------------------------
@@ -35,6 +43,8 @@ namespace ofxWarp
 		ofRemoveListener(ofEvents().keyReleased, this, &Controller::onKeyReleased);
 
 		ofRemoveListener(ofEvents().windowResized, this, &Controller::onWindowResized);
+
+		ofRemoveListener(ofEvents().draw, this, &Controller::onDraw, OF_EVENT_ORDER_BEFORE_APP);
 		
 		this->warps.clear();
 	}
@@ -42,6 +52,8 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	bool Controller::saveSettings(const std::string & filePath)
 	{
+		OFXWARP_TRACE_SCOPE("Controller::saveSettings");
+
 		nlohmann::json json;
 		this->serialize(json);
 
@@ -54,6 +66,8 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	bool Controller::loadSettings(const std::string & filePath)
 	{
+		OFXWARP_TRACE_SCOPE("Controller::loadSettings");
+
 		auto file = ofFile(filePath, ofFile::ReadOnly);
 		if (!file.exists())
 		{
@@ -72,6 +86,8 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void Controller::serialize(nlohmann::json & json)
 	{
+		OFXWARP_TRACE_SCOPE("Controller::serialize");
+
 		std::vector<nlohmann::json> jsonWarps;
 		for (auto warp : this->warps)
 		{
@@ -85,37 +101,137 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void Controller::deserialize(const nlohmann::json & json)
 	{
+		OFXWARP_TRACE_SCOPE("Controller::deserialize");
+
 		this->warps.clear();
 		for (auto & jsonWarp : json["warps"])
 		{
-			std::shared_ptr<WarpBase> warp;
-
 			int typeAsInt = jsonWarp["type"];
-			WarpBase::Type type = (WarpBase::Type)typeAsInt;
-			switch (type)
+			auto warp = Controller::makeWarp((WarpBase::Type)typeAsInt);
+			if (warp)
 			{
-			case WarpBase::TYPE_BILINEAR:
-				warp = std::make_shared<WarpBilinear>();
-				break;
+				warp->deserialize(jsonWarp);
+				this->warps.push_back(warp);
+			}
+		}
+	}
 
-			case WarpBase::TYPE_PERSPECTIVE:
-				warp = std::make_shared<WarpPerspective>();
-				break;
+	//--------------------------------------------------------------
+	bool Controller::readSnapshot(const std::string & filePath, Snapshot & snapshot)
+	{
+		OFXWARP_TRACE_SCOPE("Controller::readSnapshot");
 
-			case WarpBase::TYPE_PERSPECTIVE_BILINEAR:
-				warp = std::make_shared<WarpPerspectiveBilinear>();
-				break;
+		auto file = ofFile(filePath, ofFile::ReadOnly);
+		if (!file.exists())
+		{
+			ofLogWarning("Controller::readSnapshot") << "File not found at path " << filePath;
+			return false;
+		}
 
-			default:
-				ofLogWarning("Warp::loadSettings") << "Unrecognized Warp type " << type;
-			}
+		nlohmann::json json;
+		file >> json;
 
-			if (warp)
+		snapshot.clear();
+		for (auto & jsonWarp : json["warps"])
+		{
+			WarpBase::State state;
+			WarpBase::readState(jsonWarp, state);
+			snapshot.push_back(state);
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void Controller::captureSnapshot(Snapshot & snapshot) const
+	{
+		snapshot.resize(this->warps.size());
+		for (auto i = 0; i < this->warps.size(); ++i)
+		{
+			this->warps[i]->getState(snapshot[i]);
+		}
+	}
+
+	//--------------------------------------------------------------
+	void Controller::publishSnapshot(const Snapshot & snapshot)
+	{
+		// The copy happens on the publishing thread, and reuses the storage of the back buffer.
+		std::lock_guard<std::mutex> lock(this->publishMutex);
+		this->snapshots.getBackBuffer() = snapshot;
+		this->snapshots.publish();
+	}
+
+	//--------------------------------------------------------------
+	bool Controller::applySnapshot()
+	{
+		if (!this->snapshots.update()) return false;
+
+		OFXWARP_TRACE_SCOPE("Controller::applySnapshot");
+
+		const auto & snapshot = this->snapshots.getFrontBuffer();
+
+		// Keep existing warps where the type matches, so only what changed gets rebuilt.
+		this->warps.resize(snapshot.size());
+		for (auto i = 0; i < snapshot.size(); ++i)
+		{
+			const auto & state = snapshot[i];
+			if (!this->warps[i] || this->warps[i]->getType() != state.type)
 			{
-				warp->deserialize(jsonWarp);
-				this->warps.push_back(warp);
+				this->warps[i] = Controller::makeWarp(state.type);
+			}
+			if (this->warps[i])
+			{
+				this->warps[i]->setState(state);
 			}
 		}
+
+		// Drop the states of unknown type.
+		this->warps.erase(std::remove(this->warps.begin(), this->warps.end(), nullptr), this->warps.end());
+
+		if (this->focusedIndex >= this->warps.size())
+		{
+			this->focusedIndex = -1;
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	bool Controller::setupRemote(int port, bool allowRemote)
+	{
+		return this->remote.setup(port, allowRemote);
+	}
+
+	//--------------------------------------------------------------
+	void Controller::closeRemote()
+	{
+		this->remote.close();
+	}
+
+	//--------------------------------------------------------------
+	RemoteControl & Controller::getRemote()
+	{
+		return this->remote;
+	}
+
+	//--------------------------------------------------------------
+	std::shared_ptr<WarpBase> Controller::makeWarp(WarpBase::Type type)
+	{
+		switch (type)
+		{
+		case WarpBase::TYPE_BILINEAR:
+			return std::make_shared<WarpBilinear>();
+
+		case WarpBase::TYPE_PERSPECTIVE:
+			return std::make_shared<WarpPerspective>();
+
+		case WarpBase::TYPE_PERSPECTIVE_BILINEAR:
+			return std::make_shared<WarpPerspectiveBilinear>();
+
+		default:
+			ofLogWarning("Controller::makeWarp") << "Unrecognized Warp type " << type;
+			return nullptr;
+		}
 	}
 
 	//--------------------------------------------------------------
@@ -166,24 +282,58 @@ namespace ofxWarp
 		return this->warps.size();
 	}
 
+	//--------------------------------------------------------------
+	bool Controller::findWarpAt(const glm::vec2 & pos, WarpIndex::Hit & hit)
+	{
+		this->warpIndex.update(this->warps);
+		return this->warpIndex.findTopmost(pos, hit);
+	}
+
+	//--------------------------------------------------------------
+	size_t Controller::findWarpAt(const glm::vec2 * positions, WarpIndex::Hit * hits, size_t count)
+	{
+		this->warpIndex.update(this->warps);
+
+		size_t numFound = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			hits[i] = WarpIndex::Hit();
+			if (this->warpIndex.findTopmost(positions[i], hits[i]))
+			{
+				++numFound;
+			}
+		}
+		return numFound;
+	}
+
+	//--------------------------------------------------------------
+	size_t Controller::findWarpsAt(const glm::vec2 & pos, std::vector<WarpIndex::Hit> & hits)
+	{
+		this->warpIndex.update(this->warps);
+		return this->warpIndex.findAll(pos, hits);
+	}
+
+	//--------------------------------------------------------------
+	const WarpIndex & Controller::getWarpIndex() const
+	{
+		return this->warpIndex;
+	}
+
 	//--------------------------------------------------------------
 	void Controller::selectClosestControlPoint(const glm::vec2 & pos)
 	{
+		OFXWARP_TRACE_SCOPE("Controller::selectClosestControlPoint");
+
 		size_t warpIdx = -1;
 		size_t pointIdx = -1;
-		auto distance = std::numeric_limits<float>::max();
+		float distance;
 
-		// Find warp and distance to closest control point.
-		for (int i = this->warps.size() - 1; i >= 0; --i)
+		// Find warp and closest control point, only editing warps are indexed.
+		this->controlPointIndex.update(this->warps);
+		if (!this->controlPointIndex.findClosest(pos, warpIdx, pointIdx, distance))
 		{
-			float candidate;
-			auto idx = this->warps[i]->findClosestControlPoint(pos, &candidate);
-			if (candidate < distance && this->warps[i]->isEditing())
-			{
-				distance = candidate;
-				pointIdx = idx;
-				warpIdx = i;
-			}
+			warpIdx = -1;
+			pointIdx = -1;
 		}
 
 		focusedIndex = warpIdx;
@@ -202,16 +352,90 @@ namespace ofxWarp
 		}
 	}
 
+	//--------------------------------------------------------------
+	WarpBase::Counters Controller::getCounters() const
+	{
+		WarpBase::Counters counters;
+		for (auto warp : this->warps)
+		{
+			counters += warp->getCounters();
+		}
+		return counters;
+	}
+
+	//--------------------------------------------------------------
+	const WarpBase::Counters & Controller::getFrameCounters() const
+	{
+		return this->frameCounters;
+	}
+
+	//--------------------------------------------------------------
+	void Controller::resetCounters()
+	{
+		for (auto warp : this->warps)
+		{
+			warp->resetCounters();
+		}
+		this->previousCounters = WarpBase::Counters();
+	}
+
+	//--------------------------------------------------------------
+	WarpBase::MemoryUsage Controller::getMemoryUsage() const
+	{
+		WarpBase::MemoryUsage usage;
+		for (auto warp : this->warps)
+		{
+			usage += warp->getMemoryUsage();
+		}
+		usage.numSharedShaderPrograms = WarpBase::getNumShaderVariants();
+		return usage;
+	}
+
+	//--------------------------------------------------------------
+	void Controller::setGpuTimingEnabled(bool gpuTimingEnabled)
+	{
+		for (auto warp : this->warps)
+		{
+			warp->setGpuTimingEnabled(gpuTimingEnabled);
+		}
+	}
+
+	//--------------------------------------------------------------
+	bool Controller::getGpuStats(size_t index, GpuTimer::Stats & contentStats, GpuTimer::Stats & warpStats) const
+	{
+		if (index >= this->warps.size()) return false;
+
+		contentStats = this->warps[index]->getContentGpuTimer().getStats();
+		warpStats = this->warps[index]->getWarpGpuTimer().getStats();
+		return true;
+	}
+
 	//--------------------------------------------------------------
 	void Controller::onMouseMoved(ofMouseEventArgs & args)
 	{
+		++this->numInputEventsReceived;
+
+		if (this->coalesceInput)
+		{
+			// Only keep the latest position, it is applied before drawing.
+			this->pendingPos = args;
+			this->pendingMove = true;
+			return;
+		}
+
 		// Find and select closest control point.
 		this->selectClosestControlPoint(args);
+		++this->numInputEventsApplied;
 	}
 
 	//--------------------------------------------------------------
 	void Controller::onMousePressed(ofMouseEventArgs & args)
 	{
+		++this->numInputEventsReceived;
+
+		// Keep events in order.
+		this->applyPendingInput();
+
 		// Find and select closest control point.
 		this->selectClosestControlPoint(args);
 
@@ -219,24 +443,42 @@ namespace ofxWarp
 		{
 			this->warps[this->focusedIndex]->handleCursorDown(args);
 		}
+		++this->numInputEventsApplied;
 	}
 
 	//--------------------------------------------------------------
 	void Controller::onMouseDragged(ofMouseEventArgs & args)
 	{
+		++this->numInputEventsReceived;
+
+		if (this->coalesceInput)
+		{
+			// Only keep the latest position, it is applied before drawing.
+			this->pendingPos = args;
+			this->pendingDrag = true;
+			return;
+		}
+
 		if (this->focusedIndex < this->warps.size())
 		{
 			this->warps[this->focusedIndex]->handleCursorDrag(args);
 		}
+		++this->numInputEventsApplied;
 	}
 
 	//--------------------------------------------------------------
 	void Controller::onMouseReleased(ofMouseEventArgs & args)
-	{}
+	{
+		// Make sure the drag ends at the last position.
+		this->applyPendingInput();
+	}
 
 	//--------------------------------------------------------------
 	void Controller::onKeyPressed(ofKeyEventArgs & args)
 	{
+		// Keys act on the current selection.
+		this->applyPendingInput();
+
 		if (args.key == 'w')
 		{
 			for (auto warp : this->warps)
@@ -407,4 +649,77 @@ namespace ofxWarp
 			warp->handleWindowResize(args.width, args.height);
 		}
 	}
+
+	//--------------------------------------------------------------
+	void Controller::onDraw(ofEventArgs & args)
+	{
+		OFXWARP_TRACE_SCOPE("Controller::onDraw");
+
+		this->applySnapshot();
+		this->remote.update(this->warps);
+		this->applyPendingInput();
+
+		// Everything counted since the last draw event belongs to the last frame.
+		auto counters = this->getCounters();
+		this->frameCounters = counters - this->previousCounters;
+		this->previousCounters = counters;
+	}
+
+	//--------------------------------------------------------------
+	void Controller::setCoalesceInput(bool coalesceInput)
+	{
+		if (!coalesceInput)
+		{
+			this->applyPendingInput();
+		}
+		this->coalesceInput = coalesceInput;
+	}
+
+	//--------------------------------------------------------------
+	bool Controller::getCoalesceInput() const
+	{
+		return this->coalesceInput;
+	}
+
+	//--------------------------------------------------------------
+	void Controller::applyPendingInput()
+	{
+		OFXWARP_TRACE_SCOPE("Controller::applyPendingInput");
+
+		if (this->pendingMove)
+		{
+			this->selectClosestControlPoint(this->pendingPos);
+			++this->numInputEventsApplied;
+			this->pendingMove = false;
+		}
+
+		if (this->pendingDrag)
+		{
+			if (this->focusedIndex < this->warps.size())
+			{
+				this->warps[this->focusedIndex]->handleCursorDrag(this->pendingPos);
+			}
+			++this->numInputEventsApplied;
+			this->pendingDrag = false;
+		}
+	}
+
+	//--------------------------------------------------------------
+	size_t Controller::getNumInputEventsReceived() const
+	{
+		return this->numInputEventsReceived;
+	}
+
+	//--------------------------------------------------------------
+	size_t Controller::getNumInputEventsApplied() const
+	{
+		return this->numInputEventsApplied;
+	}
+
+	//--------------------------------------------------------------
+	void Controller::resetInputCounters()
+	{
+		this->numInputEventsReceived = 0;
+		this->numInputEventsApplied = 0;
+	}
 }
\ No newline at end of file
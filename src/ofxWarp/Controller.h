@@ -1,7 +1,13 @@
 #pragma once
 
+#include <mutex>
+
 #include "ofEvents.h"
+#include "ControlPointIndex.h"
+#include "RemoteControl.h"
+#include "TripleBuffer.h"
 #include "WarpBase.h"
+#include "WarpIndex.h"
 
 namespace ofxWarp
 {
@@ -21,6 +27,31 @@ namespace ofxWarp
 		//! deserialize the list of warps from a json file
 		void deserialize(const nlohmann::json & json);
 
+		//! list of warp states, in drawing order
+		typedef std::vector<WarpBase::State> Snapshot;
+
+		//! read a settings json file into a snapshot, without touching any warp, safe to call from any thread
+		static bool readSnapshot(const std::string & filePath, Snapshot & snapshot);
+
+		//! copy the state of all warps into the snapshot, call from the render thread
+		void captureSnapshot(Snapshot & snapshot) const;
+		//! hand a snapshot over to the render thread, safe to call from any thread and never blocks the render thread
+		void publishSnapshot(const Snapshot & snapshot);
+		//! apply the latest published snapshot to the warps, return false if there was nothing new
+		//! called automatically before the app draws, GL objects are only ever updated on the render thread
+		bool applySnapshot();
+
+		//! listen for remote control messages on the UDP port, they are applied once per frame before drawing
+		//! only processes on this machine can connect unless allowRemote is set, see RemoteControl::setup()
+		bool setupRemote(int port = RemoteControl::DEFAULT_PORT, bool allowRemote = false);
+		//! stop listening for remote control messages
+		void closeRemote();
+		//! return the remote control listener
+		RemoteControl & getRemote();
+
+		//! build a new warp of the specified type, return nullptr if the type is unknown
+		static std::shared_ptr<WarpBase> makeWarp(WarpBase::Type type);
+
 		//! build and add a new warp of the specified type
 		template<class Type>
 		inline std::shared_ptr<Type> buildWarp()
@@ -43,6 +74,30 @@ namespace ofxWarp
 		//! return the number of warps
 		size_t getNumWarps() const;
 
+		//! find the topmost warp covering the position in pixels, and the matching position in its content, return false if there is none
+		bool findWarpAt(const glm::vec2 & pos, WarpIndex::Hit & hit);
+		//! find the topmost warp covering each of the positions in pixels, warpIndex is left out of range where there is none, return the number found
+		size_t findWarpAt(const glm::vec2 * positions, WarpIndex::Hit * hits, size_t count);
+		//! find all warps covering the position in pixels, topmost first, return the number found
+		size_t findWarpsAt(const glm::vec2 & pos, std::vector<WarpIndex::Hit> & hits);
+		//! return the hierarchy over the warp footprints used by the find functions
+		const WarpIndex & getWarpIndex() const;
+
+		//! return the counters of all warps added up, since they were last reset
+		WarpBase::Counters getCounters() const;
+		//! return the counters of all warps added up over the last frame, updated before the app draws
+		const WarpBase::Counters & getFrameCounters() const;
+		//! reset the counters of all warps
+		void resetCounters();
+
+		//! return the memory held by all warps added up, shared shader variants are only counted once
+		WarpBase::MemoryUsage getMemoryUsage() const;
+
+		//! set whether the GPU time of the content and warp passes of all current warps is measured
+		void setGpuTimingEnabled(bool gpuTimingEnabled);
+		//! return the rolling GPU times of the content and warp passes of the warp at the specified index, in milliseconds, return false if there is no such warp
+		bool getGpuStats(size_t index, GpuTimer::Stats & contentStats, GpuTimer::Stats & warpStats) const;
+
 		//! handle mouseMoved events for multiple warps
 		void onMouseMoved(ofMouseEventArgs & args);
 		//! handle mousePressed events for multiple warps
@@ -60,6 +115,23 @@ namespace ofxWarp
 		//! handle windowResized events for multiple warps
 		void onWindowResized(ofResizeEventArgs & args);
 
+		//! handle draw events, applies coalesced input before the app draws
+		void onDraw(ofEventArgs & args);
+
+		//! set whether mouseMoved and mouseDragged events are coalesced and applied once per frame, just before drawing
+		void setCoalesceInput(bool coalesceInput);
+		//! return whether mouseMoved and mouseDragged events are coalesced and applied once per frame, just before drawing
+		bool getCoalesceInput() const;
+		//! apply the latest coalesced mouse state to the warps
+		void applyPendingInput();
+
+		//! return the number of mouse events received since the counters were reset
+		size_t getNumInputEventsReceived() const;
+		//! return the number of mouse events applied to the warps since the counters were reset
+		size_t getNumInputEventsApplied() const;
+		//! reset the input event counters
+		void resetInputCounters();
+
 	protected:
 		//! check all warps and select the closest control point
 		void selectClosestControlPoint(const glm::vec2 & pos);
@@ -68,5 +140,30 @@ namespace ofxWarp
 		std::vector<std::shared_ptr<WarpBase>> warps;
 
 		size_t focusedIndex;
+
+		//! spatial index over the control points of all editing warps
+		ControlPointIndex controlPointIndex;
+		//! hierarchy over the footprints of all warps
+		WarpIndex warpIndex;
+
+		bool coalesceInput;
+		bool pendingMove;
+		bool pendingDrag;
+		glm::vec2 pendingPos;
+
+		size_t numInputEventsReceived;
+		size_t numInputEventsApplied;
+
+		//! totals of the warp counters when the last frame started, and the difference over the last frame
+		WarpBase::Counters previousCounters;
+		WarpBase::Counters frameCounters;
+
+		//! listener for messages from external calibration tools
+		RemoteControl remote;
+
+		//! snapshots published by editors, consumed before drawing
+		TripleBuffer<Snapshot> snapshots;
+		//! serializes publishers, only ever held by editor threads
+		std::mutex publishMutex;
 	};
 }
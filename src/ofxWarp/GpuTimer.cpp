@@ -0,0 +1,154 @@
+#include "GpuTimer.h"
+
+#include <limits>
+
+#include "ofAppRunner.h"
+#include "ofGLUtils.h"
+
+namespace ofxWarp
+{
+	GpuTimer * GpuTimer::activeTimer = nullptr;
+
+	//--------------------------------------------------------------
+	GpuTimer::GpuTimer(size_t numQueries, size_t windowSize)
+		: queries(MAX(numQueries, (size_t)1), 0)
+		, firstPending(0)
+		, numPending(0)
+		, running(false)
+		, samples(MAX(windowSize, (size_t)1), 0.0f)
+		, nextSample(0)
+		, numSamples(0)
+	{}
+
+	//--------------------------------------------------------------
+	GpuTimer::~GpuTimer()
+	{
+		if (GpuTimer::activeTimer == this)
+		{
+			GpuTimer::activeTimer = nullptr;
+		}
+
+#ifndef TARGET_OPENGLES
+		// Queries are only created once timing starts, with a context current.
+		if (this->queries[0] != 0)
+		{
+			glDeleteQueries(this->queries.size(), this->queries.data());
+		}
+#endif
+	}
+
+	//--------------------------------------------------------------
+	void GpuTimer::begin()
+	{
+#ifndef TARGET_OPENGLES
+		if (GpuTimer::activeTimer || !GpuTimer::isSupported()) return;
+
+		if (this->queries[0] == 0)
+		{
+			glGenQueries(this->queries.size(), this->queries.data());
+		}
+
+		this->poll();
+
+		// Drop the sample rather than wait for the GPU to catch up.
+		if (this->numPending == this->queries.size()) return;
+
+		glBeginQuery(GL_TIME_ELAPSED, this->queries[(this->firstPending + this->numPending) % this->queries.size()]);
+		this->running = true;
+		GpuTimer::activeTimer = this;
+#endif
+	}
+
+	//--------------------------------------------------------------
+	void GpuTimer::end()
+	{
+#ifndef TARGET_OPENGLES
+		if (!this->running) return;
+
+		glEndQuery(GL_TIME_ELAPSED);
+		++this->numPending;
+		this->running = false;
+		GpuTimer::activeTimer = nullptr;
+#endif
+	}
+
+	//--------------------------------------------------------------
+	void GpuTimer::poll()
+	{
+#ifndef TARGET_OPENGLES
+		// Queries complete in order, so stop at the first one that is not ready.
+		while (this->numPending > 0)
+		{
+			auto query = this->queries[this->firstPending];
+
+			GLint available = 0;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) break;
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			this->addSample(elapsed * 1e-6f);
+
+			this->firstPending = (this->firstPending + 1) % this->queries.size();
+			--this->numPending;
+		}
+#endif
+	}
+
+	//--------------------------------------------------------------
+	GpuTimer::Stats GpuTimer::getStats() const
+	{
+		Stats stats;
+		if (this->numSamples == 0) return stats;
+
+		stats.min = std::numeric_limits<float>::max();
+		stats.max = 0.0f;
+		auto sum = 0.0f;
+		for (size_t i = 0; i < this->numSamples; ++i)
+		{
+			auto sample = this->samples[i];
+			stats.min = MIN(stats.min, sample);
+			stats.max = MAX(stats.max, sample);
+			sum += sample;
+		}
+		stats.avg = sum / this->numSamples;
+		stats.numSamples = this->numSamples;
+
+		return stats;
+	}
+
+	//--------------------------------------------------------------
+	float GpuTimer::getLatest() const
+	{
+		if (this->numSamples == 0) return 0.0f;
+
+		return this->samples[(this->nextSample + this->samples.size() - 1) % this->samples.size()];
+	}
+
+	//--------------------------------------------------------------
+	void GpuTimer::reset()
+	{
+		this->nextSample = 0;
+		this->numSamples = 0;
+	}
+
+	//--------------------------------------------------------------
+	bool GpuTimer::isSupported()
+	{
+#ifdef TARGET_OPENGLES
+		return false;
+#else
+		// Core since OpenGL 3.3.
+		static const auto supported = ofGLCheckExtension("GL_ARB_timer_query") || (ofGetGLRenderer() && ofGetGLRenderer()->getGLVersionMajor() * 10 + ofGetGLRenderer()->getGLVersionMinor() >= 33);
+		return supported;
+#endif
+	}
+
+	//--------------------------------------------------------------
+	void GpuTimer::addSample(float sample)
+	{
+		this->samples[this->nextSample] = sample;
+		this->nextSample = (this->nextSample + 1) % this->samples.size();
+		this->numSamples = MIN(this->numSamples + 1, this->samples.size());
+	}
+}
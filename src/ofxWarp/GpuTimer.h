@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ofConstants.h"
+
+namespace ofxWarp
+{
+	//! measures the GPU time of a pass with a ring of GL_TIME_ELAPSED queries, results are read back a few frames later without stalling
+	//! not available on OpenGL ES, where begin() and end() do nothing
+	class GpuTimer
+	{
+	public:
+		//! rolling statistics over the most recent samples, in milliseconds
+		typedef struct Stats
+		{
+			float min;
+			float avg;
+			float max;
+			size_t numSamples;
+
+			Stats()
+				: min(0.0f)
+				, avg(0.0f)
+				, max(0.0f)
+				, numSamples(0)
+			{}
+		} Stats;
+
+		//! numQueries bounds how many frames a result can lag behind, windowSize is the number of samples the stats are taken over
+		GpuTimer(size_t numQueries = 4, size_t windowSize = 120);
+		~GpuTimer();
+
+		GpuTimer(const GpuTimer &) = delete;
+		GpuTimer & operator=(const GpuTimer &) = delete;
+
+		//! start timing, skipped if another timer is running since the queries cannot nest, or if all queries are still in flight
+		void begin();
+		//! stop timing
+		void end();
+
+		//! collect the results that are available, without waiting, called by begin()
+		void poll();
+
+		//! return the statistics over the most recent samples
+		Stats getStats() const;
+		//! return the most recent sample in milliseconds, 0 if there is none
+		float getLatest() const;
+		//! drop all samples
+		void reset();
+
+		//! return whether timer queries are supported by the current context
+		static bool isSupported();
+
+	protected:
+		void addSample(float sample);
+
+	protected:
+		std::vector<GLuint> queries;
+		//! index of the oldest query in flight, and the number in flight
+		size_t firstPending;
+		size_t numPending;
+		bool running;
+
+		std::vector<float> samples;
+		size_t nextSample;
+		size_t numSamples;
+
+		//! the timer with an open query, if any
+		static GpuTimer * activeTimer;
+	};
+}
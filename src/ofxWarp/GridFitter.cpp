@@ -0,0 +1,528 @@
+#include "GridFitter.h"
+
+#include <chrono>
+#include <thread>
+
+#include "ofLog.h"
+#include "ofMath.h"
+#include "WarpPerspectiveBilinear.h"
+
+namespace ofxWarp
+{
+	namespace
+	{
+		static const int STENCIL_RADIUS = 3;
+		static const int STENCIL_SIZE = STENCIL_RADIUS * 2 + 1;
+		static const int STENCIL_AREA = STENCIL_SIZE * STENCIL_SIZE;
+
+		//--------------------------------------------------------------
+		// Add the weight of a knot, reflecting knots beyond the edges like WarpBilinear::getPoint() does.
+		void addKnot(int i, double weight, int maxIndex, int * indices, double * weights, size_t & count)
+		{
+			if (i < 0)
+			{
+				addKnot(0, 2.0 * weight, maxIndex, indices, weights, count);
+				addKnot(-i, -weight, maxIndex, indices, weights, count);
+				return;
+			}
+			if (i > maxIndex)
+			{
+				addKnot(maxIndex, 2.0 * weight, maxIndex, indices, weights, count);
+				addKnot(2 * maxIndex - i, -weight, maxIndex, indices, weights, count);
+				return;
+			}
+
+			for (size_t k = 0; k < count; ++k)
+			{
+				if (indices[k] == i)
+				{
+					weights[k] += weight;
+					return;
+				}
+			}
+			indices[count] = i;
+			weights[count] = weight;
+			++count;
+		}
+
+		//--------------------------------------------------------------
+		// Weights along one axis, t is in [0..numControls - 1].
+		size_t getAxisWeights(size_t numControls, bool linear, float t, int * indices, double * weights)
+		{
+			auto base = (int)t;
+			double f = t - base;
+			auto maxIndex = (int)numControls - 1;
+
+			size_t count = 0;
+			if (linear)
+			{
+				addKnot(base, 1.0 - f, maxIndex, indices, weights, count);
+				addKnot(base + 1, f, maxIndex, indices, weights, count);
+			}
+			else
+			{
+				// Expanded form of WarpBilinear::cubicInterpolate().
+				auto f2 = f * f;
+				auto f3 = f2 * f;
+				addKnot(base - 1, 0.5 * (-f + 2.0 * f2 - f3), maxIndex, indices, weights, count);
+				addKnot(base, 1.0 + 0.5 * (-5.0 * f2 + 3.0 * f3), maxIndex, indices, weights, count);
+				addKnot(base + 1, 0.5 * (f + 4.0 * f2 - 3.0 * f3), maxIndex, indices, weights, count);
+				addKnot(base + 2, 0.5 * (-f2 + f3), maxIndex, indices, weights, count);
+			}
+			return count;
+		}
+
+		//--------------------------------------------------------------
+		// Offset of the neighbor in the stencil of the control point, both column major.
+		inline int getStencilOffset(size_t a, size_t b, size_t numControlsY)
+		{
+			auto dc = (int)(b / numControlsY) - (int)(a / numControlsY);
+			auto dr = (int)(b % numControlsY) - (int)(a % numControlsY);
+			return (dc + STENCIL_RADIUS) * STENCIL_SIZE + (dr + STENCIL_RADIUS);
+		}
+
+		//--------------------------------------------------------------
+		void multiply(const std::vector<double> & stencils, const std::vector<double> & x, std::vector<double> & y, size_t numControlsX, size_t numControlsY)
+		{
+			for (size_t c = 0; c < numControlsX; ++c)
+			{
+				for (size_t r = 0; r < numControlsY; ++r)
+				{
+					auto i = c * numControlsY + r;
+					auto stencil = stencils.data() + i * STENCIL_AREA;
+
+					auto c0 = MAX(0, (int)c - STENCIL_RADIUS);
+					auto c1 = MIN((int)numControlsX - 1, (int)c + STENCIL_RADIUS);
+					auto r0 = MAX(0, (int)r - STENCIL_RADIUS);
+					auto r1 = MIN((int)numControlsY - 1, (int)r + STENCIL_RADIUS);
+
+					double sum = 0.0;
+					for (auto nc = c0; nc <= c1; ++nc)
+					{
+						auto row = stencil + (nc - (int)c + STENCIL_RADIUS) * STENCIL_SIZE + STENCIL_RADIUS - (int)r;
+						auto col = x.data() + nc * numControlsY;
+						for (auto nr = r0; nr <= r1; ++nr)
+						{
+							sum += row[nr] * col[nr];
+						}
+					}
+					y[i] = sum;
+				}
+			}
+		}
+
+		//--------------------------------------------------------------
+		inline double dot(const std::vector<double> & a, const std::vector<double> & b)
+		{
+			double sum = 0.0;
+			for (size_t i = 0; i < a.size(); ++i)
+			{
+				sum += a[i] * b[i];
+			}
+			return sum;
+		}
+	}
+
+	//--------------------------------------------------------------
+	GridFitter::GridFitter()
+		: smoothness(0.0f)
+		, damping(1e-6f)
+		, numThreads(0)
+		, maxIterations(1000)
+		, tolerance(1e-8)
+	{}
+
+	//--------------------------------------------------------------
+	void GridFitter::setSmoothness(float smoothness)
+	{
+		this->smoothness = MAX(0.0f, smoothness);
+	}
+
+	//--------------------------------------------------------------
+	float GridFitter::getSmoothness() const
+	{
+		return this->smoothness;
+	}
+
+	//--------------------------------------------------------------
+	void GridFitter::setDamping(float damping)
+	{
+		this->damping = MAX(0.0f, damping);
+	}
+
+	//--------------------------------------------------------------
+	float GridFitter::getDamping() const
+	{
+		return this->damping;
+	}
+
+	//--------------------------------------------------------------
+	void GridFitter::setNumThreads(size_t numThreads)
+	{
+		this->numThreads = numThreads;
+	}
+
+	//--------------------------------------------------------------
+	size_t GridFitter::getNumThreads() const
+	{
+		return this->numThreads;
+	}
+
+	//--------------------------------------------------------------
+	void GridFitter::setMaxIterations(size_t maxIterations)
+	{
+		this->maxIterations = maxIterations;
+	}
+
+	//--------------------------------------------------------------
+	size_t GridFitter::getMaxIterations() const
+	{
+		return this->maxIterations;
+	}
+
+	//--------------------------------------------------------------
+	void GridFitter::setTolerance(double tolerance)
+	{
+		this->tolerance = tolerance;
+	}
+
+	//--------------------------------------------------------------
+	double GridFitter::getTolerance() const
+	{
+		return this->tolerance;
+	}
+
+	//--------------------------------------------------------------
+	size_t GridFitter::getWeights(size_t numControlsX, size_t numControlsY, bool linear, const glm::vec2 & content, size_t * indices, double * weights)
+	{
+		// Same parametrization as WarpBilinear::updateMesh().
+		auto u = ofClamp(content.x, 0.0f, 1.0f) * (numControlsX - 1);
+		auto v = ofClamp(content.y, 0.0f, 1.0f) * (numControlsY - 1);
+
+		int cols[4];
+		int rows[4];
+		double colWeights[4];
+		double rowWeights[4];
+		auto numCols = getAxisWeights(numControlsX, linear, u, cols, colWeights);
+		auto numRows = getAxisWeights(numControlsY, linear, v, rows, rowWeights);
+
+		// The reflection at the edges is separable, so the 2D weights are a tensor product.
+		size_t count = 0;
+		for (size_t i = 0; i < numCols; ++i)
+		{
+			for (size_t j = 0; j < numRows; ++j)
+			{
+				indices[count] = cols[i] * numControlsY + rows[j];
+				weights[count] = colWeights[i] * rowWeights[j];
+				++count;
+			}
+		}
+		return count;
+	}
+
+	//--------------------------------------------------------------
+	bool GridFitter::fit(std::shared_ptr<WarpBilinear> warp, const std::vector<glm::vec2> & content, const std::vector<glm::vec2> & screen, Result * result) const
+	{
+		auto numControlsX = warp->getNumControlsX();
+		auto numControlsY = warp->getNumControlsY();
+
+		// Fit in the space the grid is evaluated in.
+		std::vector<glm::vec2> targets(screen.size());
+		for (size_t i = 0; i < screen.size(); ++i)
+		{
+			targets[i] = warp->screenToGrid(screen[i]);
+		}
+
+		std::vector<glm::vec2> controlPoints(numControlsX * numControlsY);
+		for (size_t i = 0; i < controlPoints.size(); ++i)
+		{
+			controlPoints[i] = warp->getGridPoint(i);
+		}
+
+		// The grid corners of perspective-bilinear warps are fixed, their perspective handles the corners.
+		std::vector<bool> fixed;
+		if (std::dynamic_pointer_cast<WarpPerspectiveBilinear>(warp))
+		{
+			fixed.resize(controlPoints.size(), false);
+			fixed[0] = true;
+			fixed[numControlsY - 1] = true;
+			fixed[controlPoints.size() - numControlsY] = true;
+			fixed[controlPoints.size() - 1] = true;
+		}
+
+		if (!this->fit(numControlsX, numControlsY, warp->getLinear(), content, targets, controlPoints, fixed, result)) return false;
+
+		warp->setControlPoints(controlPoints);
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	bool GridFitter::fit(size_t numControlsX, size_t numControlsY, bool linear, const std::vector<glm::vec2> & content, const std::vector<glm::vec2> & targets, std::vector<glm::vec2> & controlPoints, const std::vector<bool> & fixed, Result * result) const
+	{
+		auto numPoints = numControlsX * numControlsY;
+		if (numControlsX < 2 || numControlsY < 2 || controlPoints.size() != numPoints || content.size() != targets.size() || content.empty())
+		{
+			ofLogWarning("GridFitter::fit") << "Invalid input, need a grid of at least 2x2 points and matching samples";
+			return false;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// Assemble the normal equations of the samples, each thread into its own copy.
+		auto numThreads = this->numThreads ? this->numThreads : MAX(1u, std::thread::hardware_concurrency());
+		numThreads = MIN(numThreads, MAX((size_t)1, content.size() / 1024));
+		auto samplesPerThread = (content.size() + numThreads - 1) / numThreads;
+
+		std::vector<std::vector<double>> stencils(numThreads, std::vector<double>(numPoints * STENCIL_AREA, 0.0));
+		std::vector<std::vector<double>> rhsX(numThreads, std::vector<double>(numPoints, 0.0));
+		std::vector<std::vector<double>> rhsY(numThreads, std::vector<double>(numPoints, 0.0));
+
+		auto assemble = [&](size_t t)
+		{
+			auto & A = stencils[t];
+			auto & bx = rhsX[t];
+			auto & by = rhsY[t];
+
+			size_t indices[MAX_WEIGHTS];
+			double weights[MAX_WEIGHTS];
+			auto end = MIN(content.size(), (t + 1) * samplesPerThread);
+			for (auto s = t * samplesPerThread; s < end; ++s)
+			{
+				auto count = GridFitter::getWeights(numControlsX, numControlsY, linear, content[s], indices, weights);
+				for (size_t i = 0; i < count; ++i)
+				{
+					auto a = indices[i];
+					auto wa = weights[i];
+					auto stencil = A.data() + a * STENCIL_AREA;
+					for (size_t j = 0; j < count; ++j)
+					{
+						stencil[getStencilOffset(a, indices[j], numControlsY)] += wa * weights[j];
+					}
+					bx[a] += wa * targets[s].x;
+					by[a] += wa * targets[s].y;
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t t = 1; t < numThreads; ++t)
+		{
+			threads.emplace_back(assemble, t);
+		}
+		assemble(0);
+		for (auto & thread : threads)
+		{
+			thread.join();
+		}
+
+		auto & A = stencils[0];
+		auto & bx = rhsX[0];
+		auto & by = rhsY[0];
+		for (size_t t = 1; t < numThreads; ++t)
+		{
+			for (size_t i = 0; i < A.size(); ++i)
+			{
+				A[i] += stencils[t][i];
+			}
+			for (size_t i = 0; i < numPoints; ++i)
+			{
+				bx[i] += rhsX[t][i];
+				by[i] += rhsY[t][i];
+			}
+		}
+
+		// Regularization, weighted relative to the mean squared error of the samples.
+		auto numSamples = (double)content.size();
+		if (this->smoothness > 0.0f)
+		{
+			// Penalize second differences along columns and rows.
+			auto numTerms = (double)(MAX((size_t)1, (numControlsX - 2) * numControlsY + numControlsX * (numControlsY - 2)));
+			auto weight = this->smoothness * numSamples / numTerms;
+			auto addTerm = [&](size_t i0, size_t i1, size_t i2)
+			{
+				size_t indices[3] = { i0, i1, i2 };
+				double weights[3] = { 1.0, -2.0, 1.0 };
+				for (auto i = 0; i < 3; ++i)
+				{
+					for (auto j = 0; j < 3; ++j)
+					{
+						A[indices[i] * STENCIL_AREA + getStencilOffset(indices[i], indices[j], numControlsY)] += weight * weights[i] * weights[j];
+					}
+				}
+			};
+			for (size_t c = 0; c < numControlsX; ++c)
+			{
+				for (size_t r = 0; r < numControlsY; ++r)
+				{
+					auto i = c * numControlsY + r;
+					if (c > 0 && c + 1 < numControlsX) addTerm(i - numControlsY, i, i + numControlsY);
+					if (r > 0 && r + 1 < numControlsY) addTerm(i - 1, i, i + 1);
+				}
+			}
+		}
+		{
+			// Pull towards the current positions, so the system stays well posed where there are no samples.
+			auto weight = MAX(this->damping, 1e-9f) * numSamples / numPoints;
+			for (size_t i = 0; i < numPoints; ++i)
+			{
+				A[i * STENCIL_AREA + getStencilOffset(i, i, numControlsY)] += weight;
+				bx[i] += weight * controlPoints[i].x;
+				by[i] += weight * controlPoints[i].y;
+			}
+		}
+
+		// Eliminate fixed points, keeping the system symmetric.
+		if (fixed.size() == numPoints)
+		{
+			for (size_t i = 0; i < numPoints; ++i)
+			{
+				auto c = (int)(i / numControlsY);
+				auto r = (int)(i % numControlsY);
+				for (auto dc = -STENCIL_RADIUS; dc <= STENCIL_RADIUS; ++dc)
+				{
+					for (auto dr = -STENCIL_RADIUS; dr <= STENCIL_RADIUS; ++dr)
+					{
+						auto nc = c + dc;
+						auto nr = r + dr;
+						if (nc < 0 || nr < 0 || nc >= (int)numControlsX || nr >= (int)numControlsY) continue;
+
+						auto j = nc * numControlsY + nr;
+						if (i == j || (!fixed[i] && !fixed[j])) continue;
+
+						auto & entry = A[i * STENCIL_AREA + (dc + STENCIL_RADIUS) * STENCIL_SIZE + (dr + STENCIL_RADIUS)];
+						if (!fixed[i])
+						{
+							bx[i] -= entry * controlPoints[j].x;
+							by[i] -= entry * controlPoints[j].y;
+						}
+						entry = 0.0;
+					}
+				}
+				if (fixed[i])
+				{
+					A[i * STENCIL_AREA + getStencilOffset(i, i, numControlsY)] = 1.0;
+					bx[i] = controlPoints[i].x;
+					by[i] = controlPoints[i].y;
+				}
+			}
+		}
+
+		auto assembled = std::chrono::high_resolution_clock::now();
+
+		// Both coordinates share the same matrix.
+		std::vector<double> x(numPoints);
+		std::vector<double> y(numPoints);
+		for (size_t i = 0; i < numPoints; ++i)
+		{
+			x[i] = controlPoints[i].x;
+			y[i] = controlPoints[i].y;
+		}
+		bool convergedX;
+		bool convergedY;
+		auto numIterationsX = this->solve(A, bx, x, numControlsX, numControlsY, convergedX);
+		auto numIterationsY = this->solve(A, by, y, numControlsX, numControlsY, convergedY);
+
+		for (size_t i = 0; i < numPoints; ++i)
+		{
+			controlPoints[i] = glm::vec2(x[i], y[i]);
+		}
+
+		auto solved = std::chrono::high_resolution_clock::now();
+
+		if (result)
+		{
+			// Report how well the grid matches the samples.
+			double sumSquared = 0.0;
+			double maxError = 0.0;
+			size_t indices[MAX_WEIGHTS];
+			double weights[MAX_WEIGHTS];
+			for (size_t s = 0; s < content.size(); ++s)
+			{
+				auto count = GridFitter::getWeights(numControlsX, numControlsY, linear, content[s], indices, weights);
+				auto pos = glm::dvec2(0.0);
+				for (size_t i = 0; i < count; ++i)
+				{
+					pos += weights[i] * glm::dvec2(x[indices[i]], y[indices[i]]);
+				}
+				auto delta = pos - glm::dvec2(targets[s]);
+				auto error = glm::dot(delta, delta);
+				sumSquared += error;
+				maxError = MAX(maxError, error);
+			}
+
+			result->numSamples = content.size();
+			result->numIterations = MAX(numIterationsX, numIterationsY);
+			result->converged = convergedX && convergedY;
+			result->rmsError = sqrt(sumSquared / numSamples);
+			result->maxError = sqrt(maxError);
+			result->assembleTime = std::chrono::duration<double, std::milli>(assembled - start).count();
+			result->solveTime = std::chrono::duration<double, std::milli>(solved - assembled).count();
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	size_t GridFitter::solve(const std::vector<double> & stencils, const std::vector<double> & b, std::vector<double> & x, size_t numControlsX, size_t numControlsY, bool & converged) const
+	{
+		auto numPoints = b.size();
+
+		// Jacobi preconditioner.
+		std::vector<double> invDiagonal(numPoints);
+		for (size_t i = 0; i < numPoints; ++i)
+		{
+			auto diagonal = stencils[i * STENCIL_AREA + getStencilOffset(i, i, numControlsY)];
+			invDiagonal[i] = (diagonal != 0.0) ? 1.0 / diagonal : 1.0;
+		}
+
+		std::vector<double> r(numPoints);
+		std::vector<double> z(numPoints);
+		std::vector<double> p(numPoints);
+		std::vector<double> q(numPoints);
+
+		multiply(stencils, x, q, numControlsX, numControlsY);
+		for (size_t i = 0; i < numPoints; ++i)
+		{
+			r[i] = b[i] - q[i];
+			z[i] = r[i] * invDiagonal[i];
+			p[i] = z[i];
+		}
+
+		auto bNorm = sqrt(dot(b, b));
+		auto threshold = this->tolerance * (bNorm > 0.0 ? bNorm : 1.0);
+		auto rz = dot(r, z);
+
+		converged = false;
+		size_t iteration = 0;
+		for (; iteration < this->maxIterations; ++iteration)
+		{
+			if (sqrt(dot(r, r)) <= threshold)
+			{
+				converged = true;
+				break;
+			}
+
+			multiply(stencils, p, q, numControlsX, numControlsY);
+			auto pq = dot(p, q);
+			if (pq <= 0.0) break;
+
+			auto alpha = rz / pq;
+			for (size_t i = 0; i < numPoints; ++i)
+			{
+				x[i] += alpha * p[i];
+				r[i] -= alpha * q[i];
+				z[i] = r[i] * invDiagonal[i];
+			}
+
+			auto rzNext = dot(r, z);
+			auto beta = rzNext / rz;
+			rz = rzNext;
+			for (size_t i = 0; i < numPoints; ++i)
+			{
+				p[i] = z[i] + beta * p[i];
+			}
+		}
+
+		return iteration;
+	}
+}
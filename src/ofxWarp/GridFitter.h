@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ofVectorMath.h"
+
+#include "WarpBilinear.h"
+
+namespace ofxWarp
+{
+	//! least squares fit of a bilinear warp grid to point correspondences, using the same evaluation as WarpBilinear::updateMesh
+	class GridFitter
+	{
+	public:
+		typedef struct Result
+		{
+			size_t numSamples;
+			size_t numIterations;
+			bool converged;
+			//! errors between the fitted grid and the targets, in the units of the targets
+			double rmsError;
+			double maxError;
+			//! timings in milliseconds
+			double assembleTime;
+			double solveTime;
+
+			Result()
+				: numSamples(0)
+				, numIterations(0)
+				, converged(false)
+				, rmsError(0.0)
+				, maxError(0.0)
+				, assembleTime(0.0)
+				, solveTime(0.0)
+			{}
+		} Result;
+
+		//! maximum number of control points influencing a single position
+		static const size_t MAX_WEIGHTS = 16;
+
+		GridFitter();
+
+		//! set the weight of the curvature penalty, relative to the mean squared error of the samples
+		void setSmoothness(float smoothness);
+		float getSmoothness() const;
+
+		//! set the weight pulling control points towards their current position, keeps points without samples in place
+		void setDamping(float damping);
+		float getDamping() const;
+
+		//! set the number of threads used to assemble the system, 0 to use all cores
+		void setNumThreads(size_t numThreads);
+		size_t getNumThreads() const;
+
+		//! set the conjugate gradient iteration limit and relative residual tolerance
+		void setMaxIterations(size_t maxIterations);
+		size_t getMaxIterations() const;
+		void setTolerance(double tolerance);
+		double getTolerance() const;
+
+		//! fit the control points of the warp so that normalized content positions land on normalized screen positions
+		//! perspective-bilinear warps keep their perspective and the corners of their grid, only the bilinear grid is fitted
+		bool fit(std::shared_ptr<WarpBilinear> warp, const std::vector<glm::vec2> & content, const std::vector<glm::vec2> & screen, Result * result = nullptr) const;
+
+		//! fit a column major grid of control points so that normalized content positions land on the targets
+		//! controlPoints holds the starting point and receives the solution, fixed points are left untouched
+		bool fit(size_t numControlsX, size_t numControlsY, bool linear, const std::vector<glm::vec2> & content, const std::vector<glm::vec2> & targets, std::vector<glm::vec2> & controlPoints, const std::vector<bool> & fixed = std::vector<bool>(), Result * result = nullptr) const;
+
+		//! return the control point indices and weights that evaluate the grid at the normalized content position
+		static size_t getWeights(size_t numControlsX, size_t numControlsY, bool linear, const glm::vec2 & content, size_t * indices, double * weights);
+
+	protected:
+		//! solve A x = b with Jacobi preconditioned conjugate gradients, A is stored as a 7x7 stencil per control point
+		size_t solve(const std::vector<double> & stencils, const std::vector<double> & b, std::vector<double> & x, size_t numControlsX, size_t numControlsY, bool & converged) const;
+
+	protected:
+		float smoothness;
+		float damping;
+		size_t numThreads;
+		size_t maxIterations;
+		double tolerance;
+	};
+}
@@ -0,0 +1,116 @@
+#include "Homography.h"
+
+namespace ofxWarp
+{
+	//--------------------------------------------------------------
+	// From: Heckbert, "Fundamentals of Texture Mapping and Image Warping", section 2.2.3
+	glm::dmat3 Homography::squareToQuad(const glm::dvec2 quad[4])
+	{
+		auto sx = quad[0].x - quad[1].x + quad[2].x - quad[3].x;
+		auto sy = quad[0].y - quad[1].y + quad[2].y - quad[3].y;
+
+		auto g = 0.0;
+		auto h = 0.0;
+		if (sx != 0.0 || sy != 0.0)
+		{
+			// Projective mapping.
+			auto dx1 = quad[1].x - quad[2].x;
+			auto dx2 = quad[3].x - quad[2].x;
+			auto dy1 = quad[1].y - quad[2].y;
+			auto dy2 = quad[3].y - quad[2].y;
+
+			auto den = dx1 * dy2 - dx2 * dy1;
+			if (den != 0.0)
+			{
+				g = (sx * dy2 - dx2 * sy) / den;
+				h = (dx1 * sy - sx * dy1) / den;
+			}
+		}
+
+		// Columns are (a, d, g), (b, e, h), (c, f, 1) for x' = (au + bv + c) / (gu + hv + 1) and y' = (du + ev + f) / (gu + hv + 1).
+		return glm::dmat3(quad[1].x - quad[0].x + g * quad[1].x, quad[1].y - quad[0].y + g * quad[1].y, g,
+						  quad[3].x - quad[0].x + h * quad[3].x, quad[3].y - quad[0].y + h * quad[3].y, h,
+						  quad[0].x, quad[0].y, 1.0);
+	}
+
+	//--------------------------------------------------------------
+	glm::dmat3 Homography::quadToQuad(const glm::dvec2 src[4], const glm::dvec2 dst[4])
+	{
+		auto m = Homography::squareToQuad(dst) * Homography::adjugate(Homography::squareToQuad(src));
+
+		// Normalize so that the bottom right element is 1.
+		if (m[2][2] != 0.0)
+		{
+			m /= m[2][2];
+		}
+
+		return m;
+	}
+
+	//--------------------------------------------------------------
+	void Homography::quadToQuad(const glm::dvec2 * src, const glm::dvec2 * dst, size_t count, glm::dmat3 * transforms, glm::dmat3 * inverses)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			transforms[i] = Homography::quadToQuad(src + i * 4, dst + i * 4);
+		}
+
+		if (inverses)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				inverses[i] = Homography::invert(transforms[i]);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	glm::dmat3 Homography::adjugate(const glm::dmat3 & m)
+	{
+		// Rows of m.
+		auto a = m[0][0], b = m[1][0], c = m[2][0];
+		auto d = m[0][1], e = m[1][1], f = m[2][1];
+		auto g = m[0][2], h = m[1][2], i = m[2][2];
+
+		// Transposed cofactor matrix, column by column.
+		return glm::dmat3(e * i - f * h, f * g - d * i, d * h - e * g,
+						  c * h - b * i, a * i - c * g, b * g - a * h,
+						  b * f - c * e, c * d - a * f, a * e - b * d);
+	}
+
+	//--------------------------------------------------------------
+	glm::dmat3 Homography::invert(const glm::dmat3 & m)
+	{
+		auto adj = Homography::adjugate(m);
+
+		// The determinant is the dot product of the first row of m with the first column of its adjugate.
+		auto det = m[0][0] * adj[0][0] + m[1][0] * adj[0][1] + m[2][0] * adj[0][2];
+		if (det == 0.0)
+		{
+			return adj;
+		}
+
+		return adj / det;
+	}
+
+	//--------------------------------------------------------------
+	glm::dvec2 Homography::transform(const glm::dmat3 & m, const glm::dvec2 & pt)
+	{
+		auto p = m * glm::dvec3(pt.x, pt.y, 1.0);
+		if (p.z != 0.0)
+		{
+			p /= p.z;
+		}
+		return glm::dvec2(p.x, p.y);
+	}
+
+	//--------------------------------------------------------------
+	glm::mat4 Homography::toMat4(const glm::dmat3 & m)
+	{
+		// Map the homogeneous coordinate to w and leave z untouched.
+		return glm::mat4(m[0][0], m[0][1], 0, m[0][2],
+						 m[1][0], m[1][1], 0, m[1][2],
+						 0, 0, 1, 0,
+						 m[2][0], m[2][1], 0, m[2][2]);
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ofVectorMath.h"
+
+namespace ofxWarp
+{
+	//! closed-form, double precision homography solver for quad-to-quad mappings
+	class Homography
+	{
+	public:
+		//! return the homography mapping the corners of the unit square (0,0), (1,0), (1,1), (0,1) to the corners of the quad
+		static glm::dmat3 squareToQuad(const glm::dvec2 quad[4]);
+		//! return the homography mapping the corners of the src quad to the corners of the dst quad
+		static glm::dmat3 quadToQuad(const glm::dvec2 src[4], const glm::dvec2 dst[4]);
+		//! compute the homographies and their inverses for count pairs of quads, src and dst hold 4 corners per quad
+		static void quadToQuad(const glm::dvec2 * src, const glm::dvec2 * dst, size_t count, glm::dmat3 * transforms, glm::dmat3 * inverses = nullptr);
+
+		//! return the adjugate of the matrix, which is its inverse up to scale
+		static glm::dmat3 adjugate(const glm::dmat3 & m);
+		//! return the inverse of the matrix, computed from its adjugate
+		static glm::dmat3 invert(const glm::dmat3 & m);
+
+		//! transform the point by the homography, including the perspective divide
+		static glm::dvec2 transform(const glm::dmat3 & m, const glm::dvec2 & pt);
+		//! return the homography as a 4x4 matrix that transforms geometry in the XY plane
+		static glm::mat4 toMat4(const glm::dmat3 & m);
+	};
+}
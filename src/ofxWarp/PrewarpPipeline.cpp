@@ -0,0 +1,330 @@
+#include "PrewarpPipeline.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "ofFileUtils.h"
+#include "ofImage.h"
+#include "ofLog.h"
+
+namespace ofxWarp
+{
+	namespace
+	{
+		// Frame handed between the stages, buffers are recycled so their memory is only allocated once.
+		typedef struct Frame
+		{
+			size_t index;
+			size_t warpIndex;
+			ofPixels pixels;
+		} Frame;
+
+		// Queue that blocks producers when full and consumers when empty, until it is closed.
+		template<typename T>
+		class BoundedQueue
+		{
+		public:
+			BoundedQueue(size_t capacity)
+				: capacity(capacity)
+				, closed(false)
+			{}
+
+			// Return false if the queue was closed.
+			bool push(T && item)
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->notFull.wait(lock, [this]() { return (this->closed || this->items.size() < this->capacity); });
+				if (this->closed) return false;
+
+				this->items.push_back(std::move(item));
+				this->notEmpty.notify_one();
+				return true;
+			}
+
+			// Return false once the queue is closed and drained.
+			bool pop(T & item)
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->notEmpty.wait(lock, [this]() { return (this->closed || !this->items.empty()); });
+				if (this->items.empty()) return false;
+
+				item = std::move(this->items.front());
+				this->items.pop_front();
+				this->notFull.notify_one();
+				return true;
+			}
+
+			void close()
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->closed = true;
+				this->notFull.notify_all();
+				this->notEmpty.notify_all();
+			}
+
+		protected:
+			size_t capacity;
+			bool closed;
+			std::deque<T> items;
+			std::mutex mutex;
+			std::condition_variable notFull;
+			std::condition_variable notEmpty;
+		};
+	}
+
+	//--------------------------------------------------------------
+	PrewarpPipeline::PrewarpPipeline()
+		: numDecodeThreads(2)
+		, numEncodeThreads(4)
+		, queueSize(2)
+		, outputExtension("png")
+		, cancelled(false)
+		, numFramesDone(0)
+		, numFramesFailed(0)
+	{}
+
+	//--------------------------------------------------------------
+	void PrewarpPipeline::setNumDecodeThreads(size_t numDecodeThreads)
+	{
+		this->numDecodeThreads = MAX(numDecodeThreads, (size_t)1);
+	}
+
+	//--------------------------------------------------------------
+	size_t PrewarpPipeline::getNumDecodeThreads() const
+	{
+		return this->numDecodeThreads;
+	}
+
+	//--------------------------------------------------------------
+	void PrewarpPipeline::setNumEncodeThreads(size_t numEncodeThreads)
+	{
+		this->numEncodeThreads = MAX(numEncodeThreads, (size_t)1);
+	}
+
+	//--------------------------------------------------------------
+	size_t PrewarpPipeline::getNumEncodeThreads() const
+	{
+		return this->numEncodeThreads;
+	}
+
+	//--------------------------------------------------------------
+	void PrewarpPipeline::setNumRenderThreads(size_t numRenderThreads)
+	{
+		this->renderer.setNumThreads(numRenderThreads);
+	}
+
+	//--------------------------------------------------------------
+	size_t PrewarpPipeline::getNumRenderThreads() const
+	{
+		return this->renderer.getNumThreads();
+	}
+
+	//--------------------------------------------------------------
+	void PrewarpPipeline::setQueueSize(size_t queueSize)
+	{
+		this->queueSize = MAX(queueSize, (size_t)1);
+	}
+
+	//--------------------------------------------------------------
+	size_t PrewarpPipeline::getQueueSize() const
+	{
+		return this->queueSize;
+	}
+
+	//--------------------------------------------------------------
+	void PrewarpPipeline::setOutputExtension(const std::string & outputExtension)
+	{
+		this->outputExtension = outputExtension;
+	}
+
+	//--------------------------------------------------------------
+	const std::string & PrewarpPipeline::getOutputExtension() const
+	{
+		return this->outputExtension;
+	}
+
+	//--------------------------------------------------------------
+	std::vector<std::string> PrewarpPipeline::listFrames(const std::string & folder, const std::string & extension)
+	{
+		ofDirectory dir(folder);
+		dir.allowExt(extension);
+		dir.listDir();
+		dir.sort();
+
+		std::vector<std::string> framePaths;
+		for (size_t i = 0; i < dir.size(); ++i)
+		{
+			framePaths.push_back(dir.getPath(i));
+		}
+		return framePaths;
+	}
+
+	//--------------------------------------------------------------
+	bool PrewarpPipeline::run(const std::vector<std::string> & framePaths, const std::vector<std::shared_ptr<WarpBase>> & warps, const std::string & outputFolder)
+	{
+		std::vector<ofRectangle> srcAreas(warps.size(), ofRectangle(0.0f, 0.0f, 1.0f, 1.0f));
+		return this->run(framePaths, warps, srcAreas, outputFolder);
+	}
+
+	//--------------------------------------------------------------
+	bool PrewarpPipeline::run(const std::vector<std::string> & framePaths, const std::vector<std::shared_ptr<WarpBase>> & warps, const std::vector<ofRectangle> & srcAreas, const std::string & outputFolder)
+	{
+		this->cancelled = false;
+		this->numFramesDone = 0;
+		this->numFramesFailed = 0;
+
+		if (warps.empty())
+		{
+			ofLogError("PrewarpPipeline::run") << "No warps to render through!";
+			return false;
+		}
+		if (srcAreas.size() != warps.size())
+		{
+			ofLogError("PrewarpPipeline::run") << "Expected " << warps.size() << " source areas, got " << srcAreas.size();
+			return false;
+		}
+
+		std::vector<std::string> warpFolders(warps.size());
+		for (size_t i = 0; i < warps.size(); ++i)
+		{
+			warpFolders[i] = ofFilePath::join(outputFolder, "warp" + ofToString(i));
+			if (!ofDirectory::doesDirectoryExist(warpFolders[i], false) && !ofDirectory::createDirectory(warpFolders[i], false, true))
+			{
+				ofLogError("PrewarpPipeline::run") << "Could not create folder " << warpFolders[i];
+				return false;
+			}
+		}
+
+		// The pools hold every buffer, so they bound the memory in flight: the decoders can get ahead of the warp stage by the queue size,
+		// and the warp stage can get ahead of the encoders by the queue size for each warp.
+		auto numSources = this->queueSize + this->numDecodeThreads;
+		auto numOutputs = this->queueSize * warps.size() + this->numEncodeThreads;
+		BoundedQueue<Frame> freeSources(numSources);
+		BoundedQueue<Frame> decoded(numSources);
+		BoundedQueue<Frame> freeOutputs(numOutputs);
+		BoundedQueue<Frame> encoded(numOutputs);
+		for (size_t i = 0; i < numSources; ++i)
+		{
+			freeSources.push(Frame());
+		}
+		for (size_t i = 0; i < numOutputs; ++i)
+		{
+			freeOutputs.push(Frame());
+		}
+
+		// Decode stage, frames are loaded in parallel and may arrive out of order.
+		std::atomic<size_t> nextFrame(0);
+		std::atomic<size_t> numDecodersDone(0);
+		std::vector<std::thread> decoders;
+		for (size_t i = 0; i < this->numDecodeThreads; ++i)
+		{
+			decoders.emplace_back([&]()
+			{
+				for (auto index = nextFrame++; index < framePaths.size() && !this->cancelled; index = nextFrame++)
+				{
+					Frame frame;
+					if (!freeSources.pop(frame)) break;
+
+					frame.index = index;
+					if (!ofLoadImage(frame.pixels, framePaths[index]))
+					{
+						ofLogError("PrewarpPipeline::run") << "Could not load frame " << framePaths[index];
+						frame.pixels.clear();
+						++this->numFramesFailed;
+					}
+					decoded.push(std::move(frame));
+				}
+
+				if (++numDecodersDone == this->numDecodeThreads)
+				{
+					decoded.close();
+				}
+			});
+		}
+
+		// Encode stage.
+		std::vector<std::thread> encoders;
+		for (size_t i = 0; i < this->numEncodeThreads; ++i)
+		{
+			encoders.emplace_back([&]()
+			{
+				Frame frame;
+				while (encoded.pop(frame))
+				{
+					if (!this->cancelled)
+					{
+						auto path = ofFilePath::join(warpFolders[frame.warpIndex], ofFilePath::getBaseName(framePaths[frame.index]) + "." + this->outputExtension);
+						if (!ofSaveImage(frame.pixels, path))
+						{
+							ofLogError("PrewarpPipeline::run") << "Could not save frame " << path;
+							++this->numFramesFailed;
+						}
+					}
+					freeOutputs.push(std::move(frame));
+				}
+			});
+		}
+
+		// Warp stage, on the calling thread with the renderer spreading each frame over its own threads.
+		// Once cancelled, it keeps draining and recycling frames so that no stage stays blocked.
+		Frame source;
+		while (decoded.pop(source))
+		{
+			if (!this->cancelled && source.pixels.isAllocated())
+			{
+				auto pixelFormat = (source.pixels.getNumChannels() == 4) ? OF_PIXELS_RGBA : OF_PIXELS_RGB;
+				auto sourceSize = glm::vec2(source.pixels.getWidth(), source.pixels.getHeight());
+				for (size_t i = 0; i < warps.size(); ++i)
+				{
+					Frame output;
+					freeOutputs.pop(output);
+
+					// Allocating is a no-op when the recycled buffer already has the right size.
+					const auto & windowSize = warps[i]->getWindowSize();
+					output.index = source.index;
+					output.warpIndex = i;
+					output.pixels.allocate(windowSize.x, windowSize.y, pixelFormat);
+					output.pixels.set(0);
+					auto srcArea = ofRectangle(glm::vec2(srcAreas[i].getMin()) * sourceSize, glm::vec2(srcAreas[i].getMax()) * sourceSize);
+					this->renderer.render(source.pixels, srcArea, warps[i], output.pixels);
+
+					encoded.push(std::move(output));
+				}
+				++this->numFramesDone;
+			}
+			freeSources.push(std::move(source));
+		}
+
+		encoded.close();
+		for (auto & thread : encoders)
+		{
+			thread.join();
+		}
+		for (auto & thread : decoders)
+		{
+			thread.join();
+		}
+
+		return (!this->cancelled && this->numFramesFailed == 0);
+	}
+
+	//--------------------------------------------------------------
+	void PrewarpPipeline::cancel()
+	{
+		this->cancelled = true;
+	}
+
+	//--------------------------------------------------------------
+	size_t PrewarpPipeline::getNumFramesDone() const
+	{
+		return this->numFramesDone;
+	}
+
+	//--------------------------------------------------------------
+	size_t PrewarpPipeline::getNumFramesFailed() const
+	{
+		return this->numFramesFailed;
+	}
+}
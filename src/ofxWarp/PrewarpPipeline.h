@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+
+#include "SoftwareRenderer.h"
+#include "WarpBase.h"
+
+namespace ofxWarp
+{
+	//! streams an image sequence through warps offline, writing one warped sequence per warp
+	//! decoding, warping and encoding run on separate threads connected by bounded queues, so memory use does not depend on the length of the sequence
+	class PrewarpPipeline
+	{
+	public:
+		PrewarpPipeline();
+
+		//! set the number of threads loading source frames
+		void setNumDecodeThreads(size_t numDecodeThreads);
+		size_t getNumDecodeThreads() const;
+
+		//! set the number of threads saving warped frames
+		void setNumEncodeThreads(size_t numEncodeThreads);
+		size_t getNumEncodeThreads() const;
+
+		//! set the number of rendering threads of the warp stage, 0 to use all cores
+		void setNumRenderThreads(size_t numRenderThreads);
+		size_t getNumRenderThreads() const;
+
+		//! set the number of source frames in flight, and of warped frames in flight for each warp
+		void setQueueSize(size_t queueSize);
+		size_t getQueueSize() const;
+
+		//! set the file extension of the warped frames, which selects their format
+		void setOutputExtension(const std::string & outputExtension);
+		const std::string & getOutputExtension() const;
+
+		//! return the paths of all files with the extension in the folder, sorted by name
+		static std::vector<std::string> listFrames(const std::string & folder, const std::string & extension);
+
+		//! warp every source frame through each warp and save it to a "warp<index>" folder in the output folder, under the name of the source frame
+		//! the warps are drawn at their window size and must not be modified until this returns, return false if any frame failed or the run was cancelled
+		bool run(const std::vector<std::string> & framePaths, const std::vector<std::shared_ptr<WarpBase>> & warps, const std::string & outputFolder);
+		//! same as above, each warp only draws its area of the source frames, as a fraction of their size
+		bool run(const std::vector<std::string> & framePaths, const std::vector<std::shared_ptr<WarpBase>> & warps, const std::vector<ofRectangle> & srcAreas, const std::string & outputFolder);
+		//! stop a run from another thread, frames in flight are dropped
+		void cancel();
+
+		//! return the number of source frames warped in the current or last run, safe to call from any thread
+		size_t getNumFramesDone() const;
+		//! return the number of frames that could not be loaded or saved in the current or last run
+		size_t getNumFramesFailed() const;
+
+	protected:
+		size_t numDecodeThreads;
+		size_t numEncodeThreads;
+		size_t queueSize;
+		std::string outputExtension;
+
+		SoftwareRenderer renderer;
+
+		std::atomic<bool> cancelled;
+		std::atomic<size_t> numFramesDone;
+		std::atomic<size_t> numFramesFailed;
+	};
+}
@@ -0,0 +1,394 @@
+#include "RemoteControl.h"
+
+#include "ofLog.h"
+
+#include "WarpBilinear.h"
+
+#ifdef TARGET_WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace ofxWarp
+{
+	// Non-blocking UDP socket, replies go back to the address of the last datagram received.
+	class RemoteControl::Socket
+	{
+	public:
+#ifdef TARGET_WIN32
+		typedef SOCKET Handle;
+		static constexpr Handle INVALID_HANDLE = INVALID_SOCKET;
+#else
+		typedef int Handle;
+		static constexpr Handle INVALID_HANDLE = -1;
+#endif
+
+		Socket()
+			: handle(INVALID_HANDLE)
+		{
+#ifdef TARGET_WIN32
+			WSADATA wsaData;
+			this->started = (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+#endif
+			memset(&this->sender, 0, sizeof(this->sender));
+		}
+
+		~Socket()
+		{
+			if (this->handle != INVALID_HANDLE)
+			{
+#ifdef TARGET_WIN32
+				closesocket(this->handle);
+#else
+				::close(this->handle);
+#endif
+			}
+#ifdef TARGET_WIN32
+			if (this->started) WSACleanup();
+#endif
+		}
+
+		bool bind(int port, bool allowRemote)
+		{
+			this->handle = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			if (this->handle == INVALID_HANDLE) return false;
+
+			sockaddr_in address;
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			address.sin_addr.s_addr = htonl(allowRemote ? INADDR_ANY : INADDR_LOOPBACK);
+			if (::bind(this->handle, (const sockaddr *)&address, sizeof(address)) != 0) return false;
+
+			int bufferSize = 1024 * 1024;
+			setsockopt(this->handle, SOL_SOCKET, SO_RCVBUF, (const char *)&bufferSize, sizeof(bufferSize));
+
+#ifdef TARGET_WIN32
+			u_long nonBlocking = 1;
+			return (ioctlsocket(this->handle, FIONBIO, &nonBlocking) == 0);
+#else
+			auto flags = fcntl(this->handle, F_GETFL, 0);
+			return (flags != -1 && fcntl(this->handle, F_SETFL, flags | O_NONBLOCK) == 0);
+#endif
+		}
+
+		// Return false if there is no datagram pending.
+		bool receive(char * buffer, size_t capacity, size_t & size)
+		{
+			socklen_t senderSize = sizeof(this->sender);
+			auto received = recvfrom(this->handle, buffer, (int)capacity, 0, (sockaddr *)&this->sender, &senderSize);
+			if (received < 0) return false;
+
+			size = received;
+			return true;
+		}
+
+		void reply(const char * data, size_t size, uint16_t port)
+		{
+			auto address = this->sender;
+			address.sin_port = htons(port);
+			sendto(this->handle, data, (int)size, 0, (const sockaddr *)&address, sizeof(address));
+		}
+
+	protected:
+		Handle handle;
+		sockaddr_in sender;
+#ifdef TARGET_WIN32
+		bool started;
+#endif
+	};
+
+	//--------------------------------------------------------------
+	RemoteControl::RemoteControl()
+		: maxMessagesPerFrame(4096)
+		, maxGridSize(DEFAULT_MAX_GRID_SIZE)
+		, numMessagesApplied(0)
+		, numMessagesRejected(0)
+	{}
+
+	//--------------------------------------------------------------
+	RemoteControl::~RemoteControl()
+	{
+		this->close();
+	}
+
+	//--------------------------------------------------------------
+	bool RemoteControl::setup(int port, bool allowRemote)
+	{
+		this->close();
+
+		auto socket = std::make_unique<Socket>();
+		if (!socket->bind(port, allowRemote))
+		{
+			ofLogError("RemoteControl::setup") << "Could not bind to port " << port;
+			return false;
+		}
+		if (allowRemote)
+		{
+			ofLogWarning("RemoteControl::setup") << "Listening on all interfaces, any host on the network can edit the warps";
+		}
+
+		this->socket = std::move(socket);
+		this->receiveBuffer.resize(MAX_MESSAGE_SIZE);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::close()
+	{
+		this->socket.reset();
+	}
+
+	//--------------------------------------------------------------
+	bool RemoteControl::isConnected() const
+	{
+		return (this->socket != nullptr);
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::setMaxMessagesPerFrame(size_t maxMessagesPerFrame)
+	{
+		this->maxMessagesPerFrame = maxMessagesPerFrame;
+	}
+
+	//--------------------------------------------------------------
+	size_t RemoteControl::getMaxMessagesPerFrame() const
+	{
+		return this->maxMessagesPerFrame;
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::setMaxGridSize(size_t maxGridSize)
+	{
+		this->maxGridSize = MAX(maxGridSize, (size_t)2);
+	}
+
+	//--------------------------------------------------------------
+	size_t RemoteControl::getMaxGridSize() const
+	{
+		return this->maxGridSize;
+	}
+
+	//--------------------------------------------------------------
+	size_t RemoteControl::update(const std::vector<std::shared_ptr<WarpBase>> & warps)
+	{
+		if (!this->socket) return 0;
+
+		// Drain the socket, the warps only rebuild their meshes once when they are next drawn.
+		// Rejected messages count against the limit too, so that a flood of garbage cannot stall drawing either.
+		size_t numReceived = 0;
+		size_t numApplied = 0;
+		size_t size;
+		while (numReceived < this->maxMessagesPerFrame && this->socket->receive(this->receiveBuffer.data(), this->receiveBuffer.size(), size))
+		{
+			++numReceived;
+
+			Header header;
+			if (!this->applyMessage(this->receiveBuffer.data(), size, warps, header))
+			{
+				++this->numMessagesRejected;
+				continue;
+			}
+			++numApplied;
+
+			if (header.replyPort != 0)
+			{
+				this->sendAck(header);
+			}
+		}
+
+		this->numMessagesApplied += numApplied;
+		return numApplied;
+	}
+
+	//--------------------------------------------------------------
+	size_t RemoteControl::getNumMessagesApplied() const
+	{
+		return this->numMessagesApplied;
+	}
+
+	//--------------------------------------------------------------
+	size_t RemoteControl::getNumMessagesRejected() const
+	{
+		return this->numMessagesRejected;
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::writeHeader(std::vector<char> & buffer, Opcode opcode, uint16_t warpIndex, uint32_t sequence, uint16_t replyPort)
+	{
+		Header header;
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.opcode = opcode;
+		header.replyPort = replyPort;
+		header.sequence = sequence;
+		header.warpIndex = warpIndex;
+		header.count = 0;
+
+		buffer.resize(sizeof(Header));
+		memcpy(buffer.data(), &header, sizeof(Header));
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::writePoint(std::vector<char> & buffer, uint16_t index, const glm::vec2 & pos)
+	{
+		PointItem item;
+		item.index = index;
+		item.reserved = 0;
+		item.x = pos.x;
+		item.y = pos.y;
+
+		auto offset = buffer.size();
+		buffer.resize(offset + sizeof(PointItem));
+		memcpy(buffer.data() + offset, &item, sizeof(PointItem));
+
+		// Bump the item count in the header.
+		auto header = reinterpret_cast<Header *>(buffer.data());
+		++header->count;
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::writeValues(std::vector<char> & buffer, const float * values, size_t count)
+	{
+		auto offset = buffer.size();
+		buffer.resize(offset + count * sizeof(float));
+		memcpy(buffer.data() + offset, values, count * sizeof(float));
+
+		auto header = reinterpret_cast<Header *>(buffer.data());
+		header->count += count;
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::writeGrid(std::vector<char> & buffer, uint16_t columns, uint16_t rows)
+	{
+		GridItem item;
+		item.columns = columns;
+		item.rows = rows;
+
+		auto offset = buffer.size();
+		buffer.resize(offset + sizeof(GridItem));
+		memcpy(buffer.data() + offset, &item, sizeof(GridItem));
+
+		auto header = reinterpret_cast<Header *>(buffer.data());
+		header->count = 1;
+	}
+
+	//--------------------------------------------------------------
+	bool RemoteControl::readHeader(const char * data, size_t size, Header & header)
+	{
+		if (size < sizeof(Header)) return false;
+
+		memcpy(&header, data, sizeof(Header));
+		return (header.magic == MAGIC && header.version == VERSION);
+	}
+
+	//--------------------------------------------------------------
+	bool RemoteControl::applyMessage(const char * data, size_t size, const std::vector<std::shared_ptr<WarpBase>> & warps, Header & header)
+	{
+		if (!RemoteControl::readHeader(data, size, header)) return false;
+		if (header.warpIndex >= warps.size()) return false;
+
+		const auto & warp = warps[header.warpIndex];
+		auto payload = data + sizeof(Header);
+		auto payloadSize = size - sizeof(Header);
+
+		switch (header.opcode)
+		{
+		case OP_SET_POINTS:
+		case OP_MOVE_POINTS:
+		{
+			if (payloadSize != header.count * sizeof(PointItem)) return false;
+
+			auto numControlPoints = warp->getNumControlPoints();
+			for (auto i = 0; i < header.count; ++i)
+			{
+				PointItem item;
+				memcpy(&item, payload + i * sizeof(PointItem), sizeof(PointItem));
+				if (item.index >= numControlPoints) continue;
+
+				if (header.opcode == OP_SET_POINTS)
+				{
+					warp->setControlPoint(item.index, glm::vec2(item.x, item.y));
+				}
+				else
+				{
+					warp->moveControlPoint(item.index, glm::vec2(item.x, item.y));
+				}
+			}
+			return true;
+		}
+
+		case OP_SET_EDGES:
+		case OP_SET_GAMMA:
+		case OP_SET_LUMINANCE:
+		case OP_SET_EXPONENT:
+		case OP_SET_BRIGHTNESS:
+		{
+			size_t numValues = (header.opcode == OP_SET_EDGES) ? 4 : (header.opcode == OP_SET_GAMMA || header.opcode == OP_SET_LUMINANCE) ? 3 : 1;
+			if (header.count != numValues || payloadSize != numValues * sizeof(float)) return false;
+
+			float values[4];
+			memcpy(values, payload, numValues * sizeof(float));
+
+			if (header.opcode == OP_SET_EDGES)
+			{
+				warp->setEdges(glm::vec4(values[0], values[1], values[2], values[3]));
+			}
+			else if (header.opcode == OP_SET_GAMMA)
+			{
+				warp->setGamma(glm::vec3(values[0], values[1], values[2]));
+			}
+			else if (header.opcode == OP_SET_LUMINANCE)
+			{
+				warp->setLuminance(glm::vec3(values[0], values[1], values[2]));
+			}
+			else if (header.opcode == OP_SET_EXPONENT)
+			{
+				warp->setExponent(values[0]);
+			}
+			else
+			{
+				warp->setBrightness(values[0]);
+			}
+			return true;
+		}
+
+		case OP_SET_GRID:
+		{
+			if (payloadSize != sizeof(GridItem)) return false;
+
+			auto warpBilinear = std::dynamic_pointer_cast<WarpBilinear>(warp);
+			if (!warpBilinear) return false;
+
+			GridItem item;
+			memcpy(&item, payload, sizeof(GridItem));
+			if (item.columns < 2 || item.rows < 2) return false;
+			if (item.columns > this->maxGridSize || item.rows > this->maxGridSize) return false;
+
+			warpBilinear->setNumControlsX(item.columns);
+			warpBilinear->setNumControlsY(item.rows);
+			return true;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	//--------------------------------------------------------------
+	void RemoteControl::sendAck(const Header & header)
+	{
+		RemoteControl::writeHeader(this->ackBuffer, OP_ACK, header.warpIndex, header.sequence);
+		this->socket->reply(this->ackBuffer.data(), this->ackBuffer.size(), header.replyPort);
+	}
+}
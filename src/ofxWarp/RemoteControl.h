@@ -0,0 +1,129 @@
+#pragma once
+
+#include <memory>
+
+#include "WarpBase.h"
+
+namespace ofxWarp
+{
+	//! listens on a UDP port, on the loopback interface by default, for compact binary messages that edit the warps
+	//! messages are little-endian: a Header followed by a payload that depends on the opcode
+	class RemoteControl
+	{
+	public:
+		typedef enum Opcode
+		{
+			//! count x PointItem, normalized positions
+			OP_SET_POINTS = 1,
+			//! count x PointItem, normalized offsets
+			OP_MOVE_POINTS,
+			//! 4 x float, left top right bottom
+			OP_SET_EDGES,
+			//! 3 x float, rgb
+			OP_SET_GAMMA,
+			//! 3 x float, rgb
+			OP_SET_LUMINANCE,
+			//! 1 x float
+			OP_SET_EXPONENT,
+			//! 1 x float
+			OP_SET_BRIGHTNESS,
+			//! GridItem, bilinear warps only
+			OP_SET_GRID,
+			//! header only, sent back to the reply port with the sequence of the applied message
+			OP_ACK
+		} Opcode;
+
+		typedef struct Header
+		{
+			uint32_t magic;
+			uint8_t version;
+			uint8_t opcode;
+			//! port to send the OP_ACK to on the sender's address, 0 for none
+			uint16_t replyPort;
+			uint32_t sequence;
+			uint16_t warpIndex;
+			//! number of items in the payload
+			uint16_t count;
+		} Header;
+
+		typedef struct PointItem
+		{
+			uint16_t index;
+			uint16_t reserved;
+			float x;
+			float y;
+		} PointItem;
+
+		typedef struct GridItem
+		{
+			uint16_t columns;
+			uint16_t rows;
+		} GridItem;
+
+		static const uint32_t MAGIC = 0x5257464F; // "OFWR"
+		static const uint8_t VERSION = 1;
+		static const int DEFAULT_PORT = 9040;
+		static const size_t MAX_MESSAGE_SIZE = 65507;
+		static const size_t MAX_POINTS_PER_MESSAGE = (MAX_MESSAGE_SIZE - sizeof(Header)) / sizeof(PointItem);
+		static const size_t DEFAULT_MAX_GRID_SIZE = 256;
+
+		RemoteControl();
+		~RemoteControl();
+
+		//! start listening on the port, only reachable from this machine unless allowRemote is set
+		//! with allowRemote, anyone on the network can edit the warps and have acks sent to any of their ports
+		bool setup(int port = DEFAULT_PORT, bool allowRemote = false);
+		//! stop listening
+		void close();
+		//! return whether the socket is open
+		bool isConnected() const;
+
+		//! set the maximum number of messages received per frame, valid or not, so that a flood cannot stall drawing
+		void setMaxMessagesPerFrame(size_t maxMessagesPerFrame);
+		size_t getMaxMessagesPerFrame() const;
+
+		//! set the maximum number of control points along each axis that OP_SET_GRID accepts, larger grids are rejected
+		void setMaxGridSize(size_t maxGridSize);
+		size_t getMaxGridSize() const;
+
+		//! receive and apply all pending messages, call once per frame on the thread that draws the warps
+		//! return the number of messages applied
+		size_t update(const std::vector<std::shared_ptr<WarpBase>> & warps);
+
+		//! return the number of messages applied since setup
+		size_t getNumMessagesApplied() const;
+		//! return the number of messages dropped as malformed since setup
+		size_t getNumMessagesRejected() const;
+
+		//! start a new message in the buffer, for clients
+		static void writeHeader(std::vector<char> & buffer, Opcode opcode, uint16_t warpIndex, uint32_t sequence, uint16_t replyPort = 0);
+		//! append a point to an OP_SET_POINTS or OP_MOVE_POINTS message
+		static void writePoint(std::vector<char> & buffer, uint16_t index, const glm::vec2 & pos);
+		//! append float values to a parameter message
+		static void writeValues(std::vector<char> & buffer, const float * values, size_t count);
+		//! append the grid size to an OP_SET_GRID message
+		static void writeGrid(std::vector<char> & buffer, uint16_t columns, uint16_t rows);
+
+		//! read the header of a message, return false if it is not a valid message
+		static bool readHeader(const char * data, size_t size, Header & header);
+
+	protected:
+		//! apply a single message, return false if it is malformed
+		bool applyMessage(const char * data, size_t size, const std::vector<std::shared_ptr<WarpBase>> & warps, Header & header);
+		//! send an OP_ACK for the header to the reply port of the last sender
+		void sendAck(const Header & header);
+
+	protected:
+		//! platform UDP socket, defined in the source file so that the header does not pull in networking
+		class Socket;
+		std::unique_ptr<Socket> socket;
+
+		size_t maxMessagesPerFrame;
+		size_t maxGridSize;
+		size_t numMessagesApplied;
+		size_t numMessagesRejected;
+
+		std::vector<char> receiveBuffer;
+		std::vector<char> ackBuffer;
+	};
+}
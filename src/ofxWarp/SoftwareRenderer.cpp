@@ -0,0 +1,350 @@
+#include "SoftwareRenderer.h"
+
+#include <cstring>
+#include <thread>
+
+#include "ofLog.h"
+#include "ofMath.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OFXWARP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ofxWarp
+{
+	namespace
+	{
+		//--------------------------------------------------------------
+		// Sample RGBA pixels with bilinear filtering and clamping to the edges, like GL_LINEAR and GL_CLAMP_TO_EDGE, pos in pixels.
+		inline glm::vec4 sampleBilinear(const uint8_t * pixels, int width, int height, const glm::vec2 & pos)
+		{
+			// Texel centers are at half pixels.
+			auto x = pos.x - 0.5f;
+			auto y = pos.y - 0.5f;
+			auto fx = floorf(x);
+			auto fy = floorf(y);
+			auto tx = x - fx;
+			auto ty = y - fy;
+			auto ix = (int)fx;
+			auto iy = (int)fy;
+			auto x0 = MAX(MIN(ix, width - 1), 0);
+			auto y0 = MAX(MIN(iy, height - 1), 0);
+			auto x1 = MAX(MIN(ix + 1, width - 1), 0);
+			auto y1 = MAX(MIN(iy + 1, height - 1), 0);
+
+			const uint8_t * texels[4] =
+			{
+				pixels + (y0 * width + x0) * 4,
+				pixels + (y0 * width + x1) * 4,
+				pixels + (y1 * width + x0) * 4,
+				pixels + (y1 * width + x1) * 4
+			};
+
+			glm::vec4 color;
+#ifdef OFXWARP_USE_SSE2
+			// Widen each RGBA texel to 4 floats and interpolate all channels at once.
+			auto zero = _mm_setzero_si128();
+			__m128 values[4];
+			for (int i = 0; i < 4; ++i)
+			{
+				int32_t texel;
+				memcpy(&texel, texels[i], sizeof(texel));
+				values[i] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(texel), zero), zero));
+			}
+			auto weightX = _mm_set1_ps(tx);
+			auto top = _mm_add_ps(values[0], _mm_mul_ps(weightX, _mm_sub_ps(values[1], values[0])));
+			auto bottom = _mm_add_ps(values[2], _mm_mul_ps(weightX, _mm_sub_ps(values[3], values[2])));
+			auto result = _mm_add_ps(top, _mm_mul_ps(_mm_set1_ps(ty), _mm_sub_ps(bottom, top)));
+			_mm_storeu_ps(&color[0], result);
+#else
+			for (int c = 0; c < 4; ++c)
+			{
+				auto top = texels[0][c] + tx * (texels[1][c] - texels[0][c]);
+				auto bottom = texels[2][c] + tx * (texels[3][c] - texels[2][c]);
+				color[c] = top + ty * (bottom - top);
+			}
+#endif
+			return color;
+		}
+
+		//--------------------------------------------------------------
+		// Twice the signed area of the triangle abp, positive when p is on the inner side of ab for positive triangles.
+		inline float edgeFunction(const glm::vec2 & a, const glm::vec2 & b, const glm::vec2 & p)
+		{
+			return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+		}
+	}
+
+	//--------------------------------------------------------------
+	SoftwareRenderer::SoftwareRenderer()
+		: numThreads(0)
+		, tileSize(64)
+		, sourceData(nullptr)
+		, sourceWidth(0)
+		, sourceHeight(0)
+		, sourceOffset(0.0f)
+		, sourceScale(0.0f)
+		, numTilesX(0)
+		, numTilesY(0)
+		, nextTile(0)
+	{}
+
+	//--------------------------------------------------------------
+	void SoftwareRenderer::setNumThreads(size_t numThreads)
+	{
+		this->numThreads = numThreads;
+	}
+
+	//--------------------------------------------------------------
+	size_t SoftwareRenderer::getNumThreads() const
+	{
+		return this->numThreads;
+	}
+
+	//--------------------------------------------------------------
+	void SoftwareRenderer::setTileSize(size_t tileSize)
+	{
+		this->tileSize = MAX(tileSize, (size_t)8);
+	}
+
+	//--------------------------------------------------------------
+	size_t SoftwareRenderer::getTileSize() const
+	{
+		return this->tileSize;
+	}
+
+	//--------------------------------------------------------------
+	bool SoftwareRenderer::render(const ofPixels & source, std::shared_ptr<WarpBase> warp, ofPixels & target)
+	{
+		return this->render(source, ofRectangle(0.0f, 0.0f, source.getWidth(), source.getHeight()), warp, target);
+	}
+
+	//--------------------------------------------------------------
+	bool SoftwareRenderer::render(const ofPixels & source, const ofRectangle & srcArea, std::shared_ptr<WarpBase> warp, ofPixels & target)
+	{
+		if (!source.isAllocated() || !warp) return false;
+
+		// Sample from RGBA, so that each texel is a single 32 bit load.
+		if (source.getNumChannels() == 4)
+		{
+			this->sourceData = source.getData();
+		}
+		else
+		{
+			this->sourceRgba = source;
+			this->sourceRgba.setImageType(OF_IMAGE_COLOR_ALPHA);
+			this->sourceData = this->sourceRgba.getData();
+		}
+		this->sourceWidth = source.getWidth();
+		this->sourceHeight = source.getHeight();
+		this->sourceOffset = glm::vec2(srcArea.getMin());
+		this->sourceScale = glm::vec2(srcArea.getWidth(), srcArea.getHeight());
+
+		if (!target.isAllocated())
+		{
+			const auto & windowSize = warp->getWindowSize();
+			target.allocate(windowSize.x, windowSize.y, (source.getNumChannels() == 4) ? OF_PIXELS_RGBA : OF_PIXELS_RGB);
+			target.set(0);
+		}
+		if (target.getNumChannels() != 3 && target.getNumChannels() != 4)
+		{
+			ofLogError("SoftwareRenderer::render") << "Target must have 3 or 4 channels, got " << target.getNumChannels();
+			return false;
+		}
+
+		// Set up the triangles in window space.
+		warp->getMesh(this->positions, this->texCoords, this->indices);
+
+		auto targetWidth = (int)target.getWidth();
+		auto targetHeight = (int)target.getHeight();
+		this->triangles.clear();
+		for (size_t i = 0; i + 2 < this->indices.size(); i += 3)
+		{
+			Triangle triangle;
+			auto visible = true;
+			for (int j = 0; j < 3; ++j)
+			{
+				const auto & pos = this->positions[this->indices[i + j]];
+				const auto & texCoord = this->texCoords[this->indices[i + j]];
+
+				// Vertices behind the projection would need clipping, the warps never produce them.
+				if (pos.z <= 0.0f)
+				{
+					visible = false;
+					break;
+				}
+
+				auto invW = 1.0f / pos.z;
+				triangle.pos[j] = glm::vec2(pos.x, pos.y) * invW;
+				triangle.attributes[j] = glm::vec3(texCoord * invW, invW);
+			}
+			if (!visible) continue;
+
+			// Both windings are drawn, as there is no face culling.
+			triangle.area = edgeFunction(triangle.pos[0], triangle.pos[1], triangle.pos[2]);
+			if (triangle.area < 0.0f)
+			{
+				std::swap(triangle.pos[1], triangle.pos[2]);
+				std::swap(triangle.attributes[1], triangle.attributes[2]);
+				triangle.area = -triangle.area;
+			}
+			if (triangle.area < 1e-8f) continue;
+
+			// Pixels are covered when their center is inside.
+			auto minPos = glm::min(glm::min(triangle.pos[0], triangle.pos[1]), triangle.pos[2]);
+			auto maxPos = glm::max(glm::max(triangle.pos[0], triangle.pos[1]), triangle.pos[2]);
+			triangle.minX = MAX((int)floorf(minPos.x - 0.5f), 0);
+			triangle.minY = MAX((int)floorf(minPos.y - 0.5f), 0);
+			triangle.maxX = MIN((int)ceilf(maxPos.x - 0.5f), targetWidth - 1);
+			triangle.maxY = MIN((int)ceilf(maxPos.y - 0.5f), targetHeight - 1);
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) continue;
+
+			this->triangles.push_back(triangle);
+		}
+
+		// Bin the triangles into tiles, counting first to lay them out contiguously, in drawing order.
+		this->numTilesX = (targetWidth + this->tileSize - 1) / this->tileSize;
+		this->numTilesY = (targetHeight + this->tileSize - 1) / this->tileSize;
+		auto numTiles = this->numTilesX * this->numTilesY;
+		this->tileStarts.assign(numTiles + 1, 0);
+		for (const auto & triangle : this->triangles)
+		{
+			for (auto y = triangle.minY / this->tileSize; y <= triangle.maxY / this->tileSize; ++y)
+			{
+				for (auto x = triangle.minX / this->tileSize; x <= triangle.maxX / this->tileSize; ++x)
+				{
+					++this->tileStarts[y * this->numTilesX + x + 1];
+				}
+			}
+		}
+		for (size_t i = 0; i < numTiles; ++i)
+		{
+			this->tileStarts[i + 1] += this->tileStarts[i];
+		}
+		std::vector<uint32_t> tileEnds(this->tileStarts.begin(), this->tileStarts.end() - 1);
+		this->tileTriangles.resize(this->tileStarts.back());
+		for (size_t i = 0; i < this->triangles.size(); ++i)
+		{
+			const auto & triangle = this->triangles[i];
+			for (auto y = triangle.minY / this->tileSize; y <= triangle.maxY / this->tileSize; ++y)
+			{
+				for (auto x = triangle.minX / this->tileSize; x <= triangle.maxX / this->tileSize; ++x)
+				{
+					this->tileTriangles[tileEnds[y * this->numTilesX + x]++] = i;
+				}
+			}
+		}
+
+		// Same parameters as the shader uniforms.
+		Shading shading;
+		shading.edges = warp->getEdges() * 0.5f;
+		shading.blend = (shading.edges.x > 0.0f || shading.edges.y > 0.0f || shading.edges.z > 0.0f || shading.edges.w > 0.0f);
+		shading.luminance = warp->getLuminance();
+		shading.exponent = warp->getExponent();
+		shading.gamma = warp->getGamma();
+		shading.brightness = warp->getBrightness();
+
+		// Threads pull tiles until there are none left, the calling thread takes part.
+		auto numThreads = this->numThreads ? this->numThreads : MAX(1u, std::thread::hardware_concurrency());
+		numThreads = MIN(numThreads, numTiles);
+		this->nextTile = 0;
+
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < numThreads; ++i)
+		{
+			threads.emplace_back(&SoftwareRenderer::renderTiles, this, std::cref(shading), std::ref(target));
+		}
+		this->renderTiles(shading, target);
+		for (auto & thread : threads)
+		{
+			thread.join();
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void SoftwareRenderer::renderTiles(const Shading & shading, ofPixels & target)
+	{
+		auto numTiles = this->numTilesX * this->numTilesY;
+		for (auto tile = this->nextTile++; tile < numTiles; tile = this->nextTile++)
+		{
+			int x0 = (tile % this->numTilesX) * this->tileSize;
+			int y0 = (tile / this->numTilesX) * this->tileSize;
+			int x1 = MIN(x0 + (int)this->tileSize, (int)target.getWidth()) - 1;
+			int y1 = MIN(y0 + (int)this->tileSize, (int)target.getHeight()) - 1;
+
+			for (auto i = this->tileStarts[tile]; i < this->tileStarts[tile + 1]; ++i)
+			{
+				this->renderTriangle(this->triangles[this->tileTriangles[i]], shading, x0, y0, x1, y1, target);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	void SoftwareRenderer::renderTriangle(const Triangle & triangle, const Shading & shading, int x0, int y0, int x1, int y1, ofPixels & target) const
+	{
+		x0 = MAX(x0, triangle.minX);
+		y0 = MAX(y0, triangle.minY);
+		x1 = MIN(x1, triangle.maxX);
+		y1 = MIN(y1, triangle.maxY);
+
+		const auto & v0 = triangle.pos[0];
+		const auto & v1 = triangle.pos[1];
+		const auto & v2 = triangle.pos[2];
+		auto invArea = 1.0f / triangle.area;
+
+		// Edge functions step by a constant per pixel along a row.
+		auto step0 = -(v2.y - v1.y);
+		auto step1 = -(v0.y - v2.y);
+		auto step2 = -(v1.y - v0.y);
+
+		auto numChannels = target.getNumChannels();
+		auto stride = target.getWidth() * numChannels;
+		auto data = target.getData();
+
+		for (auto y = y0; y <= y1; ++y)
+		{
+			auto start = glm::vec2(x0 + 0.5f, y + 0.5f);
+			auto e0 = edgeFunction(v1, v2, start);
+			auto e1 = edgeFunction(v2, v0, start);
+			auto e2 = edgeFunction(v0, v1, start);
+
+			auto dst = data + y * stride + x0 * numChannels;
+			for (auto x = x0; x <= x1; ++x, e0 += step0, e1 += step1, e2 += step2, dst += numChannels)
+			{
+				// Shared edges are drawn by both triangles, which is harmless as they interpolate to the same color.
+				if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f) continue;
+
+				// Perspective correct content coordinates.
+				auto attributes = (e0 * triangle.attributes[0] + e1 * triangle.attributes[1] + e2 * triangle.attributes[2]) * invArea;
+				auto uv = glm::vec2(attributes.x, attributes.y) / attributes.z;
+
+				auto color = sampleBilinear(this->sourceData, this->sourceWidth, this->sourceHeight, this->sourceOffset + uv * this->sourceScale);
+
+				if (shading.blend)
+				{
+					auto a = WarpBase::evaluateEdges(uv, shading.edges);
+					if (a < 1.0f)
+					{
+						auto blend = WarpBase::evaluateBlendCurve(a, shading.luminance, shading.exponent, shading.gamma);
+						color.r *= blend.r;
+						color.g *= blend.g;
+						color.b *= blend.b;
+					}
+				}
+
+				// Brightness tints the color, not the alpha.
+				color.r *= shading.brightness;
+				color.g *= shading.brightness;
+				color.b *= shading.brightness;
+
+				for (size_t c = 0; c < numChannels; ++c)
+				{
+					dst[c] = (uint8_t)(ofClamp(color[c], 0.0f, 255.0f) + 0.5f);
+				}
+			}
+		}
+	}
+}
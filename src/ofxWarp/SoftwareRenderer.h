@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+
+#include "ofPixels.h"
+#include "ofRectangle.h"
+#include "ofVectorMath.h"
+
+#include "WarpBase.h"
+
+namespace ofxWarp
+{
+	//! multithreaded CPU renderer that draws pixels through a warp the way the warp shaders do, for headless previews and reference images
+	class SoftwareRenderer
+	{
+	public:
+		SoftwareRenderer();
+
+		//! set the number of rendering threads, 0 to use all cores
+		void setNumThreads(size_t numThreads);
+		size_t getNumThreads() const;
+
+		//! set the size of the square tiles the target is split into, in pixels
+		void setTileSize(size_t tileSize);
+		size_t getTileSize() const;
+
+		//! render the source through the warp into the target, which is allocated to the window size of the warp and cleared if it is empty
+		//! pixels outside of the warp are left untouched, blend curves are evaluated exactly rather than through the lookup texture
+		bool render(const ofPixels & source, std::shared_ptr<WarpBase> warp, ofPixels & target);
+		//! render the area of the source, in pixels, through the warp into the target, like WarpBase::draw() with source bounds
+		bool render(const ofPixels & source, const ofRectangle & srcArea, std::shared_ptr<WarpBase> warp, ofPixels & target);
+
+	protected:
+		typedef struct Triangle
+		{
+			//! window positions of the vertices
+			glm::vec2 pos[3];
+			//! content coordinates and 1 over w of the vertices, divided by w for perspective correct interpolation
+			glm::vec3 attributes[3];
+			//! twice the signed area, positive after the winding is normalized
+			float area;
+			//! bounds in pixels, clipped to the target
+			int minX;
+			int minY;
+			int maxX;
+			int maxY;
+		} Triangle;
+
+		//! shading parameters of the warp, copied before the threads start
+		typedef struct Shading
+		{
+			bool blend;
+			glm::vec4 edges;
+			glm::vec3 luminance;
+			float exponent;
+			glm::vec3 gamma;
+			float brightness;
+		} Shading;
+
+		//! render tiles until there are none left, called from every thread
+		void renderTiles(const Shading & shading, ofPixels & target);
+		//! rasterize the triangle within the tile bounds
+		void renderTriangle(const Triangle & triangle, const Shading & shading, int x0, int y0, int x1, int y1, ofPixels & target) const;
+
+	protected:
+		size_t numThreads;
+		size_t tileSize;
+
+		//! source converted to RGBA when it has another layout
+		ofPixels sourceRgba;
+		const uint8_t * sourceData;
+		int sourceWidth;
+		int sourceHeight;
+		//! maps content coordinates to the area of the source, in pixels
+		glm::vec2 sourceOffset;
+		glm::vec2 sourceScale;
+
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> texCoords;
+		std::vector<uint32_t> indices;
+		std::vector<Triangle> triangles;
+
+		//! triangles overlapping each tile, in drawing order
+		size_t numTilesX;
+		size_t numTilesY;
+		std::vector<uint32_t> tileStarts;
+		std::vector<uint32_t> tileTriangles;
+		std::atomic<size_t> nextTile;
+	};
+}
@@ -0,0 +1,497 @@
+#include "StructuredLight.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "Homography.h"
+#include "WarpPerspectiveBilinear.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OFXWARP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ofxWarp
+{
+	namespace
+	{
+		//--------------------------------------------------------------
+		size_t getNumBits(size_t size)
+		{
+			size_t numBits = 1;
+			while (((size_t)1 << numBits) < size)
+			{
+				++numBits;
+			}
+			return numBits;
+		}
+
+		//--------------------------------------------------------------
+		// Shift the bit of a pattern pair into the codes, and clear the valid flag where the pair has too little contrast.
+		void decodePlane(const uint8_t * pattern, const uint8_t * inverse, size_t width, uint8_t threshold, uint16_t * codes, uint8_t * valid)
+		{
+			size_t x = 0;
+
+#ifdef OFXWARP_USE_SSE2
+			const auto zero = _mm_setzero_si128();
+			const auto one = _mm_set1_epi8(1);
+			const auto minContrast = _mm_set1_epi8((char)threshold);
+			for (; x + 16 <= width; x += 16)
+			{
+				auto p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern + x));
+				auto q = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inverse + x));
+
+				auto pq = _mm_subs_epu8(p, q);
+				auto qp = _mm_subs_epu8(q, p);
+
+				// Bit is set where the pattern is brighter than its inverse.
+				auto bits = _mm_andnot_si128(_mm_cmpeq_epi8(pq, zero), one);
+
+				// Valid where |p - q| >= threshold.
+				auto contrast = _mm_or_si128(pq, qp);
+				auto ok = _mm_cmpeq_epi8(_mm_subs_epu8(minContrast, contrast), zero);
+				auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(valid + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(valid + x), _mm_and_si128(v, ok));
+
+				auto c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + x));
+				auto c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + x + 8));
+				c0 = _mm_or_si128(_mm_slli_epi16(c0, 1), _mm_unpacklo_epi8(bits, zero));
+				c1 = _mm_or_si128(_mm_slli_epi16(c1, 1), _mm_unpackhi_epi8(bits, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(codes + x), c0);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(codes + x + 8), c1);
+			}
+#endif
+
+			for (; x < width; ++x)
+			{
+				auto p = pattern[x];
+				auto q = inverse[x];
+				auto contrast = (p > q) ? (p - q) : (q - p);
+				if (contrast < threshold)
+				{
+					valid[x] = 0;
+				}
+				codes[x] = (codes[x] << 1) | (p > q ? 1 : 0);
+			}
+		}
+
+		//--------------------------------------------------------------
+		// Convert Gray codes to binary with a prefix xor.
+		void grayToBinary(uint16_t * codes, size_t width)
+		{
+			size_t x = 0;
+
+#ifdef OFXWARP_USE_SSE2
+			for (; x + 8 <= width; x += 8)
+			{
+				auto g = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + x));
+				g = _mm_xor_si128(g, _mm_srli_epi16(g, 1));
+				g = _mm_xor_si128(g, _mm_srli_epi16(g, 2));
+				g = _mm_xor_si128(g, _mm_srli_epi16(g, 4));
+				g = _mm_xor_si128(g, _mm_srli_epi16(g, 8));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(codes + x), g);
+			}
+#endif
+
+			for (; x < width; ++x)
+			{
+				uint16_t g = codes[x];
+				g ^= (g >> 1);
+				g ^= (g >> 2);
+				g ^= (g >> 4);
+				g ^= (g >> 8);
+				codes[x] = g;
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	bool StructuredLight::Decoded::lookup(const glm::vec2 & cameraPos, int radius, glm::vec2 & content) const
+	{
+		auto cx = (int)floorf(cameraPos.x);
+		auto cy = (int)floorf(cameraPos.y);
+
+		auto sum = glm::vec2(0.0f);
+		auto count = 0;
+		for (auto y = MAX(0, cy - radius); y <= MIN((int)this->height - 1, cy + radius); ++y)
+		{
+			for (auto x = MAX(0, cx - radius); x <= MIN((int)this->width - 1, cx + radius); ++x)
+			{
+				auto i = y * this->width + x;
+				if (!this->valid[i] || this->codeX[i] >= this->contentWidth || this->codeY[i] >= this->contentHeight) continue;
+
+				// Use pixel centers.
+				sum += glm::vec2(this->codeX[i] + 0.5f, this->codeY[i] + 0.5f);
+				++count;
+			}
+		}
+
+		if (count == 0) return false;
+
+		content = sum / (float)count;
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	StructuredLight::StructuredLight()
+		: width(0)
+		, height(0)
+		, numBitsX(0)
+		, numBitsY(0)
+		, threshold(16)
+		, numThreads(0)
+		, sampleStep(4)
+		, patternIndex(-1)
+	{}
+
+	//--------------------------------------------------------------
+	void StructuredLight::setup(size_t width, size_t height)
+	{
+		this->width = width;
+		this->height = height;
+		this->numBitsX = getNumBits(width);
+		this->numBitsY = getNumBits(height);
+		this->patternIndex = -1;
+	}
+
+	//--------------------------------------------------------------
+	size_t StructuredLight::getNumPatterns() const
+	{
+		return (this->numBitsX + this->numBitsY) * 2;
+	}
+
+	//--------------------------------------------------------------
+	size_t StructuredLight::getNumBitsX() const
+	{
+		return this->numBitsX;
+	}
+
+	//--------------------------------------------------------------
+	size_t StructuredLight::getNumBitsY() const
+	{
+		return this->numBitsY;
+	}
+
+	//--------------------------------------------------------------
+	bool StructuredLight::getPatternBit(size_t index, size_t x, size_t y) const
+	{
+		auto pair = index / 2;
+		auto inverse = (index % 2) == 1;
+
+		bool bit;
+		if (pair < this->numBitsX)
+		{
+			auto gray = x ^ (x >> 1);
+			bit = (gray >> (this->numBitsX - 1 - pair)) & 1;
+		}
+		else
+		{
+			pair -= this->numBitsX;
+			auto gray = y ^ (y >> 1);
+			bit = (gray >> (this->numBitsY - 1 - pair)) & 1;
+		}
+
+		return bit != inverse;
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::getPattern(size_t index, ofPixels & pixels) const
+	{
+		pixels.allocate(this->width, this->height, OF_PIXELS_GRAY);
+		auto data = pixels.getData();
+
+		if (index / 2 < this->numBitsX)
+		{
+			// Column patterns, fill one row and copy it down.
+			for (size_t x = 0; x < this->width; ++x)
+			{
+				data[x] = this->getPatternBit(index, x, 0) ? 255 : 0;
+			}
+			for (size_t y = 1; y < this->height; ++y)
+			{
+				memcpy(data + y * this->width, data, this->width);
+			}
+		}
+		else
+		{
+			// Row patterns, every row is a single value.
+			for (size_t y = 0; y < this->height; ++y)
+			{
+				memset(data + y * this->width, this->getPatternBit(index, 0, y) ? 255 : 0, this->width);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::drawPattern(size_t index, std::shared_ptr<WarpBase> warp)
+	{
+		if (index != this->patternIndex)
+		{
+			this->getPattern(index, this->patternPixels);
+			if (!this->patternTexture.isAllocated() || this->patternTexture.getWidth() != this->width || this->patternTexture.getHeight() != this->height)
+			{
+				this->patternTexture.allocate(this->patternPixels, false);
+				this->patternTexture.setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+			}
+			this->patternTexture.loadData(this->patternPixels);
+			this->patternIndex = index;
+		}
+
+		// Blending and brightness scale both the pattern and its inverse, so they do not affect decoding.
+		warp->draw(this->patternTexture);
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::setThreshold(uint8_t threshold)
+	{
+		this->threshold = threshold;
+	}
+
+	//--------------------------------------------------------------
+	uint8_t StructuredLight::getThreshold() const
+	{
+		return this->threshold;
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::setNumThreads(size_t numThreads)
+	{
+		this->numThreads = numThreads;
+	}
+
+	//--------------------------------------------------------------
+	size_t StructuredLight::getNumThreads() const
+	{
+		return this->numThreads;
+	}
+
+	//--------------------------------------------------------------
+	bool StructuredLight::decode(const std::vector<ofPixels> & captures, Decoded & decoded) const
+	{
+		if (captures.size() != this->getNumPatterns())
+		{
+			ofLogWarning("StructuredLight::decode") << "Expected " << this->getNumPatterns() << " captures, got " << captures.size();
+			return false;
+		}
+
+		auto cameraWidth = captures[0].getWidth();
+		auto cameraHeight = captures[0].getHeight();
+
+		// Decode from grayscale planes, converting captures where needed.
+		std::vector<ofPixels> converted;
+		converted.reserve(captures.size());
+		std::vector<const uint8_t *> planes;
+		for (const auto & capture : captures)
+		{
+			if (capture.getWidth() != cameraWidth || capture.getHeight() != cameraHeight)
+			{
+				ofLogWarning("StructuredLight::decode") << "All captures must have the same size";
+				return false;
+			}
+
+			if (capture.getNumChannels() == 1)
+			{
+				planes.push_back(capture.getData());
+			}
+			else
+			{
+				converted.push_back(capture);
+				converted.back().setImageType(OF_IMAGE_GRAYSCALE);
+				planes.push_back(converted.back().getData());
+			}
+		}
+
+		decoded.width = cameraWidth;
+		decoded.height = cameraHeight;
+		decoded.contentWidth = this->width;
+		decoded.contentHeight = this->height;
+		decoded.codeX.resize(cameraWidth * cameraHeight);
+		decoded.codeY.resize(cameraWidth * cameraHeight);
+		decoded.valid.resize(cameraWidth * cameraHeight);
+
+		// Split the rows between threads, the calling thread takes the last chunk.
+		auto numThreads = this->numThreads ? this->numThreads : MAX(1u, std::thread::hardware_concurrency());
+		numThreads = MIN(numThreads, cameraHeight);
+		auto rowsPerThread = (cameraHeight + numThreads - 1) / numThreads;
+
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i + 1 < numThreads; ++i)
+		{
+			auto y0 = i * rowsPerThread;
+			auto y1 = MIN(cameraHeight, y0 + rowsPerThread);
+			threads.emplace_back(&StructuredLight::decodeRows, this, std::cref(planes), y0, y1, std::ref(decoded));
+		}
+		this->decodeRows(planes, MIN(cameraHeight, (numThreads - 1) * rowsPerThread), cameraHeight, decoded);
+
+		for (auto & thread : threads)
+		{
+			thread.join();
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::decodeRows(const std::vector<const uint8_t *> & planes, size_t y0, size_t y1, Decoded & decoded) const
+	{
+		auto width = decoded.width;
+		auto numPairs = this->numBitsX + this->numBitsY;
+
+		// Go row by row, so the codes stay in cache while all planes are accumulated.
+		for (auto y = y0; y < y1; ++y)
+		{
+			auto offset = y * width;
+			auto codeX = decoded.codeX.data() + offset;
+			auto codeY = decoded.codeY.data() + offset;
+			auto valid = decoded.valid.data() + offset;
+
+			memset(codeX, 0, width * sizeof(uint16_t));
+			memset(codeY, 0, width * sizeof(uint16_t));
+			memset(valid, 1, width);
+
+			for (size_t i = 0; i < numPairs; ++i)
+			{
+				auto codes = (i < this->numBitsX) ? codeX : codeY;
+				decodePlane(planes[i * 2] + offset, planes[i * 2 + 1] + offset, width, this->threshold, codes, valid);
+			}
+
+			grayToBinary(codeX, width);
+			grayToBinary(codeY, width);
+		}
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::getCorrespondences(const Decoded & decoded, const glm::vec2 cameraQuad[4], size_t step, std::vector<glm::vec2> & content, std::vector<glm::vec2> & screen) const
+	{
+		content.clear();
+		screen.clear();
+
+		// The target is a plane seen by the camera, so content maps to the camera quad through a homography.
+		glm::dvec2 quad[4];
+		auto minPos = glm::vec2(std::numeric_limits<float>::max());
+		auto maxPos = glm::vec2(std::numeric_limits<float>::lowest());
+		for (auto i = 0; i < 4; ++i)
+		{
+			quad[i] = glm::dvec2(cameraQuad[i]);
+			minPos = glm::min(minPos, cameraQuad[i]);
+			maxPos = glm::max(maxPos, cameraQuad[i]);
+		}
+		auto cameraToContent = Homography::invert(Homography::squareToQuad(quad));
+		auto contentSize = glm::vec2(decoded.contentWidth, decoded.contentHeight);
+
+		step = MAX((size_t)1, step);
+		auto x0 = (size_t)MAX(0.0f, floorf(minPos.x));
+		auto y0 = (size_t)MAX(0.0f, floorf(minPos.y));
+		auto x1 = (size_t)MIN((float)decoded.width, ceilf(maxPos.x));
+		auto y1 = (size_t)MIN((float)decoded.height, ceilf(maxPos.y));
+		for (auto y = y0; y < y1; y += step)
+		{
+			for (auto x = x0; x < x1; x += step)
+			{
+				auto i = y * decoded.width + x;
+				if (!decoded.valid[i] || decoded.codeX[i] >= decoded.contentWidth || decoded.codeY[i] >= decoded.contentHeight) continue;
+
+				auto uv = Homography::transform(cameraToContent, glm::dvec2(x + 0.5, y + 0.5));
+				if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0) continue;
+
+				// With the warp reset, normalized content coordinates are normalized screen coordinates.
+				content.push_back(glm::vec2(uv));
+				screen.push_back(glm::vec2(decoded.codeX[i] + 0.5f, decoded.codeY[i] + 0.5f) / contentSize);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	size_t StructuredLight::fitGrid(const Decoded & decoded, const glm::vec2 cameraQuad[4], std::shared_ptr<WarpBase> warp, int radius, GridFitter::Result * result) const
+	{
+		auto numControlsY = warp->getNumControlsY();
+		auto numControlPoints = warp->getNumControlPoints();
+		auto contentSize = glm::vec2(decoded.contentWidth, decoded.contentHeight);
+
+		size_t numFitted = 0;
+		auto warpBilinear = std::dynamic_pointer_cast<WarpBilinear>(warp);
+
+		// Perspective corners go first, WarpPerspectiveBilinear fits its grid through the perspective they define.
+		if (!warpBilinear || std::dynamic_pointer_cast<WarpPerspectiveBilinear>(warp))
+		{
+			// WarpPerspective stores its corners in quad order, WarpPerspectiveBilinear takes them at the corners of its grid.
+			size_t perspectiveIndices[4] = { 0, 1, 2, 3 };
+			size_t gridIndices[4] = { 0, numControlPoints - numControlsY, numControlPoints - 1, numControlsY - 1 };
+			const auto indices = warpBilinear ? gridIndices : perspectiveIndices;
+			for (auto i = 0; i < 4; ++i)
+			{
+				glm::vec2 content;
+				if (decoded.lookup(cameraQuad[i], radius, content))
+				{
+					warp->setControlPoint(indices[i], content / contentSize);
+					++numFitted;
+				}
+			}
+		}
+
+		if (warpBilinear)
+		{
+			std::vector<glm::vec2> content;
+			std::vector<glm::vec2> screen;
+			this->getCorrespondences(decoded, cameraQuad, this->sampleStep, content, screen);
+			if (!content.empty() && this->gridFitter.fit(warpBilinear, content, screen, result))
+			{
+				numFitted = numControlPoints;
+			}
+		}
+
+		return numFitted;
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::setGridFitter(const GridFitter & gridFitter)
+	{
+		this->gridFitter = gridFitter;
+	}
+
+	//--------------------------------------------------------------
+	GridFitter & StructuredLight::getGridFitter()
+	{
+		return this->gridFitter;
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::setSampleStep(size_t sampleStep)
+	{
+		this->sampleStep = MAX(sampleStep, (size_t)1);
+	}
+
+	//--------------------------------------------------------------
+	size_t StructuredLight::getSampleStep() const
+	{
+		return this->sampleStep;
+	}
+
+	//--------------------------------------------------------------
+	void StructuredLight::simulateCapture(size_t index, const glm::dmat3 & cameraToContent, size_t cameraWidth, size_t cameraHeight, ofPixels & capture, float gain, float ambient, float noise) const
+	{
+		capture.allocate(cameraWidth, cameraHeight, OF_PIXELS_GRAY);
+		auto data = capture.getData();
+
+		for (size_t y = 0; y < cameraHeight; ++y)
+		{
+			for (size_t x = 0; x < cameraWidth; ++x)
+			{
+				auto content = Homography::transform(cameraToContent, glm::dvec2(x + 0.5, y + 0.5));
+
+				auto value = ambient;
+				if (content.x >= 0.0 && content.y >= 0.0 && content.x < this->width && content.y < this->height)
+				{
+					value += this->getPatternBit(index, (size_t)content.x, (size_t)content.y) ? gain : 0.0f;
+				}
+
+				// Deterministic noise, so runs are repeatable.
+				uint32_t hash = (x * 73856093u) ^ (y * 19349663u) ^ (index * 83492791u);
+				hash = hash * 1103515245u + 12345u;
+				value += noise * (((hash >> 8) & 0xFFFF) / 32767.5f - 1.0f);
+
+				data[y * cameraWidth + x] = (uint8_t)ofClamp(value * 255.0f + 0.5f, 0.0f, 255.0f);
+			}
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ofPixels.h"
+#include "ofTexture.h"
+#include "ofVectorMath.h"
+
+#include "GridFitter.h"
+#include "WarpBase.h"
+
+namespace ofxWarp
+{
+	//! Gray code structured light patterns, decoding of camera captures and fitting of warp control points
+	class StructuredLight
+	{
+	public:
+		//! per camera pixel result of a decode, in the content space of the warp the patterns were drawn through
+		typedef struct Decoded
+		{
+			//! size of the camera images
+			size_t width;
+			size_t height;
+			//! size of the patterns
+			size_t contentWidth;
+			size_t contentHeight;
+			//! decoded content column and row for each camera pixel
+			std::vector<uint16_t> codeX;
+			std::vector<uint16_t> codeY;
+			//! 0 where any pattern pair did not have enough contrast
+			std::vector<uint8_t> valid;
+
+			Decoded()
+				: width(0)
+				, height(0)
+				, contentWidth(0)
+				, contentHeight(0)
+			{}
+
+			//! average the valid content coordinates around the camera position, return false if there are none
+			bool lookup(const glm::vec2 & cameraPos, int radius, glm::vec2 & content) const;
+		} Decoded;
+
+		StructuredLight();
+
+		//! set the size of the patterns, usually the size of the warp content
+		void setup(size_t width, size_t height);
+
+		//! return the number of patterns, a pattern and its inverse for each bit of both axes
+		size_t getNumPatterns() const;
+		//! return the number of bits used to encode columns
+		size_t getNumBitsX() const;
+		//! return the number of bits used to encode rows
+		size_t getNumBitsY() const;
+
+		//! fill the grayscale pixels with the pattern
+		void getPattern(size_t index, ofPixels & pixels) const;
+		//! draw the pattern through the warp, so that it goes through the same path as the content
+		void drawPattern(size_t index, std::shared_ptr<WarpBase> warp);
+
+		//! set the minimum difference between a pattern and its inverse for a camera pixel to be decoded
+		void setThreshold(uint8_t threshold);
+		uint8_t getThreshold() const;
+
+		//! set the number of decoding threads, 0 to use all cores
+		void setNumThreads(size_t numThreads);
+		size_t getNumThreads() const;
+
+		//! decode the captures, one per pattern in order, into content coordinates for each camera pixel
+		bool decode(const std::vector<ofPixels> & captures, Decoded & decoded) const;
+
+		//! collect correspondences from normalized content positions to normalized screen positions, so that the content fills the camera quad
+		//! camera pixels inside the quad are sampled every step pixels, the patterns must have been drawn through the warp in its reset state
+		void getCorrespondences(const Decoded & decoded, const glm::vec2 cameraQuad[4], size_t step, std::vector<glm::vec2> & content, std::vector<glm::vec2> & screen) const;
+
+		//! set the control points of the warp so that the content fills the camera quad (top-left, top-right, bottom-right, bottom-left)
+		//! perspective corners are sampled directly, bilinear grids are fitted to all correspondences with the grid fitter
+		//! the patterns must have been drawn through the warp in its reset state, return the number of control points set
+		size_t fitGrid(const Decoded & decoded, const glm::vec2 cameraQuad[4], std::shared_ptr<WarpBase> warp, int radius = 2, GridFitter::Result * result = nullptr) const;
+
+		//! set the fitter used for bilinear grids
+		void setGridFitter(const GridFitter & gridFitter);
+		GridFitter & getGridFitter();
+
+		//! set the step in camera pixels between the correspondences fitGrid() collects for bilinear grids, at least 1
+		void setSampleStep(size_t sampleStep);
+		size_t getSampleStep() const;
+
+		//! render what a camera would capture of the pattern, given the mapping from camera pixels to pattern pixels, for testing
+		void simulateCapture(size_t index, const glm::dmat3 & cameraToContent, size_t cameraWidth, size_t cameraHeight, ofPixels & capture, float gain = 0.8f, float ambient = 0.1f, float noise = 0.02f) const;
+
+	protected:
+		//! return the pattern value, 0 or 1, of the content pixel
+		bool getPatternBit(size_t index, size_t x, size_t y) const;
+
+		//! decode a range of camera rows
+		void decodeRows(const std::vector<const uint8_t *> & planes, size_t y0, size_t y1, Decoded & decoded) const;
+
+	protected:
+		size_t width;
+		size_t height;
+		size_t numBitsX;
+		size_t numBitsY;
+
+		uint8_t threshold;
+		size_t numThreads;
+
+		GridFitter gridFitter;
+		size_t sampleStep;
+
+		ofPixels patternPixels;
+		ofTexture patternTexture;
+		size_t patternIndex;
+	};
+}
@@ -0,0 +1,258 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "ofFileUtils.h"
+#include "ofJson.h"
+#include "ofLog.h"
+
+namespace ofxWarp
+{
+	namespace
+	{
+		typedef struct Event
+		{
+			const char * name;
+			uint64_t startNanos;
+			uint64_t endNanos;
+		} Event;
+
+		// Events are stored in chunks that are never moved, so the writing thread appends without locking
+		// and a reader only has to acquire the count to see complete events.
+		static const size_t CHUNK_SIZE = 16384;
+		static const size_t MAX_NUM_CHUNKS = 256;
+
+		typedef struct ThreadBuffer
+		{
+			uint32_t threadId;
+			std::atomic<Event *> chunks[MAX_NUM_CHUNKS];
+			std::atomic<size_t> numEvents;
+			std::atomic<size_t> numDropped;
+
+			// Only accessed by the owning thread, the clear generation its events were last reset for.
+			uint32_t generation;
+
+			// Only accessed with the registry mutex held.
+			std::string threadName;
+			size_t firstEvent;
+		} ThreadBuffer;
+
+		std::mutex registryMutex;
+
+		// Held while saving, so that a thread only rewinds its buffer when no save is reading from it.
+		std::mutex saveMutex;
+
+		// Bumped by clear(), each thread then rewinds its buffer on its next event to reuse the chunks.
+		std::atomic<uint32_t> clearGeneration(0);
+
+		// Buffers outlive their threads so that events of finished workers are still saved, and are never freed
+		// since a thread may still be writing when static destructors run.
+		std::vector<ThreadBuffer *> & getRegistry()
+		{
+			static auto registry = new std::vector<ThreadBuffer *>();
+			return *registry;
+		}
+
+		ThreadBuffer * getThreadBuffer()
+		{
+			thread_local ThreadBuffer * buffer = nullptr;
+			if (buffer == nullptr)
+			{
+				auto newBuffer = new ThreadBuffer();
+				for (auto & chunk : newBuffer->chunks)
+				{
+					chunk = nullptr;
+				}
+				newBuffer->numEvents = 0;
+				newBuffer->numDropped = 0;
+				newBuffer->firstEvent = 0;
+
+				std::lock_guard<std::mutex> lock(registryMutex);
+				newBuffer->generation = clearGeneration.load(std::memory_order_relaxed);
+				newBuffer->threadId = getRegistry().size() + 1;
+				getRegistry().push_back(newBuffer);
+				buffer = newBuffer;
+			}
+			return buffer;
+		}
+
+		// Only called from the owning thread, the only one that writes to the buffer.
+		void rewindThreadBuffer(ThreadBuffer * buffer)
+		{
+			// A save may be reading the events, try again on the next event rather than waiting for the file.
+			std::unique_lock<std::mutex> saveLock(saveMutex, std::try_to_lock);
+			if (!saveLock.owns_lock()) return;
+
+			// Events recorded since the clear are kept, they were added while a save held on to the buffer.
+			std::lock_guard<std::mutex> lock(registryMutex);
+			if (buffer->firstEvent == buffer->numEvents.load(std::memory_order_relaxed))
+			{
+				buffer->numEvents.store(0, std::memory_order_release);
+				buffer->firstEvent = 0;
+			}
+			buffer->generation = clearGeneration.load(std::memory_order_relaxed);
+		}
+	}
+
+	std::atomic<bool> Trace::recording(false);
+
+	//--------------------------------------------------------------
+	void Trace::start()
+	{
+#ifdef OFXWARP_ENABLE_TRACING
+		Trace::now();
+		Trace::recording = true;
+#else
+		ofLogWarning("Trace::start") << "Tracing is compiled out, define OFXWARP_ENABLE_TRACING to record events.";
+#endif
+	}
+
+	//--------------------------------------------------------------
+	void Trace::stop()
+	{
+		Trace::recording = false;
+	}
+
+	//--------------------------------------------------------------
+	bool Trace::isRecording()
+	{
+		return Trace::recording;
+	}
+
+	//--------------------------------------------------------------
+	void Trace::setThreadName(const std::string & name)
+	{
+#ifdef OFXWARP_ENABLE_TRACING
+		auto buffer = getThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(registryMutex);
+		buffer->threadName = name;
+#endif
+	}
+
+	//--------------------------------------------------------------
+	bool Trace::save(const std::string & filePath)
+	{
+#ifdef OFXWARP_ENABLE_TRACING
+		typedef struct Range
+		{
+			const ThreadBuffer * buffer;
+			std::string threadName;
+			size_t firstEvent;
+			size_t numEvents;
+		} Range;
+
+		std::lock_guard<std::mutex> saveLock(saveMutex);
+
+		// Snapshot the ranges so that threads registering during the save are not blocked on the file.
+		std::vector<Range> ranges;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			for (const auto buffer : getRegistry())
+			{
+				ranges.push_back({ buffer, buffer->threadName, buffer->firstEvent, buffer->numEvents.load(std::memory_order_acquire) });
+			}
+		}
+
+		auto file = ofFile(filePath, ofFile::WriteOnly);
+		if (!file.is_open())
+		{
+			ofLogError("Trace::save") << "Could not open file " << filePath;
+			return false;
+		}
+
+		// Chrome trace timestamps are in microseconds.
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"ofxWarp\"}}";
+		char line[256];
+		for (const auto & range : ranges)
+		{
+			if (!range.threadName.empty())
+			{
+				file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << range.buffer->threadId << ",\"args\":{\"name\":" << nlohmann::json(range.threadName).dump() << "}}";
+			}
+
+			for (auto i = range.firstEvent; i < range.numEvents; ++i)
+			{
+				const auto & event = range.buffer->chunks[i / CHUNK_SIZE].load(std::memory_order_acquire)[i % CHUNK_SIZE];
+				snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					event.name, range.buffer->threadId, event.startNanos * 0.001, (event.endNanos - event.startNanos) * 0.001);
+				file << line;
+			}
+		}
+		file << "\n]}\n";
+
+		return true;
+#else
+		ofLogWarning("Trace::save") << "Tracing is compiled out, define OFXWARP_ENABLE_TRACING to record events.";
+		return false;
+#endif
+	}
+
+	//--------------------------------------------------------------
+	void Trace::clear()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (auto buffer : getRegistry())
+		{
+			buffer->firstEvent = buffer->numEvents.load(std::memory_order_acquire);
+		}
+		clearGeneration.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//--------------------------------------------------------------
+	size_t Trace::getNumEventsDropped()
+	{
+		size_t numDropped = 0;
+
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (const auto buffer : getRegistry())
+		{
+			numDropped += buffer->numDropped;
+		}
+		return numDropped;
+	}
+
+	//--------------------------------------------------------------
+	uint64_t Trace::now()
+	{
+		static const auto epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	//--------------------------------------------------------------
+	void Trace::record(const char * name, uint64_t startNanos, uint64_t endNanos)
+	{
+#ifdef OFXWARP_ENABLE_TRACING
+		auto buffer = getThreadBuffer();
+
+		// After a clear, rewind to the start of the buffer so the chunks are reused instead of filling up for good.
+		auto generation = clearGeneration.load(std::memory_order_relaxed);
+		if (buffer->generation != generation)
+		{
+			rewindThreadBuffer(buffer);
+		}
+
+		// Only this thread writes to its buffer, the release store publishes the event to save().
+		auto index = buffer->numEvents.load(std::memory_order_relaxed);
+		auto chunkIndex = index / CHUNK_SIZE;
+		if (chunkIndex >= MAX_NUM_CHUNKS)
+		{
+			buffer->numDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		auto chunk = buffer->chunks[chunkIndex].load(std::memory_order_relaxed);
+		if (chunk == nullptr)
+		{
+			chunk = new Event[CHUNK_SIZE];
+			buffer->chunks[chunkIndex].store(chunk, std::memory_order_release);
+		}
+
+		chunk[index % CHUNK_SIZE] = { name, startNanos, endNanos };
+		buffer->numEvents.store(index + 1, std::memory_order_release);
+#endif
+	}
+}
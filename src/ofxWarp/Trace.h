@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace ofxWarp
+{
+	//! records scoped events into per-thread buffers and saves them as a Chrome trace, to be opened in chrome://tracing or ui.perfetto.dev
+	//! markers are only compiled in when OFXWARP_ENABLE_TRACING is defined, otherwise OFXWARP_TRACE_SCOPE expands to nothing and recording does nothing
+	class Trace
+	{
+	public:
+		//! start recording events, from any thread
+		static void start();
+		//! stop recording events, scopes already open are still recorded when they close
+		static void stop();
+		static bool isRecording();
+
+		//! name the calling thread in the trace
+		static void setThreadName(const std::string & name);
+
+		//! save the events recorded so far as Chrome trace JSON, return false if tracing is compiled out or the file could not be written
+		//! safe to call while recording, events that complete during the save may be left out
+		static bool save(const std::string & filePath);
+		//! leave the events recorded so far out of the next save, each thread reuses its buffer from its next event on
+		static void clear();
+
+		//! return the number of events dropped because a thread buffer was full
+		static size_t getNumEventsDropped();
+
+		//! time since the first trace call, in nanoseconds
+		static uint64_t now();
+		//! record a completed event, name must outlive the trace, usually a string literal
+		static void record(const char * name, uint64_t startNanos, uint64_t endNanos);
+
+		//! records the lifetime of a block, use through OFXWARP_TRACE_SCOPE
+		class Scope
+		{
+		public:
+			Scope(const char * name)
+				: name(name)
+				, recording(Trace::recording.load(std::memory_order_relaxed))
+				, startNanos(recording ? Trace::now() : 0)
+			{}
+
+			~Scope()
+			{
+				if (this->recording)
+				{
+					Trace::record(this->name, this->startNanos, Trace::now());
+				}
+			}
+
+			Scope(const Scope &) = delete;
+			Scope & operator=(const Scope &) = delete;
+
+		protected:
+			const char * name;
+			bool recording;
+			uint64_t startNanos;
+		};
+
+	protected:
+		static std::atomic<bool> recording;
+	};
+}
+
+#ifdef OFXWARP_ENABLE_TRACING
+#define OFXWARP_TRACE_CONCAT_IMPL(a, b) a##b
+#define OFXWARP_TRACE_CONCAT(a, b) OFXWARP_TRACE_CONCAT_IMPL(a, b)
+//! record the enclosing block under name, which must be a string literal
+#define OFXWARP_TRACE_SCOPE(name) ofxWarp::Trace::Scope OFXWARP_TRACE_CONCAT(ofxWarpTraceScope, __LINE__)(name)
+#else
+#define OFXWARP_TRACE_SCOPE(name)
+#endif
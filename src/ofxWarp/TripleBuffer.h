@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+
+namespace ofxWarp
+{
+	//! wait-free single producer, single consumer triple buffer
+	//! the producer fills the back buffer and publishes it, the consumer picks up the latest published buffer without ever blocking
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer()
+			: middle(1)
+			, back(0)
+			, front(2)
+		{}
+
+		//! return the buffer the producer writes into
+		T & getBackBuffer()
+		{
+			return this->buffers[this->back];
+		}
+
+		//! hand the back buffer over to the consumer, the producer gets a free buffer in exchange
+		void publish()
+		{
+			this->back = this->middle.exchange(this->back | DIRTY_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+		}
+
+		//! return whether a buffer was published since the last update
+		bool hasUpdate() const
+		{
+			return (this->middle.load(std::memory_order_acquire) & DIRTY_BIT) != 0;
+		}
+
+		//! swap in the latest published buffer, return false if there was nothing new
+		bool update()
+		{
+			if (!this->hasUpdate()) return false;
+
+			this->front = this->middle.exchange(this->front, std::memory_order_acq_rel) & INDEX_MASK;
+			return true;
+		}
+
+		//! return the buffer the consumer reads from
+		const T & getFrontBuffer() const
+		{
+			return this->buffers[this->front];
+		}
+
+	protected:
+		static const unsigned int DIRTY_BIT = 4;
+		static const unsigned int INDEX_MASK = 3;
+
+		T buffers[3];
+
+		//! shared index, with the dirty bit set when it holds a freshly published buffer
+		std::atomic<unsigned int> middle;
+
+		//! only touched by the producer
+		unsigned int back;
+		//! only touched by the consumer
+		unsigned int front;
+	};
+}
@@ -1,18 +1,198 @@
 #include "WarpBase.h"
 
+#include "ofGLUtils.h"
 #include "ofPolyline.h"
 
+#include "Trace.h"
+
 namespace ofxWarp
 {
 	//--------------------------------------------------------------
 	std::filesystem::path WarpBase::shaderPath = std::filesystem::path("shaders") / "ofxWarp";
 
+	//--------------------------------------------------------------
+	std::map<std::pair<std::string, int>, std::shared_ptr<ofShader>> WarpBase::shaderVariants;
+
+	//--------------------------------------------------------------
+	size_t WarpBase::shaderVariantsGeneration = 0;
+
 	//--------------------------------------------------------------
 	void WarpBase::setShaderPath(const std::filesystem::path shaderPath)
 	{
 		WarpBase::shaderPath = shaderPath;
 	}
 
+	//--------------------------------------------------------------
+	std::shared_ptr<ofShader> WarpBase::getShaderVariant(const std::string & name, int features)
+	{
+		auto basePath = WarpBase::shaderPath / name;
+		auto key = std::make_pair(basePath.string(), features);
+
+		// Failed variants are cached as null, so they are not retried and logged every frame.
+		auto it = WarpBase::shaderVariants.find(key);
+		if (it != WarpBase::shaderVariants.end())
+		{
+			return it->second;
+		}
+
+		OFXWARP_TRACE_SCOPE("WarpBase::getShaderVariant");
+
+		// The variants are shared between all warps, release them while the GL context is still alive.
+		if (WarpBase::shaderVariants.empty())
+		{
+			ofAddListener(ofEvents().exit, &WarpBase::onExit);
+		}
+
+		// Build the list of defines for the enabled features.
+		std::string defines;
+		if (features & SHADER_EDITING) defines += "#define EDITING\n";
+		if (features & SHADER_EDGE_LEFT) defines += "#define EDGE_LEFT\n";
+		if (features & SHADER_EDGE_TOP) defines += "#define EDGE_TOP\n";
+		if (features & SHADER_EDGE_RIGHT) defines += "#define EDGE_RIGHT\n";
+		if (features & SHADER_EDGE_BOTTOM) defines += "#define EDGE_BOTTOM\n";
+		if (features & SHADER_GAMMA) defines += "#define GAMMA\n";
+		if (features & SHADER_BLEND_LUT) defines += "#define BLEND_LUT\n";
+		if (features & SHADER_TINT) defines += "#define TINT\n";
+
+		auto shader = std::make_shared<ofShader>();
+		for (auto stage : { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER })
+		{
+			auto filePath = basePath;
+			filePath += (stage == GL_VERTEX_SHADER) ? ".vert" : ".frag";
+
+			auto source = ofBufferFromFile(filePath).getText();
+			if (source.empty())
+			{
+				ofLogError("WarpBase::getShaderVariant") << "Could not load shader at path " << filePath;
+				WarpBase::shaderVariants[key] = nullptr;
+				return nullptr;
+			}
+
+			// The defines must follow the #version directive.
+			auto versionPos = source.find("#version");
+			auto insertPos = (versionPos == std::string::npos) ? 0 : source.find('\n', versionPos);
+			if (insertPos == std::string::npos)
+			{
+				source += '\n';
+				insertPos = source.size();
+			}
+			else if (versionPos != std::string::npos)
+			{
+				++insertPos;
+			}
+			source.insert(insertPos, defines);
+
+			if (!shader->setupShaderFromSource(stage, source))
+			{
+				ofLogError("WarpBase::getShaderVariant") << "Could not compile shader at path " << filePath << " with features " << features;
+				WarpBase::shaderVariants[key] = nullptr;
+				return nullptr;
+			}
+		}
+		shader->bindDefaults();
+		if (!shader->linkProgram())
+		{
+			ofLogError("WarpBase::getShaderVariant") << "Could not link shader at path " << basePath << " with features " << features;
+			WarpBase::shaderVariants[key] = nullptr;
+			return nullptr;
+		}
+
+		WarpBase::shaderVariants[key] = shader;
+		return shader;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::getNumShaderVariants()
+	{
+		size_t numVariants = 0;
+		for (auto & it : WarpBase::shaderVariants)
+		{
+			if (it.second) ++numVariants;
+		}
+		return numVariants;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::releaseShaderVariants()
+	{
+		// Warps may still hold on to a variant, unload the programs so nothing is left for the destructors to delete.
+		for (auto & it : WarpBase::shaderVariants)
+		{
+			if (it.second) it.second->unload();
+		}
+		WarpBase::shaderVariants.clear();
+		++WarpBase::shaderVariantsGeneration;
+
+		ofRemoveListener(ofEvents().exit, &WarpBase::onExit);
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::onExit(ofEventArgs & args)
+	{
+		WarpBase::releaseShaderVariants();
+	}
+
+	//--------------------------------------------------------------
+	WarpBase::Counters & WarpBase::Counters::operator+=(const Counters & other)
+	{
+		this->numMeshRebuilds += other.numMeshRebuilds;
+		this->meshRebuildNanos += other.meshRebuildNanos;
+		this->numVerticesUploaded += other.numVerticesUploaded;
+		this->numIndicesUploaded += other.numIndicesUploaded;
+		this->numBytesUploaded += other.numBytesUploaded;
+		this->numDrawCalls += other.numDrawCalls;
+		this->numUniformUpdates += other.numUniformUpdates;
+		this->numFboAllocations += other.numFboAllocations;
+		return *this;
+	}
+
+	//--------------------------------------------------------------
+	WarpBase::Counters WarpBase::Counters::operator-(const Counters & other) const
+	{
+		// A smaller value means the counter was reset since the other copy was taken.
+		auto difference = [](uint64_t current, uint64_t previous)
+		{
+			return (current >= previous) ? (current - previous) : current;
+		};
+
+		Counters counters;
+		counters.numMeshRebuilds = difference(this->numMeshRebuilds, other.numMeshRebuilds);
+		counters.meshRebuildNanos = difference(this->meshRebuildNanos, other.meshRebuildNanos);
+		counters.numVerticesUploaded = difference(this->numVerticesUploaded, other.numVerticesUploaded);
+		counters.numIndicesUploaded = difference(this->numIndicesUploaded, other.numIndicesUploaded);
+		counters.numBytesUploaded = difference(this->numBytesUploaded, other.numBytesUploaded);
+		counters.numDrawCalls = difference(this->numDrawCalls, other.numDrawCalls);
+		counters.numUniformUpdates = difference(this->numUniformUpdates, other.numUniformUpdates);
+		counters.numFboAllocations = difference(this->numFboAllocations, other.numFboAllocations);
+		return counters;
+	}
+
+	//--------------------------------------------------------------
+	WarpBase::MemoryUsage & WarpBase::MemoryUsage::operator+=(const MemoryUsage & other)
+	{
+		this->cpuBytes += other.cpuBytes;
+		this->vboBytes += other.vboBytes;
+		this->fboColorBytes += other.fboColorBytes;
+		this->fboDepthBytes += other.fboDepthBytes;
+		this->fboStencilBytes += other.fboStencilBytes;
+		this->textureBytes += other.textureBytes;
+		this->numShaderPrograms += other.numShaderPrograms;
+		this->numSharedShaderPrograms += other.numSharedShaderPrograms;
+		return *this;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::MemoryUsage::getGpuBytes() const
+	{
+		return this->vboBytes + this->fboColorBytes + this->fboDepthBytes + this->fboStencilBytes + this->textureBytes;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::MemoryUsage::getTotalBytes() const
+	{
+		return this->cpuBytes + this->getGpuBytes();
+	}
+
 	//--------------------------------------------------------------
 	WarpBase::WarpBase(Type type)
 		: type(type)
@@ -23,12 +203,23 @@ namespace ofxWarp
 		, height(480.0f)
 		, numControlsX(2)
 		, numControlsY(2)
+		, controlPointsRevision(0)
 		, selectedIndex(-1)
 		, selectedTime(0.0f)
 		, luminance(0.5f)
 		, gamma(1.0f)
 		, exponent(2.0f)
 		, edges(0.0f)
+		, blendLutEnabled(false)
+		, blendLutDirty(true)
+		, shaderFeatures(0)
+		, shaderGeneration(0)
+		, calibrationFrame(0)
+		, gpuTimingEnabled(false)
+		, numQueuedControls(0)
+		, controlsDirtyBegin(0)
+		, controlsDirtyEnd(0)
+		, numControlInstances(0)
 	{
 		this->windowSize = glm::vec2(ofGetWidth(), ofGetHeight());
 	}
@@ -46,6 +237,8 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBase::serialize(nlohmann::json & json)
 	{
+		OFXWARP_TRACE_SCOPE("WarpBase::serialize");
+
 		// Main parameters.
 		json["type"] = this->type;
 		json["brightness"] = this->brightness;
@@ -89,27 +282,38 @@ namespace ofxWarp
 	
 	//--------------------------------------------------------------
 	void WarpBase::deserialize(const nlohmann::json & json)
+	{
+		OFXWARP_TRACE_SCOPE("WarpBase::deserialize");
+
+		State state;
+		this->getState(state);
+		WarpBase::readState(json, state);
+		this->setState(state);
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::readState(const nlohmann::json & json, State & state)
 	{
 		// Main parameters.
 		int typeAsInt = json["type"];
-		this->type = (Type)typeAsInt;
-		this->brightness = json["brightness"];
+		state.type = (Type)typeAsInt;
+		state.brightness = json["brightness"];
 
 		// Warp parameters.
 		{
 			const auto & jsonWarp = json["warp"];
 
-			this->numControlsX = jsonWarp["columns"];
-			this->numControlsY = jsonWarp["rows"];
+			state.numControlsX = jsonWarp["columns"];
+			state.numControlsY = jsonWarp["rows"];
 
-			this->controlPoints.clear();
+			state.controlPoints.clear();
 			for (const auto & jsonPoint : jsonWarp["control points"])
 			{
 				glm::vec2 controlPoint;
 				std::istringstream iss;
 				iss.str(jsonPoint);
 				iss >> controlPoint;
-				this->controlPoints.push_back(controlPoint);
+				state.controlPoints.push_back(controlPoint);
 			}
 		}
 
@@ -117,26 +321,108 @@ namespace ofxWarp
 		{
 			const auto & jsonBlend = json["blend"];
 
-			this->exponent = jsonBlend["exponent"];
+			state.exponent = jsonBlend["exponent"];
 
 			{
+				// Edges are stored as half of the blending area.
 				std::istringstream iss;
 				iss.str(jsonBlend["edges"]);
-				iss >> this->edges;
+				iss >> state.edges;
+				state.edges *= 2.0f;
 			}
 			{
 				std::istringstream iss;
 				iss.str(jsonBlend["gamma"]);
-				iss >> this->gamma;
+				iss >> state.gamma;
 			}
 			{
 				std::istringstream iss;
 				iss.str(jsonBlend["luminance"]);
-				iss >> this->luminance;
+				iss >> state.luminance;
 			}
 		}
 
-		this->dirty = true;
+		// Bilinear parameters.
+		if (state.type == TYPE_BILINEAR || state.type == TYPE_PERSPECTIVE_BILINEAR)
+		{
+			state.resolution = json["resolution"];
+			state.linear = json["linear"];
+			state.adaptive = json["adaptive"];
+		}
+
+		// Perspective parameters.
+		if (state.type == TYPE_PERSPECTIVE_BILINEAR)
+		{
+			auto i = 0;
+			for (const auto & jsonPoint : json["corners"])
+			{
+				if (i >= 4) break;
+
+				std::istringstream iss;
+				iss.str(jsonPoint);
+				iss >> state.corners[i];
+
+				++i;
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::getState(State & state) const
+	{
+		state.type = this->type;
+		state.width = this->width;
+		state.height = this->height;
+		state.brightness = this->brightness;
+		state.numControlsX = this->numControlsX;
+		state.numControlsY = this->numControlsY;
+		state.controlPoints = this->controlPoints;
+		state.luminance = this->luminance;
+		state.gamma = this->gamma;
+		state.exponent = this->exponent;
+		state.edges = this->getEdges();
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBase::setState(const State & state)
+	{
+		OFXWARP_TRACE_SCOPE("WarpBase::setState");
+
+		if (state.type != this->type)
+		{
+			ofLogWarning("WarpBase::setState") << "State of type " << state.type << " does not match warp of type " << this->type;
+			return false;
+		}
+		if (!this->isValidGrid(state.numControlsX, state.numControlsY) || state.controlPoints.size() != state.numControlsX * state.numControlsY)
+		{
+			ofLogWarning("WarpBase::setState") << "State with " << state.controlPoints.size() << " control points does not fit a " << state.numControlsX << "x" << state.numControlsY << " grid for warp of type " << this->type;
+			return false;
+		}
+
+		// Only touch what changed, so that applying the same state every frame is cheap.
+		if (state.width > 0.0f && state.height > 0.0f && (state.width != this->width || state.height != this->height)) this->setSize(state.width, state.height);
+		this->brightness = state.brightness;
+		if (state.luminance != this->luminance) this->setLuminance(state.luminance);
+		if (state.gamma != this->gamma) this->setGamma(state.gamma);
+		if (state.exponent != this->exponent) this->setExponent(state.exponent);
+		if (state.edges != this->getEdges()) this->setEdges(state.edges);
+
+		if (state.numControlsX != this->numControlsX || state.numControlsY != this->numControlsY || state.controlPoints != this->controlPoints)
+		{
+			this->numControlsX = state.numControlsX;
+			this->numControlsY = state.numControlsY;
+			this->controlPoints = state.controlPoints;
+
+			if (this->selectedIndex >= this->controlPoints.size())
+			{
+				this->deselectControlPoint();
+			}
+
+			this->dirty = true;
+			++this->controlPointsRevision;
+		}
+
+		return true;
 	}
 
 	//--------------------------------------------------------------
@@ -187,6 +473,7 @@ namespace ofxWarp
 		this->width = width;
 		this->height = height;
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 	
 	//--------------------------------------------------------------
@@ -207,6 +494,12 @@ namespace ofxWarp
 		return ofRectangle(0, 0, this->width, this->height);
 	}
 
+	//--------------------------------------------------------------
+	const glm::vec2 & WarpBase::getWindowSize() const
+	{
+		return this->windowSize;
+	}
+
 	//--------------------------------------------------------------
 	void WarpBase::setBrightness(float brightness)
 	{
@@ -223,18 +516,21 @@ namespace ofxWarp
 	void WarpBase::setLuminance(float luminance)
 	{
 		this->luminance = glm::vec3(luminance);
+		this->blendLutDirty = true;
 	}
 	
 	//--------------------------------------------------------------
 	void WarpBase::setLuminance(float red, float green, float blue)
 	{
 		this->luminance = glm::vec3(red, green, blue);
+		this->blendLutDirty = true;
 	}
 
 	//--------------------------------------------------------------
 	void WarpBase::setLuminance(const glm::vec3 & rgb)
 	{
 		this->luminance = rgb;
+		this->blendLutDirty = true;
 	}
 	
 	//--------------------------------------------------------------
@@ -247,18 +543,21 @@ namespace ofxWarp
 	void WarpBase::setGamma(float gamma)
 	{
 		this->gamma = glm::vec3(gamma);
+		this->blendLutDirty = true;
 	}
 	
 	//--------------------------------------------------------------
 	void WarpBase::setGamma(float red, float green, float blue)
 	{
 		this->gamma = glm::vec3(red, green, blue);
+		this->blendLutDirty = true;
 	}
 
 	//--------------------------------------------------------------
 	void WarpBase::setGamma(const glm::vec3 & rgb)
 	{
 		this->gamma = rgb;
+		this->blendLutDirty = true;
 	}
 	
 	//--------------------------------------------------------------
@@ -271,6 +570,7 @@ namespace ofxWarp
 	void WarpBase::setExponent(float exponent)
 	{
 		this->exponent = exponent;
+		this->blendLutDirty = true;
 	}
 	
 	//--------------------------------------------------------------
@@ -300,6 +600,61 @@ namespace ofxWarp
 		return this->edges * 2.0f;
 	}
 
+	//--------------------------------------------------------------
+	void WarpBase::setBlendLutEnabled(bool blendLutEnabled)
+	{
+		this->blendLutEnabled = blendLutEnabled;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBase::isBlendLutEnabled() const
+	{
+		return this->blendLutEnabled;
+	}
+
+	//--------------------------------------------------------------
+	float WarpBase::evaluateEdges(const glm::vec2 & uv, const glm::vec4 & edges)
+	{
+		auto a = 1.0f;
+		if (edges.x > 0.0f) a *= ofClamp(uv.x / edges.x, 0.0f, 1.0f);
+		if (edges.y > 0.0f) a *= ofClamp(uv.y / edges.y, 0.0f, 1.0f);
+		if (edges.z > 0.0f) a *= ofClamp((1.0f - uv.x) / edges.z, 0.0f, 1.0f);
+		if (edges.w > 0.0f) a *= ofClamp((1.0f - uv.y) / edges.w, 0.0f, 1.0f);
+		return a;
+	}
+
+	//--------------------------------------------------------------
+	glm::vec3 WarpBase::evaluateBlendCurve(float a, const glm::vec3 & luminance, float exponent, const glm::vec3 & gamma)
+	{
+		static const auto one = glm::vec3(1.0f);
+
+		glm::vec3 blend;
+		if (a < 0.5f)
+		{
+			blend = luminance * powf(2.0f * a, exponent);
+		}
+		else
+		{
+			blend = one - (one - luminance) * powf(2.0f * (1.0f - a), exponent);
+		}
+
+		return glm::pow(blend, one / gamma);
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::bakeBlendCurve(float * rgb, size_t size, const glm::vec3 & luminance, float exponent, const glm::vec3 & gamma)
+	{
+		if (size < 2) return;
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			auto blend = WarpBase::evaluateBlendCurve(i / float(size - 1), luminance, exponent, gamma);
+			*rgb++ = blend.r;
+			*rgb++ = blend.g;
+			*rgb++ = blend.b;
+		}
+	}
+
 	//--------------------------------------------------------------
 	void WarpBase::draw(const ofTexture & texture)
 	{
@@ -315,8 +670,16 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBase::draw(const ofTexture & texture, const ofRectangle & srcBounds, const ofRectangle & dstBounds)
 	{
+		OFXWARP_TRACE_SCOPE("WarpBase::draw");
+
+		this->pollCalibrationChannel();
+
+		if (this->gpuTimingEnabled) this->warpGpuTimer.begin();
+
 		this->drawTexture(texture, srcBounds, dstBounds);
 		this->drawControls();
+
+		if (this->gpuTimingEnabled) this->warpGpuTimer.end();
 	}
 	
 	//--------------------------------------------------------------
@@ -387,6 +750,34 @@ namespace ofxWarp
 		return clipped;
 	}
 
+	//--------------------------------------------------------------
+	void WarpBase::mapContentToScreen(const glm::vec2 * content, glm::vec2 * screen, size_t count) const
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			screen[i] = this->mapContentToScreen(content[i]);
+		}
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::mapScreenToContent(const glm::vec2 * screen, glm::vec2 * content, bool * valid, size_t count) const
+	{
+		size_t numCovered = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto covered = this->mapScreenToContent(screen[i], content[i]);
+			if (valid)
+			{
+				valid[i] = covered;
+			}
+			if (covered)
+			{
+				++numCovered;
+			}
+		}
+		return numCovered;
+	}
+
 	//--------------------------------------------------------------
 	glm::vec2 WarpBase::getControlPoint(size_t index) const
 	{
@@ -402,6 +793,23 @@ namespace ofxWarp
 
 		this->controlPoints[index] = pos;
 		this->dirty = true;
+		++this->controlPointsRevision;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::setControlPoints(const std::vector<glm::vec2> & controlPoints)
+	{
+		OFXWARP_TRACE_SCOPE("WarpBase::setControlPoints");
+
+		if (controlPoints.size() != this->controlPoints.size())
+		{
+			ofLogWarning("WarpBase::setControlPoints") << "Expected " << this->controlPoints.size() << " control points, got " << controlPoints.size();
+			return;
+		}
+
+		this->controlPoints = controlPoints;
+		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -411,6 +819,7 @@ namespace ofxWarp
 
 		this->controlPoints[index] += shift;
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -443,12 +852,13 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	size_t WarpBase::findClosestControlPoint(const glm::vec2 & pos, float * distance) const
 	{
-		size_t index;
+		size_t index = -1;
 		auto minDistance = std::numeric_limits<float>::max();
 
-		for (auto i = 0; i < this->controlPoints.size(); ++i)
+		const auto & points = this->getControlPoints();
+		for (auto i = 0; i < points.size(); ++i)
 		{
-			auto candidate = glm::distance(pos, this->getControlPoint(i) * this->windowSize);
+			auto candidate = glm::distance(pos, points[i] * this->windowSize);
 			if (candidate < minDistance)
 			{
 				minDistance = candidate;
@@ -460,6 +870,149 @@ namespace ofxWarp
 		return index;
 	}
 
+	//--------------------------------------------------------------
+	const std::vector<glm::vec2> & WarpBase::getControlPoints() const
+	{
+		return this->controlPoints;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::getControlPointsRevision() const
+	{
+		return this->controlPointsRevision;
+	}
+
+	//--------------------------------------------------------------
+	const WarpBase::Counters & WarpBase::getCounters() const
+	{
+		return this->counters;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::resetCounters()
+	{
+		this->counters = Counters();
+	}
+
+	//--------------------------------------------------------------
+	WarpBase::MemoryUsage WarpBase::getMemoryUsage() const
+	{
+		MemoryUsage usage;
+
+		usage.cpuBytes += this->controlPoints.capacity() * sizeof(glm::vec2);
+		usage.cpuBytes += this->calibrationPoints.capacity() * sizeof(glm::vec2);
+		usage.cpuBytes += this->blendLutData.capacity() * sizeof(float);
+		usage.cpuBytes += this->controlData.capacity() * sizeof(ControlData);
+		usage.cpuBytes += this->controlMesh.getVertices().capacity() * sizeof(glm::vec3);
+		usage.cpuBytes += this->controlMesh.getTexCoords().capacity() * sizeof(glm::vec2);
+
+		usage.vboBytes += WarpBase::getVboBytes(this->controlMesh.getVbo());
+		if (this->controlInstances.isAllocated())
+		{
+			usage.vboBytes += this->controlInstances.size();
+		}
+
+		usage.textureBytes += WarpBase::getTextureBytes(this->blendLut);
+
+		if (this->controlShader.isLoaded())
+		{
+			++usage.numShaderPrograms;
+		}
+		if (this->shader)
+		{
+			++usage.numSharedShaderPrograms;
+		}
+
+		return usage;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::setGpuTimingEnabled(bool gpuTimingEnabled)
+	{
+		if (gpuTimingEnabled && !this->gpuTimingEnabled)
+		{
+			this->contentGpuTimer.reset();
+			this->warpGpuTimer.reset();
+		}
+		this->gpuTimingEnabled = gpuTimingEnabled;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBase::isGpuTimingEnabled() const
+	{
+		return this->gpuTimingEnabled;
+	}
+
+	//--------------------------------------------------------------
+	const GpuTimer & WarpBase::getContentGpuTimer() const
+	{
+		return this->contentGpuTimer;
+	}
+
+	//--------------------------------------------------------------
+	const GpuTimer & WarpBase::getWarpGpuTimer() const
+	{
+		return this->warpGpuTimer;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::setCalibrationChannel(std::shared_ptr<CalibrationChannel> calibrationChannel)
+	{
+		this->calibrationChannel = calibrationChannel;
+		this->calibrationFrame = 0;
+	}
+
+	//--------------------------------------------------------------
+	std::shared_ptr<CalibrationChannel> WarpBase::getCalibrationChannel() const
+	{
+		return this->calibrationChannel;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBase::pollCalibrationChannel()
+	{
+		if (!this->calibrationChannel) return false;
+
+		OFXWARP_TRACE_SCOPE("WarpBase::pollCalibrationChannel");
+
+		size_t numControlsX;
+		size_t numControlsY;
+		if (!this->calibrationChannel->read(this->calibrationFrame, numControlsX, numControlsY, this->calibrationPoints)) return false;
+
+		if (!this->isValidGrid(numControlsX, numControlsY))
+		{
+			ofLogWarning("WarpBase::pollCalibrationChannel") << "Ignoring " << numControlsX << "x" << numControlsY << " grid for warp of type " << this->type;
+			return false;
+		}
+
+		// Swap buffers, so there is no allocation once both have grown to size.
+		this->numControlsX = numControlsX;
+		this->numControlsY = numControlsY;
+		std::swap(this->controlPoints, this->calibrationPoints);
+
+		// The grid may have shrunk under the selection.
+		if (this->selectedIndex >= this->controlPoints.size())
+		{
+			this->deselectControlPoint();
+		}
+
+		this->dirty = true;
+		++this->controlPointsRevision;
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBase::isValidGrid(size_t numControlsX, size_t numControlsY) const
+	{
+		// Perspective warps only have their 4 corners.
+		if (this->type == TYPE_PERSPECTIVE)
+		{
+			return (numControlsX == 2 && numControlsY == 2);
+		}
+		return (numControlsX >= 2 && numControlsY >= 2);
+	}
+
 	//--------------------------------------------------------------
 	size_t WarpBase::getNumControlsX() const
 	{
@@ -481,8 +1034,7 @@ namespace ofxWarp
 		}
 		else if (selected) 
 		{
-			auto scale = 0.9f + 0.2f * sinf(6.0f * (ofGetElapsedTimef() - this->selectedTime));
-			queueControlPoint(pos, ofFloatColor(0.9f, 0.9f, 0.9f), scale);
+			queueControlPoint(pos, ofFloatColor(0.9f, 0.9f, 0.9f), 1.0f, true);
 		}
 		else if (attached) 
 		{
@@ -495,12 +1047,26 @@ namespace ofxWarp
 	}
 	
 	//--------------------------------------------------------------
-	void WarpBase::queueControlPoint(const glm::vec2 & pos, const ofFloatColor & color, float scale)
+	void WarpBase::queueControlPoint(const glm::vec2 & pos, const ofFloatColor & color, float scale, bool selected)
 	{
-		if (this->controlData.size() < MAX_NUM_CONTROL_POINTS)
+		// Instances are kept from the last frame, only the ones that differ are marked for upload.
+		auto index = this->numQueuedControls++;
+		auto instance = ControlData(pos, color, scale, selected);
+		if (index == this->controlData.size())
 		{
-			this->controlData.emplace_back(ControlData(pos, color, scale));
+			this->controlData.push_back(instance);
 		}
+		else if (this->controlData[index] != instance)
+		{
+			this->controlData[index] = instance;
+		}
+		else
+		{
+			return;
+		}
+
+		this->controlsDirtyBegin = MIN(this->controlsDirtyBegin, index);
+		this->controlsDirtyEnd = MAX(this->controlsDirtyEnd, index + 1);
 	}
 
 	//--------------------------------------------------------------
@@ -526,13 +1092,7 @@ namespace ofxWarp
 			}
 
 			// Set up per-instance data to the vbo.
-			std::vector<ControlData> instanceData;
-			instanceData.resize(MAX_NUM_CONTROL_POINTS);
-
-			this->controlMesh.getVbo().setAttributeData(INSTANCE_POS_SCALE_ATTRIBUTE, (float *)&instanceData[0].pos, 4, instanceData.size(), GL_STREAM_DRAW, sizeof(ControlData));
-			this->controlMesh.getVbo().setAttributeDivisor(INSTANCE_POS_SCALE_ATTRIBUTE, 1);
-			this->controlMesh.getVbo().setAttributeData(INSTANCE_COLOR_ATTRIBUTE, (float *)&instanceData[0].color, 4, instanceData.size(), GL_STREAM_DRAW, sizeof(ControlData));
-			this->controlMesh.getVbo().setAttributeDivisor(INSTANCE_COLOR_ATTRIBUTE, 1);
+			this->reserveControlInstances(MIN_NUM_CONTROL_INSTANCES);
 		}
 
 		if (!this->controlShader.isLoaded())
@@ -547,26 +1107,216 @@ namespace ofxWarp
 		}
 	}
 
+	//--------------------------------------------------------------
+	void WarpBase::reserveControlInstances(size_t numInstances)
+	{
+		if (numInstances <= this->numControlInstances) return;
+
+		// Grow geometrically, so that large grids only reallocate the buffers a few times.
+		auto capacity = MAX(this->numControlInstances, (size_t)MIN_NUM_CONTROL_INSTANCES);
+		while (capacity < numInstances)
+		{
+			capacity *= 2;
+		}
+
+		// Both attributes read the interleaved instances from the same buffer, it is only filled by drawControlPoints().
+		this->controlInstances.allocate(capacity * sizeof(ControlData), GL_DYNAMIC_DRAW);
+
+		auto & vbo = this->controlMesh.getVbo();
+		vbo.setAttributeBuffer(INSTANCE_POS_SCALE_ATTRIBUTE, this->controlInstances, 4, sizeof(ControlData), offsetof(ControlData, pos));
+		vbo.setAttributeDivisor(INSTANCE_POS_SCALE_ATTRIBUTE, 1);
+		vbo.setAttributeBuffer(INSTANCE_COLOR_ATTRIBUTE, this->controlInstances, 4, sizeof(ControlData), offsetof(ControlData, color));
+		vbo.setAttributeDivisor(INSTANCE_COLOR_ATTRIBUTE, 1);
+
+		this->numControlInstances = capacity;
+
+		// The previous contents are gone, upload all the instances again.
+		this->controlsDirtyBegin = 0;
+		this->controlsDirtyEnd = this->controlData.size();
+	}
+
 	//--------------------------------------------------------------
 	void WarpBase::drawControlPoints()
 	{
+		OFXWARP_TRACE_SCOPE("WarpBase::drawControlPoints");
+
 		this->setupControlPoints();
 
+		// Drop the instances that were not queued again this frame, the capacity is kept.
+		this->controlData.resize(this->numQueuedControls);
+		this->numQueuedControls = 0;
+
 		if (!this->controlData.empty())
 		{
-			this->controlMesh.getVbo().updateAttributeData(INSTANCE_POS_SCALE_ATTRIBUTE, (float *)&this->controlData[0].pos, this->controlData.size());
-			this->controlMesh.getVbo().updateAttributeData(INSTANCE_COLOR_ATTRIBUTE, (float *)&this->controlData[0].color, this->controlData.size());
+			this->reserveControlInstances(this->controlData.size());
+
+			// Only upload the range of instances that changed since the last frame.
+			this->controlsDirtyEnd = MIN(this->controlsDirtyEnd, this->controlData.size());
+			if (this->controlsDirtyBegin < this->controlsDirtyEnd)
+			{
+				auto numBytes = (this->controlsDirtyEnd - this->controlsDirtyBegin) * sizeof(ControlData);
+				this->controlInstances.updateData(this->controlsDirtyBegin * sizeof(ControlData), numBytes, &this->controlData[this->controlsDirtyBegin]);
+				this->counters.numBytesUploaded += numBytes;
+			}
 		
 			this->controlShader.begin();
 			{
+				// The selected point pulses in the shader, so its instance does not change every frame.
+				this->controlShader.setUniform1f("uPulseTime", ofGetElapsedTimef() - this->selectedTime);
+				++this->counters.numUniformUpdates;
+
 				this->controlMesh.drawInstanced(OF_MESH_FILL, this->controlData.size());
+				++this->counters.numDrawCalls;
 			}
 			this->controlShader.end();
 		}
 
-		this->controlData.clear();
+		this->controlsDirtyBegin = this->controlData.size();
+		this->controlsDirtyEnd = 0;
 	}
 	
+	//--------------------------------------------------------------
+	void WarpBase::setupBlendLut()
+	{
+		if (!this->blendLut.isAllocated())
+		{
+			// Use a 1D strip, the shaders sample it at texel centers so that both ends of the curve are exact.
+			ofTextureData textureData;
+			textureData.width = BLEND_LUT_SIZE;
+			textureData.height = 1;
+			textureData.textureTarget = GL_TEXTURE_2D;
+			textureData.glInternalFormat = GL_RGB32F;
+			this->blendLut.allocate(textureData, GL_RGB, GL_FLOAT);
+			this->blendLut.setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+			this->blendLut.setTextureWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+			this->blendLutData.resize(BLEND_LUT_SIZE * 3);
+			this->blendLutDirty = true;
+		}
+
+		if (this->blendLutDirty)
+		{
+			OFXWARP_TRACE_SCOPE("WarpBase::setupBlendLut");
+
+			WarpBase::bakeBlendCurve(this->blendLutData.data(), BLEND_LUT_SIZE, this->luminance, this->exponent, this->gamma);
+			this->blendLut.loadData(this->blendLutData.data(), BLEND_LUT_SIZE, 1, GL_RGB);
+			this->counters.numBytesUploaded += this->blendLutData.size() * sizeof(float);
+
+			this->blendLutDirty = false;
+		}
+	}
+
+	//--------------------------------------------------------------
+	int WarpBase::getShaderFeatures(const ofColor & color) const
+	{
+		int features = 0;
+
+		if (this->editing) features |= SHADER_EDITING;
+
+		if (this->edges.x > 0.0f) features |= SHADER_EDGE_LEFT;
+		if (this->edges.y > 0.0f) features |= SHADER_EDGE_TOP;
+		if (this->edges.z > 0.0f) features |= SHADER_EDGE_RIGHT;
+		if (this->edges.w > 0.0f) features |= SHADER_EDGE_BOTTOM;
+
+		// The blend curve is only evaluated when there is at least one blended edge.
+		if (features & SHADER_EDGES)
+		{
+			if (this->blendLutEnabled)
+			{
+				features |= SHADER_BLEND_LUT;
+			}
+			else if (this->gamma != glm::vec3(1.0f))
+			{
+				features |= SHADER_GAMMA;
+			}
+		}
+
+		if (color != ofColor::white) features |= SHADER_TINT;
+
+		return features;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBase::setupShader(const std::string & name, int features)
+	{
+		if (!this->shader || features != this->shaderFeatures || this->shaderGeneration != WarpBase::shaderVariantsGeneration)
+		{
+			this->shader = WarpBase::getShaderVariant(name, features);
+			this->shaderFeatures = features;
+			this->shaderGeneration = WarpBase::shaderVariantsGeneration;
+		}
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::setBlendUniforms() const
+	{
+		if (!(this->shaderFeatures & SHADER_EDGES)) return 0;
+
+		this->shader->setUniform4f("uEdges", this->edges);
+		if (this->shaderFeatures & SHADER_BLEND_LUT)
+		{
+			this->shader->setUniformTexture("uBlendLut", this->blendLut, 2);
+			return 2;
+		}
+
+		this->shader->setUniform3f("uLuminance", this->luminance);
+		this->shader->setUniform1f("uExponent", this->exponent);
+		if (this->shaderFeatures & SHADER_GAMMA)
+		{
+			this->shader->setUniform3f("uGamma", this->gamma);
+			return 4;
+		}
+		return 3;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::getBytesPerPixel(GLint internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		case GL_STENCIL_INDEX8:
+			return 1;
+#ifndef TARGET_OPENGLES
+		// Drivers pad 24 bit depth to 32 bits.
+		case GL_DEPTH_COMPONENT:
+		case GL_DEPTH_COMPONENT24:
+		case GL_DEPTH_COMPONENT32:
+		case GL_DEPTH_COMPONENT32F:
+		case GL_DEPTH_STENCIL:
+		case GL_DEPTH24_STENCIL8:
+			return 4;
+		case GL_DEPTH32F_STENCIL8:
+			return 8;
+#endif
+		default:
+			return ofGetNumChannelsFromGLFormat(ofGetGLFormatFromInternal(internalFormat)) * ofGetBytesPerChannelFromGLType(ofGetGLTypeFromInternal(internalFormat));
+		}
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::getTextureBytes(const ofTexture & texture)
+	{
+		if (!texture.isAllocated()) return 0;
+
+		// The allocated size, which is larger than the texture for power of two textures.
+		const auto & textureData = texture.getTextureData();
+		return size_t(textureData.tex_w) * size_t(textureData.tex_h) * WarpBase::getBytesPerPixel(textureData.glInternalFormat);
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBase::getVboBytes(const ofVbo & vbo)
+	{
+		size_t bytes = 0;
+		if (vbo.getUsingVerts()) bytes += vbo.getVertexBuffer().size();
+		if (vbo.getUsingColors()) bytes += vbo.getColorBuffer().size();
+		if (vbo.getUsingNormals()) bytes += vbo.getNormalBuffer().size();
+		if (vbo.getUsingTexCoords()) bytes += vbo.getTexCoordBuffer().size();
+		if (vbo.getUsingIndices()) bytes += vbo.getIndexBuffer().size();
+		return bytes;
+	}
+
 	//--------------------------------------------------------------
 	bool WarpBase::handleCursorDown(const glm::vec2 & pos)
 	{
@@ -598,6 +1348,7 @@ namespace ofxWarp
 	{
 		this->windowSize = glm::vec2(width, height);
 		this->dirty = true;
+		++this->controlPointsRevision;
 
 		return true;
 	}
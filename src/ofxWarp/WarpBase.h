@@ -1,6 +1,8 @@
 #pragma once
 
+#include "ofBufferObject.h"
 #include "ofColor.h"
+#include "ofEvents.h"
 #include "ofJson.h"
 #include "ofParameter.h"
 #include "ofRectangle.h"
@@ -9,6 +11,9 @@
 #include "ofVboMesh.h"
 #include "ofVectorMath.h"
 
+#include "CalibrationChannel.h"
+#include "GpuTimer.h"
+
 namespace ofxWarp
 {
 	class WarpBase
@@ -22,6 +27,134 @@ namespace ofxWarp
 			TYPE_PERSPECTIVE_BILINEAR
 		} Type;
 
+		typedef enum
+		{
+			SHADER_EDITING = 1 << 0,
+			SHADER_EDGE_LEFT = 1 << 1,
+			SHADER_EDGE_TOP = 1 << 2,
+			SHADER_EDGE_RIGHT = 1 << 3,
+			SHADER_EDGE_BOTTOM = 1 << 4,
+			SHADER_GAMMA = 1 << 5,
+			SHADER_BLEND_LUT = 1 << 6,
+			SHADER_TINT = 1 << 7,
+
+			SHADER_EDGES = SHADER_EDGE_LEFT | SHADER_EDGE_TOP | SHADER_EDGE_RIGHT | SHADER_EDGE_BOTTOM
+		} ShaderFeature;
+
+		//! plain copy of the parameters that define how a warp is rendered, which can be built and passed around on any thread
+		//! editing is left out, it belongs to the instance being edited and is not changed by applying a state
+		typedef struct State
+		{
+			Type type;
+			//! content size, leave at 0 to keep the size of the warp
+			float width;
+			float height;
+			float brightness;
+			size_t numControlsX;
+			size_t numControlsY;
+			std::vector<glm::vec2> controlPoints;
+			glm::vec3 luminance;
+			glm::vec3 gamma;
+			float exponent;
+			//! edge blending area, as returned by getEdges()
+			glm::vec4 edges;
+
+			//! WarpBilinear parameters
+			bool linear;
+			bool adaptive;
+			int resolution;
+
+			//! WarpPerspectiveBilinear corners
+			glm::vec2 corners[4];
+
+			State()
+				: type(TYPE_UNKNOWN)
+				, width(0.0f)
+				, height(0.0f)
+				, brightness(1.0f)
+				, numControlsX(2)
+				, numControlsY(2)
+				, luminance(0.5f)
+				, gamma(1.0f)
+				, exponent(2.0f)
+				, edges(0.0f)
+				, linear(false)
+				, adaptive(true)
+				, resolution(16)
+			{
+				corners[0] = glm::vec2(0.0f, 0.0f);
+				corners[1] = glm::vec2(1.0f, 0.0f);
+				corners[2] = glm::vec2(1.0f, 1.0f);
+				corners[3] = glm::vec2(0.0f, 1.0f);
+			}
+		} State;
+
+		//! runtime counters of the work done by a warp, cheap enough to leave enabled, accumulated until reset
+		typedef struct Counters
+		{
+			//! number of times the mesh was rebuilt, and the CPU time spent on it in nanoseconds
+			size_t numMeshRebuilds;
+			uint64_t meshRebuildNanos;
+			//! data sent to the GPU, including texture coordinates, control point instances and the blend lookup table
+			size_t numVerticesUploaded;
+			size_t numIndicesUploaded;
+			size_t numBytesUploaded;
+			size_t numDrawCalls;
+			size_t numUniformUpdates;
+			//! number of times the frame buffer was (re)allocated
+			size_t numFboAllocations;
+
+			Counters()
+				: numMeshRebuilds(0)
+				, meshRebuildNanos(0)
+				, numVerticesUploaded(0)
+				, numIndicesUploaded(0)
+				, numBytesUploaded(0)
+				, numDrawCalls(0)
+				, numUniformUpdates(0)
+				, numFboAllocations(0)
+			{}
+
+			Counters & operator+=(const Counters & other);
+			//! return the work done since the other counters were copied, fields that were reset in between are returned as is
+			Counters operator-(const Counters & other) const;
+		} Counters;
+
+		//! memory held by a warp in bytes, GPU sizes are estimated from the allocated sizes and formats
+		typedef struct MemoryUsage
+		{
+			//! CPU side buffers: control points, blend lookup data, control point instances and cached meshes
+			size_t cpuBytes;
+			//! vertex buffers: mesh positions, texture coordinates and indices, and control point instances
+			size_t vboBytes;
+			//! frame buffer attachments, multisampled buffers include their resolve textures
+			size_t fboColorBytes;
+			size_t fboDepthBytes;
+			size_t fboStencilBytes;
+			//! other textures, such as the blend lookup table
+			size_t textureBytes;
+			//! shader programs owned by the warp, and shader variants it uses which are shared between warps, their size is up to the driver
+			size_t numShaderPrograms;
+			size_t numSharedShaderPrograms;
+
+			MemoryUsage()
+				: cpuBytes(0)
+				, vboBytes(0)
+				, fboColorBytes(0)
+				, fboDepthBytes(0)
+				, fboStencilBytes(0)
+				, textureBytes(0)
+				, numShaderPrograms(0)
+				, numSharedShaderPrograms(0)
+			{}
+
+			MemoryUsage & operator+=(const MemoryUsage & other);
+			//! return the bytes held on the GPU, excluding shader programs
+			size_t getGpuBytes() const;
+			//! return the bytes held on the CPU and the GPU, excluding shader programs
+			size_t getTotalBytes() const;
+		} MemoryUsage;
+
 		WarpBase(Type type = TYPE_UNKNOWN);
 		virtual ~WarpBase();
 
@@ -31,6 +164,15 @@ namespace ofxWarp
 		virtual void serialize(nlohmann::json & json);
 		virtual void deserialize(const nlohmann::json & json);
 
+		//! read the warp parameters from json into the state, without touching any warp
+		static void readState(const nlohmann::json & json, State & state);
+
+		//! copy the parameters of the warp into the state
+		virtual void getState(State & state) const;
+		//! apply the parameters in the state to the warp, only marking changed parameters dirty
+		//! returns false without changing anything if the type does not match or the control points do not fill the grid
+		virtual bool setState(const State & state);
+
 		virtual void setEditing(bool editing);
 		void toggleEditing();
 		bool isEditing() const;
@@ -53,6 +195,8 @@ namespace ofxWarp
 		glm::vec2 getSize() const;
 		//! get the rectangle of the content in pixels
 		ofRectangle getBounds() const;
+		//! get the size of the window in pixels, used to convert control points to screen space
+		const glm::vec2 & getWindowSize() const;
 
 		//! set the brightness value of the texture (values between 0 and 1)
 		void setBrightness(float brightness);
@@ -89,6 +233,20 @@ namespace ofxWarp
 		//! return the edge blending area for the left, top, right and bottom edges (values between 0 and 1)
 		glm::vec4 getEdges() const;
 
+		//! set whether the blend and gamma curve is baked into a lookup texture instead of evaluated per fragment
+		//! the 256 texels are filtered linearly, which stays within 1.5/255 of the formula for luminance 0.2 to 0.8, exponent 1 to 4 and gamma 0.8 to 2.5,
+		//! except below the first texel (blend factor under 1/255) where gamma above 1 makes the curve too steep, up to 12/255 there
+		void setBlendLutEnabled(bool blendLutEnabled);
+		//! return whether the blend and gamma curve is baked into a lookup texture instead of evaluated per fragment
+		bool isBlendLutEnabled() const;
+
+		//! return the blend factor at the normalized content coordinate uv for the specified edges, as evaluated in the warp shaders
+		static float evaluateEdges(const glm::vec2 & uv, const glm::vec4 & edges);
+		//! return the blend and gamma corrected multiplier for the blend factor a (values between 0 and 1), as evaluated in the warp shaders
+		static glm::vec3 evaluateBlendCurve(float a, const glm::vec3 & luminance, float exponent, const glm::vec3 & gamma);
+		//! bake the blend and gamma curve into size rgb triplets, evenly spaced over blend factors between 0 and 1
+		static void bakeBlendCurve(float * rgb, size_t size, const glm::vec3 & luminance, float exponent, const glm::vec3 & gamma);
+
 		//! reset control points to undistorted image
 		virtual void reset(const glm::vec2 & scale = glm::vec2(1.0f), const glm::vec2 & offset = glm::vec2(0.0f)) = 0;
 		//! setup the warp before drawing its contents
@@ -106,12 +264,27 @@ namespace ofxWarp
 		//! adjust both the source and destination rectangles so that they are clipped against the warp's content
 		bool clip(ofRectangle & srcBounds, ofRectangle & dstBounds) const;
 
+		//! map a position in content pixels to window pixels
+		virtual glm::vec2 mapContentToScreen(const glm::vec2 & pos) const = 0;
+		//! map a position in window pixels back to content pixels, return false and leave content untouched if the warp does not cover it
+		virtual bool mapScreenToContent(const glm::vec2 & pos, glm::vec2 & content) const = 0;
+		//! map count positions in content pixels to window pixels
+		virtual void mapContentToScreen(const glm::vec2 * content, glm::vec2 * screen, size_t count) const;
+		//! map count positions in window pixels back to content pixels, valid (if set) receives whether each one is covered, return the number covered
+		virtual size_t mapScreenToContent(const glm::vec2 * screen, glm::vec2 * content, bool * valid, size_t count) const;
+		//! return the bounds of the area covered by the warp, in window pixels
+		virtual ofRectangle getScreenBounds() const = 0;
+		//! build the triangles drawn for the content, with homogeneous window positions (x, y, w) and normalized content coordinates
+		virtual void getMesh(std::vector<glm::vec3> & positions, std::vector<glm::vec2> & texCoords, std::vector<uint32_t> & indices) const = 0;
+
 		//! return the coordinates of the specified control point
 		virtual glm::vec2 getControlPoint(size_t index) const;
 		//! set the coordinates of the specified control point
 		virtual void setControlPoint(size_t index, const glm::vec2 & pos);
 		//! move the specified control point
 		virtual void moveControlPoint(size_t index, const glm::vec2 & shift);
+		//! replace all control points at once, in the space the warp stores them in, the grid size must match
+		virtual void setControlPoints(const std::vector<glm::vec2> & controlPoints);
 		//! get the number of control points
 		virtual size_t getNumControlPoints() const;
 		//! get the index of the currently selected control point
@@ -122,11 +295,41 @@ namespace ofxWarp
 		virtual void deselectControlPoint();
 		//! return the index of the closest control point, as well as the distance in pixels
 		virtual size_t findClosestControlPoint(const glm::vec2 & pos, float * distance) const;
+		//! return the coordinates of all control points in normalized screen space
+		virtual const std::vector<glm::vec2> & getControlPoints() const;
+		//! return a counter that changes whenever the screen position of any control point, or the shape of the warp between them, may have changed
+		virtual size_t getControlPointsRevision() const;
+
+		//! return the counters accumulated since the last reset
+		const Counters & getCounters() const;
+		//! reset the counters, for example at the start of each logging interval
+		void resetCounters();
+
+		//! return the memory currently held by the warp
+		virtual MemoryUsage getMemoryUsage() const;
+
+		//! set whether the GPU time of the content pass (between begin() and end()) and of the warp pass (drawing the warped texture) is measured
+		void setGpuTimingEnabled(bool gpuTimingEnabled);
+		//! return whether the GPU time of the passes is measured
+		bool isGpuTimingEnabled() const;
+		//! return the timer of the content pass
+		const GpuTimer & getContentGpuTimer() const;
+		//! return the timer of the warp pass
+		const GpuTimer & getWarpGpuTimer() const;
+
+		//! read the control points from a shared memory channel, the latest complete frame is picked up before drawing
+		void setCalibrationChannel(std::shared_ptr<CalibrationChannel> calibrationChannel);
+		//! return the shared memory channel the control points are read from
+		std::shared_ptr<CalibrationChannel> getCalibrationChannel() const;
+		//! pick up the latest frame from the calibration channel, return true if the control points changed
+		bool pollCalibrationChannel();
 
 		//! return the number of control points columns
 		size_t getNumControlsX() const;
 		//! return the number of control points rows
 		size_t getNumControlsY() const;
+		//! return true if the warp can take a grid of this size, perspective warps only take their 4 corners
+		bool isValidGrid(size_t numControlsX, size_t numControlsY) const;
 
 		virtual void rotateClockwise() = 0;
 		virtual void rotateCounterclockwise() = 0;
@@ -141,6 +344,13 @@ namespace ofxWarp
 
 		static void setShaderPath(const std::filesystem::path shaderPath);
 
+		//! return the shader with the specified name, compiled with a #define for each of the ShaderFeature flags, variants are cached and shared between warps
+		static std::shared_ptr<ofShader> getShaderVariant(const std::string & name, int features);
+		//! return the number of shader variants compiled so far
+		static size_t getNumShaderVariants();
+		//! unload and forget all shader variants, called on exit while the GL context is alive, warps fetch their variant again on their next draw
+		static void releaseShaderVariants();
+
 	protected:
 		//! draw a specific area of a warped texture to a specific region
 		virtual void drawTexture(const ofTexture & texture, const ofRectangle & srcBounds, const ofRectangle & dstBounds) = 0;
@@ -149,14 +359,33 @@ namespace ofxWarp
 		
 		//! draw a control point in the preset color
 		void queueControlPoint(const glm::vec2 & pos, bool selected = false, bool attached = false);
-		//! draw a control point in the specified color
-		void queueControlPoint(const glm::vec2 & pos, const ofFloatColor & color, float scale = 1.0f);
+		//! draw a control point in the specified color, selected points pulse in the shader
+		void queueControlPoint(const glm::vec2 & pos, const ofFloatColor & color, float scale = 1.0f, bool selected = false);
 
 		//! setup the control points instanced vbo
 		void setupControlPoints();
+		//! grow the control point instance buffer to hold at least the number of instances, the whole buffer is uploaded again after growing
+		void reserveControlInstances(size_t numInstances);
 		//! draw the control points
 		void drawControlPoints();
 
+		//! bake the blend lookup texture if any of the blend parameters changed
+		void setupBlendLut();
+
+		//! return the minimal set of shader features needed to draw the warp with the specified color
+		int getShaderFeatures(const ofColor & color) const;
+		//! select the shader variant with the specified features
+		void setupShader(const std::string & name, int features);
+		//! set the edge blending and gamma uniforms on the warp shader, return the number of uniforms set
+		size_t setBlendUniforms() const;
+
+		//! return the size of a pixel in the texture or render buffer internal format, in bytes
+		static size_t getBytesPerPixel(GLint internalFormat);
+		//! return the bytes held by the texture, 0 if it is not allocated
+		static size_t getTextureBytes(const ofTexture & texture);
+		//! return the bytes held by the vertex attributes and indices of the vbo, excluding custom attributes
+		static size_t getVboBytes(const ofVbo & vbo);
+
 	protected:
 		Type type;
 
@@ -173,6 +402,7 @@ namespace ofxWarp
 		size_t numControlsX;
 		size_t numControlsY;
 		std::vector<glm::vec2> controlPoints;
+		size_t controlPointsRevision;
 
 		size_t selectedIndex;
 		float selectedTime;
@@ -183,35 +413,78 @@ namespace ofxWarp
 		float exponent;
 		glm::vec4 edges;
 
-		static const int MAX_NUM_CONTROL_POINTS = 1024;
+		bool blendLutEnabled;
+		bool blendLutDirty;
+		std::vector<float> blendLutData;
+		ofTexture blendLut;
+
+		std::shared_ptr<ofShader> shader;
+		int shaderFeatures;
+		//! value of shaderVariantsGeneration when the shader was fetched
+		size_t shaderGeneration;
+
+		std::shared_ptr<CalibrationChannel> calibrationChannel;
+		uint64_t calibrationFrame;
+		std::vector<glm::vec2> calibrationPoints;
+
+		Counters counters;
+
+		bool gpuTimingEnabled;
+		GpuTimer contentGpuTimer;
+		GpuTimer warpGpuTimer;
+
+		static const int BLEND_LUT_SIZE = 256;
 
 		static std::filesystem::path shaderPath;
 
 	private:
+		static void onExit(ofEventArgs & args);
+
+		static std::map<std::pair<std::string, int>, std::shared_ptr<ofShader>> shaderVariants;
+		//! bumped by releaseShaderVariants(), so warps drop the unloaded programs they still hold
+		static size_t shaderVariantsGeneration;
+
 		typedef enum
 		{
 			INSTANCE_POS_SCALE_ATTRIBUTE = 5,
 			INSTANCE_COLOR_ATTRIBUTE = 6
 		} Attribute;
 
+		//! initial capacity of the control point instance buffers
+		static const int MIN_NUM_CONTROL_INSTANCES = 1024;
+
 		typedef struct ControlData
 		{
 			glm::vec2 pos;
 			float scale;
-			float dummy;
+			float selected;
 			ofFloatColor color;
 
 			ControlData() 
 			{}
 
-			ControlData(const glm::vec2 & pos, const ofFloatColor & color, float scale)
+			ControlData(const glm::vec2 & pos, const ofFloatColor & color, float scale, bool selected)
 				: pos(pos)
-				, color(color)
 				, scale(scale)
+				, selected(selected ? 1.0f : 0.0f)
+				, color(color)
 			{}
+
+			bool operator!=(const ControlData & other) const
+			{
+				return (this->pos != other.pos || this->scale != other.scale || this->selected != other.selected || this->color != other.color);
+			}
 		} ControlData;
 
+		//! instances queued last frame, kept to only upload the ones that change
 		std::vector<ControlData> controlData;
+		size_t numQueuedControls;
+		size_t controlsDirtyBegin;
+		size_t controlsDirtyEnd;
+		//! instance buffer shared by both instance attributes of the control mesh
+		ofBufferObject controlInstances;
+		//! capacity of the instance buffer of the control mesh
+		size_t numControlInstances;
 		ofVboMesh controlMesh;
 		ofShader controlShader;
 	};
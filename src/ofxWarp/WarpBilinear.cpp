@@ -1,14 +1,96 @@
 #include "WarpBilinear.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
 #include "ofGraphics.h"
 #include "ofPolyline.h"
 
+#include "Trace.h"
+
 namespace ofxWarp
 {
+	namespace
+	{
+		//--------------------------------------------------------------
+		// Return whether p lies in the triangle abc, with weights receiving its coordinates along ab and ac.
+		bool intersectTriangle(const glm::vec2 & p, const glm::vec2 & a, const glm::vec2 & b, const glm::vec2 & c, glm::vec2 & weights)
+		{
+			auto ab = b - a;
+			auto ac = c - a;
+			auto ap = p - a;
+			auto det = ab.x * ac.y - ab.y * ac.x;
+			if (fabs(det) < 1e-12f) return false;
+
+			weights.x = (ap.x * ac.y - ap.y * ac.x) / det;
+			weights.y = (ab.x * ap.y - ab.y * ap.x) / det;
+
+			// Small tolerance so that points on shared edges are not missed.
+			static const float epsilon = 1e-5f;
+			return (weights.x >= -epsilon && weights.y >= -epsilon && weights.x + weights.y <= 1.0f + epsilon);
+		}
+
+		//--------------------------------------------------------------
+		// Catmull-Rom interpolation between k1 and k2, with the same arithmetic as WarpBilinear::cubicInterpolate().
+		inline glm::vec2 catmullRom(const glm::vec2 & k0, const glm::vec2 & k1, const glm::vec2 & k2, const glm::vec2 & k3, float t)
+		{
+			return (k1 + 0.5f * t * (k2 - k0 + t * (2.0f * k0 - 5.0f * k1 + 4.0f * k2 - k3 + t * (3.0f * (k1 - k2) + k3 - k0))));
+		}
+
+		//--------------------------------------------------------------
+		// Knots of a grid of NX by NY control points, padded with one column and row before it and two after it.
+		template<int NX, int NY>
+		using FixedKnots = glm::vec2[NX + 3][NY + 3];
+
+		//--------------------------------------------------------------
+		// Evaluate the vertices of a range of mesh columns, with the same arithmetic as WarpBilinear::updateMeshGeneric() so that both give the same vertices.
+		// The grid size and interpolation are known at compile time, so the knot lookups are constant offsets and the inner loops unroll.
+		template<int NX, int NY, bool LINEAR>
+		void evaluateMeshFixed(const FixedKnots<NX, NY> & knots, int resolutionX, int resolutionY, const glm::vec2 & windowSize, int firstColumn, int numColumns, glm::vec3 * vertices)
+		{
+			for (auto x = firstColumn; x < firstColumn + numColumns; ++x)
+			{
+				auto u = x * (NX - 1) / (float)(resolutionX - 1);
+				auto col = (int)u;
+				u -= col;
+
+				for (auto y = 0; y < resolutionY; ++y)
+				{
+					auto v = y * (NY - 1) / (float)(resolutionY - 1);
+					auto row = (int)v;
+					v -= row;
+
+					// Control point (col, row) is at knots[col + 1][row + 1].
+					glm::vec2 pt;
+					if (LINEAR)
+					{
+						auto p1 = (1.0f - u) * knots[col + 1][row + 1] + u * knots[col + 2][row + 1];
+						auto p2 = (1.0f - u) * knots[col + 1][row + 2] + u * knots[col + 2][row + 2];
+						pt = ((1.0f - v) * p1 + v * p2) * windowSize;
+					}
+					else
+					{
+						glm::vec2 rows[4];
+						for (auto i = 0; i < 4; ++i)
+						{
+							const auto & column = knots[col + i];
+							rows[i] = catmullRom(column[row], column[row + 1], column[row + 2], column[row + 3], v);
+						}
+						pt = catmullRom(rows[0], rows[1], rows[2], rows[3], u) * windowSize;
+					}
+
+					*vertices++ = glm::vec3(pt.x, pt.y, 0.0f);
+				}
+			}
+		}
+	}
+
 	//--------------------------------------------------------------
 	WarpBilinear::WarpBilinear(const ofFbo::Settings & fboSettings)
 		: WarpBase(TYPE_BILINEAR)
 		, fboSettings(fboSettings)
+		, meshCorners(0.0f)
 		, linear(false)
 		, adaptive(true)
 		, corners(0.0f, 0.0f, 1.0f, 1.0f)
@@ -17,8 +99,6 @@ namespace ofxWarp
 		, resolution(16)  // higher value is coarser mesh
 	{
 		this->reset();
-
-		this->shader.load(WarpBase::shaderPath / "WarpBilinear");
 	}
 
 	//--------------------------------------------------------------
@@ -36,13 +116,36 @@ namespace ofxWarp
 	}
 
 	//--------------------------------------------------------------
-	void WarpBilinear::deserialize(const nlohmann::json & json)
+	void WarpBilinear::getState(State & state) const
+	{
+		WarpBase::getState(state);
+
+		state.resolution = this->resolution;
+		state.linear = this->linear;
+		state.adaptive = this->adaptive;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBilinear::setState(const State & state)
 	{
-		WarpBase::deserialize(json);
+		OFXWARP_TRACE_SCOPE("WarpBilinear::setState");
+
+		if (!WarpBase::setState(state)) return false;
+
+		if (state.resolution != this->resolution || state.linear != this->linear || state.adaptive != this->adaptive)
+		{
+			if (state.linear != this->linear)
+			{
+				++this->controlPointsRevision;
+			}
 
-		this->resolution = json["resolution"];
-		this->linear = json["linear"];
-		this->adaptive = json["adaptive"];
+			this->resolution = state.resolution;
+			this->linear = state.linear;
+			this->adaptive = state.adaptive;
+			this->dirty = true;
+		}
+
+		return true;
 	}
 
 	//--------------------------------------------------------------
@@ -62,6 +165,12 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBilinear::setLinear(bool linear)
 	{
+		// The control points stay in place but the shape between them changes.
+		if (linear != this->linear)
+		{
+			++this->controlPointsRevision;
+		}
+
 		this->linear = linear;
 		this->dirty = true;
 	}
@@ -114,16 +223,20 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBilinear::reset(const glm::vec2 & scale, const glm::vec2 & offset)
 	{
-		this->controlPoints.clear();
+		// Overwrite the points in place, the grid only reallocates when it grows.
+		this->controlPoints.resize(this->numControlsX * this->numControlsY);
+		auto point = this->controlPoints.begin();
 		for (auto x = 0; x < this->numControlsX; ++x) 
 		{
+			auto u = x / float(this->numControlsX - 1);
 			for (auto y = 0; y < this->numControlsY; ++y) 
 			{
-				this->controlPoints.push_back(glm::vec2(x / float(this->numControlsX - 1), y / float(this->numControlsY - 1)) * scale + offset);
+				*point++ = glm::vec2(u, y / float(this->numControlsY - 1)) * scale + offset;
 			}
 		}
 
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -132,11 +245,15 @@ namespace ofxWarp
 		this->setupFbo();
 
 		this->fbo.begin();
+
+		if (this->gpuTimingEnabled) this->contentGpuTimer.begin();
 	}
 
 	//--------------------------------------------------------------
 	void WarpBilinear::end()
 	{
+		if (this->gpuTimingEnabled) this->contentGpuTimer.end();
+
 		this->fbo.end();
 
 		// Draw flipped.
@@ -147,6 +264,8 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBilinear::drawTexture(const ofTexture & texture, const ofRectangle & srcBounds, const ofRectangle & dstBounds)
 	{
+		OFXWARP_TRACE_SCOPE("WarpBilinear::drawTexture");
+
 		// Clip against bounds.
 		auto srcClip = srcBounds;
 		auto dstClip = dstBounds;
@@ -178,6 +297,11 @@ namespace ofxWarp
 
 		this->setupVbo();
 
+		if (this->blendLutEnabled)
+		{
+			this->setupBlendLut();
+		}
+
 		auto currentColor = ofGetStyle().color;
 		ofPushStyle();
 		{
@@ -193,20 +317,30 @@ namespace ofxWarp
 				ofSetColor(currentColor);
 			}
 
-			this->shader.begin();
+			// Pick the cheapest shader variant for the current settings.
+			this->setupShader("WarpBilinear", this->getShaderFeatures(currentColor));
+			if (this->shader)
 			{
-				this->shader.setUniformTexture("uTexture", texture, 1);
-				this->shader.setUniform4f("uExtends", glm::vec4(this->width, this->height, this->width / float(this->numControlsX - 1), this->height / float(this->numControlsY - 1)));
-				this->shader.setUniform3f("uLuminance", this->luminance);
-				this->shader.setUniform3f("uGamma", this->gamma);
-				this->shader.setUniform4f("uEdges", this->edges);
-				this->shader.setUniform4f("uCorners", this->corners);
-				this->shader.setUniform1f("uExponent", this->exponent);
-				this->shader.setUniform1i("uEditing", this->editing);
+				this->shader->begin();
+				{
+					this->shader->setUniformTexture("uTexture", texture, 1);
+					this->shader->setUniform4f("uCorners", this->corners);
+					this->counters.numUniformUpdates += 2;
+					if (this->editing)
+					{
+						this->shader->setUniform4f("uExtends", glm::vec4(this->width, this->height, this->width / float(this->numControlsX - 1), this->height / float(this->numControlsY - 1)));
+						++this->counters.numUniformUpdates;
+					}
+					this->counters.numUniformUpdates += this->setBlendUniforms();
 
-				this->vbo.drawElements(GL_TRIANGLES, this->vbo.getNumIndices());
+					for (auto & chunk : this->meshChunks)
+					{
+						chunk.vbo.drawElements(GL_TRIANGLES, chunk.vbo.getNumIndices());
+						++this->counters.numDrawCalls;
+					}
+				}
+				this->shader->end();
 			}
-			this->shader.end();
 
 			if (wasDepthTest)
 			{
@@ -222,9 +356,10 @@ namespace ofxWarp
 		if (this->editing && this->selectedIndex < this->controlPoints.size())
 		{
 			// Draw control points.
-			for (auto i = 0; i < this->controlPoints.size(); ++i)
+			const auto & points = this->getControlPoints();
+			for (auto i = 0; i < points.size(); ++i)
 			{
-				this->queueControlPoint(this->getControlPoint(i) * this->windowSize, i == this->selectedIndex);
+				this->queueControlPoint(points[i] * this->windowSize, i == this->selectedIndex);
 			}
 
 			this->drawControlPoints();
@@ -234,11 +369,14 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBilinear::setupFbo()
 	{
+		OFXWARP_TRACE_SCOPE("WarpBilinear::setupFbo");
+
 		if (!this->fbo.isAllocated() || this->fbo.getWidth() != this->width || this->fbo.getHeight() != this->height)
 		{
 			this->fboSettings.width = this->width;
 			this->fboSettings.height = this->height;
 			this->fbo.allocate(this->fboSettings);
+			++this->counters.numFboAllocations;
 		}
 	}
 
@@ -247,103 +385,133 @@ namespace ofxWarp
 	{
 		if (this->dirty)
 		{
-			if (this->adaptive)
-			{
-				// Determine a suitable mesh resolution based on the dimensions of the window
-				// and the size of the mesh in pixels.
-				auto meshBounds = this->getMeshBounds();
-				this->setupMesh(meshBounds.getWidth() / this->resolution, meshBounds.getHeight() / this->resolution);
-			}
-			else
+			OFXWARP_TRACE_SCOPE("WarpBilinear::setupVbo");
+
+			auto start = std::chrono::steady_clock::now();
+
+			// Moving control points only changes the positions, the indices and texture coordinates are rebuilt when the layout of the mesh changes.
+			auto meshQuads = this->getMeshQuads();
+			if (this->meshChunks.empty() || this->corners != this->meshCorners ||
+				this->getMeshVertices(meshQuads.x, this->numControlsX) != this->resolutionX || this->getMeshVertices(meshQuads.y, this->numControlsY) != this->resolutionY)
 			{
-				// Use a fixed mesh resolution.
-				this->setupMesh(this->width / this->resolution, this->height / this->resolution);
+				this->setupMesh(meshQuads.x, meshQuads.y);
 			}
 			this->updateMesh();
+
+			++this->counters.numMeshRebuilds;
+			this->counters.meshRebuildNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 		}
 	}
 
 	//--------------------------------------------------------------
-	void WarpBilinear::setupMesh(int resolutionX, int resolutionY)
+	glm::ivec2 WarpBilinear::getMeshQuads() const
 	{
-		// Convert from number of quads to number of vertices.
-		++resolutionX;
-		++resolutionY;
-
-		// Find a value for resolutionX and resolutionY that can be evenly divided by numControlsX and numControlsY.
-		if (this->numControlsX < resolutionX) 
-		{
-			int dx = (resolutionX - 1) % (this->numControlsX - 1);
-			if (dx >= (this->numControlsX / 2))
-			{
-				dx -= (this->numControlsX - 1);
-			}
-			resolutionX -= dx;
-		}
-		else 
+		if (this->adaptive)
 		{
-			resolutionX = this->numControlsX;
+			// Determine a suitable mesh resolution based on the dimensions of the window
+			// and the size of the mesh in pixels.
+			auto meshBounds = this->getMeshBounds();
+			return glm::ivec2(meshBounds.getWidth() / this->resolution, meshBounds.getHeight() / this->resolution);
 		}
 
-		if (this->numControlsY < resolutionY) 
+		// Use a fixed mesh resolution.
+		return glm::ivec2(this->width / this->resolution, this->height / this->resolution);
+	}
+
+	//--------------------------------------------------------------
+	int WarpBilinear::getMeshVertices(int numQuads, int numControls) const
+	{
+		// Convert from number of quads to number of vertices.
+		auto numVertices = numQuads + 1;
+
+		// Find a value that can be evenly divided by the number of control points.
+		if (numControls < numVertices)
 		{
-			int dy = (resolutionY - 1) % (this->numControlsY - 1);
-			if (dy >= (this->numControlsY / 2))
+			int d = (numVertices - 1) % (numControls - 1);
+			if (d >= (numControls / 2))
 			{
-				dy -= (this->numControlsY - 1);
+				d -= (numControls - 1);
 			}
-			resolutionY -= dy;
-		}
-		else 
-		{
-			resolutionY = this->numControlsY;
+			return numVertices - d;
 		}
 
-		this->resolutionX = resolutionX;
-		this->resolutionY = resolutionY;
+		return numControls;
+	}
 
-		int numVertices = (resolutionX * resolutionY);
-		int numTriangles = 2 * (resolutionX - 1) * (resolutionY - 1);
-		int numIndices = numTriangles * 3;
+	//--------------------------------------------------------------
+	void WarpBilinear::setupMesh(int resolutionX, int resolutionY)
+	{
+		OFXWARP_TRACE_SCOPE("WarpBilinear::setupMesh");
 
-		// Build the static data.
-		int i = 0;
-		int j = 0;
+		// Convert from number of quads to number of vertices, so that they can be evenly divided by numControlsX and numControlsY.
+		resolutionX = this->getMeshVertices(resolutionX, this->numControlsX);
+		resolutionY = this->getMeshVertices(resolutionY, this->numControlsY);
 
-		auto indices = std::vector<ofIndexType>(numIndices);
-		auto texCoords = std::vector<glm::vec2>(numVertices);
+		this->resolutionX = resolutionX;
+		this->resolutionY = resolutionY;
 
-		for (int x = 0; x < resolutionX; ++x) 
+		// Split the mesh into chunks of columns, the last column of a chunk is repeated as the first of the next one.
+		auto columnsPerChunk = MAX(2, MAX_CHUNK_VERTICES / resolutionY);
+		auto numChunks = (resolutionX - 2) / (columnsPerChunk - 1) + 1;
+		this->meshChunks.clear();
+		this->meshChunks.resize(numChunks);
+
+		std::vector<ofIndexType> indices;
+		std::vector<glm::vec2> texCoords;
+		std::vector<glm::vec3> positions;
+		size_t numVertices = 0;
+		size_t numIndices = 0;
+		for (auto c = 0; c < numChunks; ++c)
 		{
-			for (int y = 0; y < resolutionY; ++y) 
+			auto & chunk = this->meshChunks[c];
+			chunk.firstColumn = c * (columnsPerChunk - 1);
+			chunk.numColumns = MIN(columnsPerChunk, resolutionX - chunk.firstColumn);
+
+			// Build the static data, with indices local to the chunk.
+			indices.resize(6 * (chunk.numColumns - 1) * (resolutionY - 1));
+			texCoords.resize(chunk.numColumns * resolutionY);
+
+			int i = 0;
+			int j = 0;
+			for (int x = 0; x < chunk.numColumns; ++x) 
 			{
-				// Index.
-				if (((x + 1) < resolutionX) && ((y + 1) < resolutionY)) 
+				for (int y = 0; y < resolutionY; ++y) 
 				{
-					indices[i++] = (x + 0) * resolutionY + (y + 0);
-					indices[i++] = (x + 1) * resolutionY + (y + 0);
-					indices[i++] = (x + 1) * resolutionY + (y + 1);
+					// Index.
+					if (((x + 1) < chunk.numColumns) && ((y + 1) < resolutionY)) 
+					{
+						indices[i++] = (x + 0) * resolutionY + (y + 0);
+						indices[i++] = (x + 1) * resolutionY + (y + 0);
+						indices[i++] = (x + 1) * resolutionY + (y + 1);
 
-					indices[i++] = (x + 0) * resolutionY + (y + 0);
-					indices[i++] = (x + 1) * resolutionY + (y + 1);
-					indices[i++] = (x + 0) * resolutionY + (y + 1);
-				}
+						indices[i++] = (x + 0) * resolutionY + (y + 0);
+						indices[i++] = (x + 1) * resolutionY + (y + 1);
+						indices[i++] = (x + 0) * resolutionY + (y + 1);
+					}
 
-				// Tex Coord.
-				float tx = ofLerp(this->corners.x, this->corners.z, x / (float)(this->resolutionX - 1));
-				float ty = ofLerp(this->corners.y, this->corners.w, y / (float)(this->resolutionY - 1));
-				texCoords[j++] = glm::vec2(tx, ty);
+					// Tex Coord.
+					float tx = ofLerp(this->corners.x, this->corners.z, (chunk.firstColumn + x) / (float)(this->resolutionX - 1));
+					float ty = ofLerp(this->corners.y, this->corners.w, y / (float)(this->resolutionY - 1));
+					texCoords[j++] = glm::vec2(tx, ty);
+				}
 			}
-		}
 
-		// Build placeholder data.
-		std::vector<glm::vec3> positions(this->resolutionX * this->resolutionY);
+			// Build placeholder data, the positions are written by updateMesh().
+			positions.resize(texCoords.size());
 
-		// Build mesh.
-		this->vbo.clear();
-		this->vbo.setVertexData(positions.data(), positions.size(), GL_STATIC_DRAW);
-		this->vbo.setTexCoordData(texCoords.data(), texCoords.size(), GL_STATIC_DRAW);
-		this->vbo.setIndexData(indices.data(), indices.size(), GL_STATIC_DRAW);
+			// Build mesh.
+			chunk.vbo.setVertexData(positions.data(), positions.size(), GL_DYNAMIC_DRAW);
+			chunk.vbo.setTexCoordData(texCoords.data(), texCoords.size(), GL_STATIC_DRAW);
+			chunk.vbo.setIndexData(indices.data(), indices.size(), GL_STATIC_DRAW);
+
+			numVertices += texCoords.size();
+			numIndices += indices.size();
+		}
+		this->meshCorners = this->corners;
+
+		this->counters.numVerticesUploaded += numVertices;
+		this->counters.numIndicesUploaded += numIndices;
+		this->counters.numBytesUploaded += numVertices * (sizeof(glm::vec3) + sizeof(glm::vec2)) + numIndices * sizeof(ofIndexType);
 
 		this->dirty = true;
 	}
@@ -354,23 +522,51 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBilinear::updateMesh()
 	{
-		if (!this->vbo.getIsAllocated() || !this->dirty) return;
-		
-		glm::vec2 pt;
-		float u, v;
-		int col, row;
+		if (this->meshChunks.empty() || !this->dirty) return;
 
-		std::vector<glm::vec2> cols, rows;
+		OFXWARP_TRACE_SCOPE("WarpBilinear::updateMesh");
 
+		size_t numVertices = 0;
+		for (auto & chunk : this->meshChunks)
+		{
 #if USE_MAPPED_BUFFER
-		auto vertexBuffer = this->vbo.getVertexBuffer();
-		auto mappedMesh = (glm::vec3 *)vertexBuffer.map(GL_WRITE_ONLY);
+			auto & vertexBuffer = chunk.vbo.getVertexBuffer();
+			auto vertices = (glm::vec3 *)vertexBuffer.map(GL_WRITE_ONLY);
 #else
-		std::vector<glm::vec3> positions(this->resolutionX * this->resolutionY);
-		auto index = 0;
+			std::vector<glm::vec3> positions(chunk.numColumns * this->resolutionY);
+			auto vertices = positions.data();
 #endif
 
-		for (auto x = 0; x < this->resolutionX; ++x) 
+			if (!this->updateMeshFixed(chunk.firstColumn, chunk.numColumns, vertices))
+			{
+				this->updateMeshGeneric(chunk.firstColumn, chunk.numColumns, vertices);
+			}
+
+#if USE_MAPPED_BUFFER
+			vertexBuffer.unmap();
+#else
+			chunk.vbo.updateVertexData(positions.data(), positions.size());
+#endif
+
+			numVertices += chunk.numColumns * this->resolutionY;
+		}
+
+		this->counters.numVerticesUploaded += numVertices;
+		this->counters.numBytesUploaded += numVertices * sizeof(glm::vec3);
+
+		this->dirty = false;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::updateMeshGeneric(int firstColumn, int numColumns, glm::vec3 * vertices) const
+	{
+		glm::vec2 pt;
+		float u, v;
+		int col, row;
+
+		std::vector<glm::vec2> cols, rows;
+
+		for (auto x = firstColumn; x < firstColumn + numColumns; ++x) 
 		{
 			for (auto y = 0; y < this->resolutionY; ++y) 
 			{
@@ -408,21 +604,58 @@ namespace ofxWarp
 					pt = this->cubicInterpolate(rows, u) * this->windowSize;
 				}
 
-#if USE_MAPPED_BUFFER
-				*mappedMesh++ = glm::vec3(pt.x, pt.y, 0.0f);
-#else
-				positions[index++] = glm::vec3(pt.x, pt.y, 0.0f);
-#endif
+				*vertices++ = glm::vec3(pt.x, pt.y, 0.0f);
 			}
 		}
+	}
 
-#if USE_MAPPED_BUFFER
-		vertexBuffer.unmap();
-#else
-		this->vbo.updateVertexData(positions.data(), positions.size());
-#endif
+	//--------------------------------------------------------------
+	template<int NX, int NY>
+	void WarpBilinear::updateMeshKernel(int firstColumn, int numColumns, glm::vec3 * vertices) const
+	{
+		// Copy the knots the interpolation can reach, extrapolated past the edges by getPoint(), so the lookups are plain array accesses.
+		// The last vertex of each axis falls on the last control point, and reaches two knots past it.
+		FixedKnots<NX, NY> knots;
+		for (int col = -1; col <= NX + 1; ++col)
+		{
+			for (int row = -1; row <= NY + 1; ++row)
+			{
+				knots[col + 1][row + 1] = this->getPoint(col, row);
+			}
+		}
 
-		this->dirty = false;
+		if (this->linear)
+		{
+			evaluateMeshFixed<NX, NY, true>(knots, this->resolutionX, this->resolutionY, this->windowSize, firstColumn, numColumns, vertices);
+		}
+		else
+		{
+			evaluateMeshFixed<NX, NY, false>(knots, this->resolutionX, this->resolutionY, this->windowSize, firstColumn, numColumns, vertices);
+		}
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBilinear::updateMeshFixed(int firstColumn, int numColumns, glm::vec3 * vertices) const
+	{
+		if (this->numControlsX != this->numControlsY) return false;
+
+		switch (this->numControlsX)
+		{
+		case 2:
+			this->updateMeshKernel<2, 2>(firstColumn, numColumns, vertices);
+			return true;
+		case 3:
+			this->updateMeshKernel<3, 3>(firstColumn, numColumns, vertices);
+			return true;
+		case 5:
+			this->updateMeshKernel<5, 5>(firstColumn, numColumns, vertices);
+			return true;
+		case 9:
+			this->updateMeshKernel<9, 9>(firstColumn, numColumns, vertices);
+			return true;
+		default:
+			return false;
+		}
 	}
 
 	//--------------------------------------------------------------
@@ -466,12 +699,11 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpBilinear::setNumControlsX(int n)
 	{
+		OFXWARP_TRACE_SCOPE("WarpBilinear::setNumControlsX");
+
 		// There should be a minimum of 2 control points.
 		n = MAX(2, n);
 
-		// Prevent overflow.
-		if ((n * this->numControlsY) > MAX_NUM_CONTROL_POINTS) return;
-
 		// Create a list of new points.
 		std::vector<glm::vec2> tempPoints(n * this->numControlsY);
 
@@ -546,17 +778,17 @@ namespace ofxWarp
 		this->selectedIndex = this->findClosestControlPoint(glm::vec2(ofGetMouseX(), ofGetMouseY()), &distance);
 
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
 	void WarpBilinear::setNumControlsY(int n)
 	{
+		OFXWARP_TRACE_SCOPE("WarpBilinear::setNumControlsY");
+
 		// There should be a minimum of 2 control points.
 		n = MAX(2, n);
 
-		// Prevent overflow.
-		if ((this->numControlsX * n) > MAX_NUM_CONTROL_POINTS) return;
-
 		// Create a list of new points.
 		std::vector<glm::vec2> tempPoints(this->numControlsX * n);
 
@@ -632,6 +864,7 @@ namespace ofxWarp
 		this->selectedIndex = this->findClosestControlPoint(glm::vec2(ofGetMouseX(), ofGetMouseY()), &distance);
 
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -661,54 +894,540 @@ namespace ofxWarp
 	}
 
 	//--------------------------------------------------------------
-	void WarpBilinear::rotateClockwise()
+	glm::vec2 WarpBilinear::screenToGrid(const glm::vec2 & pos) const
 	{
-		ofLogWarning("WarpBilinear::rotateClockwise") << "Not implemented!";
+		return pos;
 	}
 
 	//--------------------------------------------------------------
-	void WarpBilinear::rotateCounterclockwise()
+	glm::vec2 WarpBilinear::getGridPoint(size_t index) const
 	{
-		ofLogWarning("WarpBilinear::rotateCounterclockwise") << "Not implemented!";
+		if (index >= this->controlPoints.size()) return glm::vec2(0.0f);
+
+		return this->controlPoints[index];
 	}
 
 	//--------------------------------------------------------------
-	void WarpBilinear::flipHorizontal()
+	glm::vec2 WarpBilinear::gridToScreen(const glm::vec2 & pos) const
+	{
+		return pos;
+	}
+
+	//--------------------------------------------------------------
+	glm::vec2 WarpBilinear::mapContentToScreen(const glm::vec2 & pos) const
+	{
+		return this->gridToScreen(this->evaluateGrid(pos / this->getSize())) * this->windowSize;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBilinear::mapScreenToContent(const glm::vec2 & pos, glm::vec2 & content) const
+	{
+		glm::vec2 uv;
+		if (!this->invertGrid(this->screenToGrid(pos / this->windowSize), uv)) return false;
+
+		content = uv * this->getSize();
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::mapContentToScreen(const glm::vec2 * content, glm::vec2 * screen, size_t count) const
+	{
+		auto invSize = 1.0f / this->getSize();
+		for (size_t i = 0; i < count; ++i)
+		{
+			screen[i] = this->gridToScreen(this->evaluateGrid(content[i] * invSize)) * this->windowSize;
+		}
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpBilinear::mapScreenToContent(const glm::vec2 * screen, glm::vec2 * content, bool * valid, size_t count) const
+	{
+		auto size = this->getSize();
+		auto invWindowSize = 1.0f / this->windowSize;
+
+		size_t numCovered = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			glm::vec2 uv;
+			auto covered = this->invertGrid(this->screenToGrid(screen[i] * invWindowSize), uv);
+			if (covered)
+			{
+				content[i] = uv * size;
+				++numCovered;
+			}
+			if (valid)
+			{
+				valid[i] = covered;
+			}
+		}
+		return numCovered;
+	}
+
+	//--------------------------------------------------------------
+	ofRectangle WarpBilinear::getScreenBounds() const
 	{
-		std::vector<glm::vec2> flippedPoints;
-		for (int x = this->numControlsX - 1; x >= 0; --x)
+		this->updateInverseGrid();
+
+		// All vertices, not just the outline, as the grid may fold over its edges.
+		auto minPos = glm::vec2(std::numeric_limits<float>::max());
+		auto maxPos = glm::vec2(std::numeric_limits<float>::lowest());
+		for (const auto & vertex : this->inverseGrid.vertices)
 		{
-			for (int y = 0; y < this->numControlsY; ++y)
+			auto pt = this->gridToScreen(vertex);
+			minPos = glm::min(minPos, pt);
+			maxPos = glm::max(maxPos, pt);
+		}
+
+		return ofRectangle(minPos * this->windowSize, maxPos * this->windowSize);
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::getMesh(std::vector<glm::vec3> & positions, std::vector<glm::vec2> & texCoords, std::vector<uint32_t> & indices) const
+	{
+		// Same tessellation and triangles as the vbo mesh.
+		auto meshQuads = this->getMeshQuads();
+		auto resolutionX = this->getMeshVertices(meshQuads.x, this->numControlsX);
+		auto resolutionY = this->getMeshVertices(meshQuads.y, this->numControlsY);
+
+		positions.resize(resolutionX * resolutionY);
+		texCoords.resize(resolutionX * resolutionY);
+		indices.clear();
+		indices.reserve(6 * (resolutionX - 1) * (resolutionY - 1));
+		for (int x = 0; x < resolutionX; ++x)
+		{
+			for (int y = 0; y < resolutionY; ++y)
 			{
-				auto i = (x * this->numControlsY + y);
-				flippedPoints.push_back(this->controlPoints[i]);
+				if (((x + 1) < resolutionX) && ((y + 1) < resolutionY))
+				{
+					indices.push_back((x + 0) * resolutionY + (y + 0));
+					indices.push_back((x + 1) * resolutionY + (y + 0));
+					indices.push_back((x + 1) * resolutionY + (y + 1));
+
+					indices.push_back((x + 0) * resolutionY + (y + 0));
+					indices.push_back((x + 1) * resolutionY + (y + 1));
+					indices.push_back((x + 0) * resolutionY + (y + 1));
+				}
+
+				auto uv = glm::vec2(x / float(resolutionX - 1), y / float(resolutionY - 1));
+				texCoords[x * resolutionY + y] = uv;
+				positions[x * resolutionY + y] = glm::vec3(this->evaluateGrid(uv) * this->windowSize, 1.0f);
 			}
 		}
-		this->controlPoints = flippedPoints;
-		this->dirty = true;
+	}
 
-		// Find new closest control point.
-		float distance;
-		this->selectedIndex = this->findClosestControlPoint(glm::vec2(ofGetMouseX(), ofGetMouseY()), &distance);
+	//--------------------------------------------------------------
+	WarpBase::MemoryUsage WarpBilinear::getMemoryUsage() const
+	{
+		auto usage = WarpBase::getMemoryUsage();
+
+		usage.cpuBytes += this->inverseGrid.knots.capacity() * sizeof(glm::vec2);
+		usage.cpuBytes += this->inverseGrid.vertices.capacity() * sizeof(glm::vec2);
+		usage.cpuBytes += this->inverseGrid.binStarts.capacity() * sizeof(uint32_t);
+		usage.cpuBytes += this->inverseGrid.binCells.capacity() * sizeof(uint32_t);
+
+		for (const auto & chunk : this->meshChunks)
+		{
+			usage.vboBytes += WarpBase::getVboBytes(chunk.vbo);
+		}
+
+		if (this->fbo.isAllocated())
+		{
+			// Multisampled frame buffers draw into render buffers holding every sample, which are resolved into the textures.
+			auto numSamples = (size_t)MAX(this->fboSettings.numSamples, 0);
+			for (int i = 0; i < this->fbo.getNumTextures(); ++i)
+			{
+				usage.fboColorBytes += WarpBase::getTextureBytes(this->fbo.getTexture(i)) * (numSamples + 1);
+			}
+
+			auto numPixels = size_t(this->fbo.getWidth()) * size_t(this->fbo.getHeight()) * MAX(numSamples, (size_t)1);
+			if (this->fboSettings.useDepth && this->fboSettings.useStencil)
+			{
+				// Packed into a single 24 bit depth and 8 bit stencil attachment.
+				usage.fboDepthBytes += numPixels * 3;
+				usage.fboStencilBytes += numPixels;
+			}
+			else if (this->fboSettings.useDepth)
+			{
+				usage.fboDepthBytes += numPixels * WarpBase::getBytesPerPixel(this->fboSettings.depthStencilInternalFormat);
+			}
+			else if (this->fboSettings.useStencil)
+			{
+				usage.fboStencilBytes += numPixels;
+			}
+		}
+
+		return usage;
 	}
 
 	//--------------------------------------------------------------
-	void WarpBilinear::flipVertical()
+	glm::vec2 WarpBilinear::evaluateGrid(const glm::vec2 & uv, glm::vec2 * du, glm::vec2 * dv) const
+	{
+		this->updateKnots();
+
+		// Find the cell and the position within it, as updateMesh does.
+		auto u = ofClamp(uv.x, 0.0f, 1.0f) * (this->numControlsX - 1);
+		auto v = ofClamp(uv.y, 0.0f, 1.0f) * (this->numControlsY - 1);
+		auto col = MIN((int)u, (int)this->numControlsX - 2);
+		auto row = MIN((int)v, (int)this->numControlsY - 2);
+		u -= col;
+		v -= row;
+
+		// Weights of the 4x4 knots around the cell and their derivatives, linear interpolation only uses the inner 2x2.
+		float wu[4], wv[4], dwu[4], dwv[4];
+		if (this->linear)
+		{
+			wu[0] = 0.0f; wu[1] = 1.0f - u; wu[2] = u; wu[3] = 0.0f;
+			wv[0] = 0.0f; wv[1] = 1.0f - v; wv[2] = v; wv[3] = 0.0f;
+			dwu[0] = 0.0f; dwu[1] = -1.0f; dwu[2] = 1.0f; dwu[3] = 0.0f;
+			dwv[0] = 0.0f; dwv[1] = -1.0f; dwv[2] = 1.0f; dwv[3] = 0.0f;
+		}
+		else
+		{
+			// Catmull-Rom, expanded from cubicInterpolate.
+			wu[0] = 0.5f * u * (-1.0f + u * (2.0f - u));
+			wu[1] = 1.0f + 0.5f * u * u * (-5.0f + 3.0f * u);
+			wu[2] = 0.5f * u * (1.0f + u * (4.0f - 3.0f * u));
+			wu[3] = 0.5f * u * u * (-1.0f + u);
+			wv[0] = 0.5f * v * (-1.0f + v * (2.0f - v));
+			wv[1] = 1.0f + 0.5f * v * v * (-5.0f + 3.0f * v);
+			wv[2] = 0.5f * v * (1.0f + v * (4.0f - 3.0f * v));
+			wv[3] = 0.5f * v * v * (-1.0f + v);
+			dwu[0] = 0.5f * (-1.0f + u * (4.0f - 3.0f * u));
+			dwu[1] = 0.5f * u * (-10.0f + 9.0f * u);
+			dwu[2] = 0.5f * (1.0f + u * (8.0f - 9.0f * u));
+			dwu[3] = 0.5f * u * (-2.0f + 3.0f * u);
+			dwv[0] = 0.5f * (-1.0f + v * (4.0f - 3.0f * v));
+			dwv[1] = 0.5f * v * (-10.0f + 9.0f * v);
+			dwv[2] = 0.5f * (1.0f + v * (8.0f - 9.0f * v));
+			dwv[3] = 0.5f * v * (-2.0f + 3.0f * v);
+		}
+
+		// Padded knot (col + i - 1, row + j - 1) is at (col + i, row + j).
+		auto stride = this->numControlsY + 2;
+		auto pt = glm::vec2(0.0f);
+		auto ptU = glm::vec2(0.0f);
+		auto ptV = glm::vec2(0.0f);
+		for (auto i = 0; i < 4; ++i)
+		{
+			auto knots = &this->inverseGrid.knots[(col + i) * stride + row];
+			auto colPt = wv[0] * knots[0] + wv[1] * knots[1] + wv[2] * knots[2] + wv[3] * knots[3];
+			auto colPtV = dwv[0] * knots[0] + dwv[1] * knots[1] + dwv[2] * knots[2] + dwv[3] * knots[3];
+			pt += wu[i] * colPt;
+			ptU += dwu[i] * colPt;
+			ptV += wu[i] * colPtV;
+		}
+
+		// Derivatives with respect to normalized content coordinates.
+		if (du)
+		{
+			*du = ptU * float(this->numControlsX - 1);
+		}
+		if (dv)
+		{
+			*dv = ptV * float(this->numControlsY - 1);
+		}
+
+		return pt;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpBilinear::invertGrid(const glm::vec2 & pos, glm::vec2 & uv) const
+	{
+		this->updateInverseGrid();
+		const auto & grid = this->inverseGrid;
+
+		auto binPos = (pos - grid.binOrigin) * grid.binScale;
+		if (binPos.x < 0.0f || binPos.y < 0.0f || binPos.x >= grid.numBinsX || binPos.y >= grid.numBinsY) return false;
+
+		// Find the tessellated cell containing the position, split into triangles the same way as the mesh.
+		// Later cells are drawn on top, so they win where the grid folds over itself.
+		auto numCellsY = grid.numVerticesY - 1;
+		auto cellSize = 1.0f / glm::vec2(grid.numVerticesX - 1, numCellsY);
+		auto bin = (size_t)binPos.x * grid.numBinsY + (size_t)binPos.y;
+		auto found = false;
+		auto guess = glm::vec2(0.0f);
+		for (auto i = grid.binStarts[bin]; i < grid.binStarts[bin + 1]; ++i)
+		{
+			auto cellX = grid.binCells[i] / numCellsY;
+			auto cellY = grid.binCells[i] % numCellsY;
+			auto vertices = &grid.vertices[cellX * grid.numVerticesY + cellY];
+			const auto & v00 = vertices[0];
+			const auto & v01 = vertices[1];
+			const auto & v10 = vertices[grid.numVerticesY];
+			const auto & v11 = vertices[grid.numVerticesY + 1];
+
+			glm::vec2 weights;
+			glm::vec2 local;
+			if (intersectTriangle(pos, v00, v10, v11, weights))
+			{
+				local = glm::vec2(weights.x + weights.y, weights.y);
+			}
+			else if (intersectTriangle(pos, v00, v11, v01, weights))
+			{
+				local = glm::vec2(weights.x, weights.x + weights.y);
+			}
+			else
+			{
+				continue;
+			}
+
+			guess = (glm::vec2(cellX, cellY) + local) * cellSize;
+			found = true;
+		}
+		if (!found) return false;
+
+		// The tessellation is piecewise linear, refine on the spline itself.
+		auto best = guess;
+		auto bestError = std::numeric_limits<float>::max();
+		for (auto i = 0; i < MAX_NEWTON_ITERATIONS; ++i)
+		{
+			glm::vec2 du, dv;
+			auto delta = this->evaluateGrid(guess, &du, &dv) - pos;
+			auto error = glm::dot(delta, delta);
+			if (error < bestError)
+			{
+				best = guess;
+				bestError = error;
+			}
+			if (error < NEWTON_TOLERANCE * NEWTON_TOLERANCE) break;
+
+			auto det = du.x * dv.y - du.y * dv.x;
+			if (fabs(det) < 1e-12f) break;
+
+			guess -= glm::vec2(dv.y * delta.x - dv.x * delta.y, du.x * delta.y - du.y * delta.x) / det;
+			guess = glm::clamp(guess, glm::vec2(0.0f), glm::vec2(1.0f));
+		}
+
+		uv = best;
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::updateKnots() const
+	{
+		auto stride = this->numControlsY + 2;
+		auto numKnots = (this->numControlsX + 2) * stride;
+		if (this->inverseGrid.knotsRevision == this->controlPointsRevision && this->inverseGrid.knots.size() == numKnots) return;
+
+		this->inverseGrid.knots.resize(numKnots);
+		for (int col = -1; col <= (int)this->numControlsX; ++col)
+		{
+			for (int row = -1; row <= (int)this->numControlsY; ++row)
+			{
+				this->inverseGrid.knots[(col + 1) * stride + (row + 1)] = this->getPoint(col, row);
+			}
+		}
+
+		this->inverseGrid.knotsRevision = this->controlPointsRevision;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::updateInverseGrid() const
 	{
-		std::vector<glm::vec2> flippedPoints;
-		for (int x = 0; x < this->numControlsX; ++x)
+		OFXWARP_TRACE_SCOPE("WarpBilinear::updateInverseGrid");
+
+		auto & grid = this->inverseGrid;
+		if (grid.verticesRevision == this->controlPointsRevision && grid.verticesLinear == this->linear && grid.numVerticesX > 0) return;
+
+		// Linear cells have straight edges, so one quad per cell covers them exactly.
+		auto maxCells = int(MAX(this->numControlsX, this->numControlsY) - 1);
+		auto subdivisions = this->linear ? 1 : MIN(MAX(MAX_INVERSE_VERTICES / maxCells, 1), MAX_INVERSE_SUBDIVISIONS);
+		grid.numVerticesX = (this->numControlsX - 1) * subdivisions + 1;
+		grid.numVerticesY = (this->numControlsY - 1) * subdivisions + 1;
+
+		// Tessellate.
+		auto minPos = glm::vec2(std::numeric_limits<float>::max());
+		auto maxPos = glm::vec2(std::numeric_limits<float>::lowest());
+		grid.vertices.resize(grid.numVerticesX * grid.numVerticesY);
+		for (size_t x = 0; x < grid.numVerticesX; ++x)
 		{
-			for (int y = this->numControlsY - 1; y >= 0; --y)
+			for (size_t y = 0; y < grid.numVerticesY; ++y)
 			{
-				auto i = (x * this->numControlsY + y);
-				flippedPoints.push_back(this->controlPoints[i]);
+				auto pt = this->evaluateGrid(glm::vec2(x / float(grid.numVerticesX - 1), y / float(grid.numVerticesY - 1)));
+				grid.vertices[x * grid.numVerticesY + y] = pt;
+				minPos = glm::min(minPos, pt);
+				maxPos = glm::max(maxPos, pt);
 			}
 		}
-		this->controlPoints = flippedPoints;
+
+		// About one cell per bin.
+		auto numCellsX = grid.numVerticesX - 1;
+		auto numCellsY = grid.numVerticesY - 1;
+		auto numBins = (size_t)ceilf(sqrtf(numCellsX * numCellsY));
+		grid.numBinsX = numBins;
+		grid.numBinsY = numBins;
+		grid.binOrigin = minPos;
+		grid.binScale = glm::vec2(numBins) / glm::max(maxPos - minPos, glm::vec2(1e-6f));
+
+		// Sort the cells into every bin their bounds overlap, counting first to lay them out contiguously.
+		auto getBinRange = [&](size_t cell, size_t & x0, size_t & y0, size_t & x1, size_t & y1)
+		{
+			auto vertices = &grid.vertices[(cell / numCellsY) * grid.numVerticesY + (cell % numCellsY)];
+			auto cellMin = glm::min(glm::min(vertices[0], vertices[1]), glm::min(vertices[grid.numVerticesY], vertices[grid.numVerticesY + 1]));
+			auto cellMax = glm::max(glm::max(vertices[0], vertices[1]), glm::max(vertices[grid.numVerticesY], vertices[grid.numVerticesY + 1]));
+			auto binMin = glm::clamp((cellMin - grid.binOrigin) * grid.binScale, glm::vec2(0.0f), glm::vec2(numBins - 1));
+			auto binMax = glm::clamp((cellMax - grid.binOrigin) * grid.binScale, glm::vec2(0.0f), glm::vec2(numBins - 1));
+			x0 = (size_t)binMin.x;
+			y0 = (size_t)binMin.y;
+			x1 = (size_t)binMax.x;
+			y1 = (size_t)binMax.y;
+		};
+
+		auto numCells = numCellsX * numCellsY;
+		grid.binStarts.assign(numBins * numBins + 1, 0);
+		for (size_t cell = 0; cell < numCells; ++cell)
+		{
+			size_t x0, y0, x1, y1;
+			getBinRange(cell, x0, y0, x1, y1);
+			for (auto x = x0; x <= x1; ++x)
+			{
+				for (auto y = y0; y <= y1; ++y)
+				{
+					++grid.binStarts[x * numBins + y + 1];
+				}
+			}
+		}
+		for (size_t i = 0; i < numBins * numBins; ++i)
+		{
+			grid.binStarts[i + 1] += grid.binStarts[i];
+		}
+
+		std::vector<uint32_t> binEnds(grid.binStarts.begin(), grid.binStarts.end() - 1);
+		grid.binCells.resize(grid.binStarts.back());
+		for (size_t cell = 0; cell < numCells; ++cell)
+		{
+			size_t x0, y0, x1, y1;
+			getBinRange(cell, x0, y0, x1, y1);
+			for (auto x = x0; x <= x1; ++x)
+			{
+				for (auto y = y0; y <= y1; ++y)
+				{
+					grid.binCells[binEnds[x * numBins + y]++] = cell;
+				}
+			}
+		}
+
+		grid.verticesRevision = this->controlPointsRevision;
+		grid.verticesLinear = this->linear;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::transposeControlPoints()
+	{
+		OFXWARP_TRACE_SCOPE("WarpBilinear::transposeControlPoints");
+
+		auto & points = this->controlPoints;
+		const auto numColumns = this->numControlsX;
+		const auto numRows = this->numControlsY;
+		if (numColumns == numRows)
+		{
+			// Swap the points on either side of the diagonal one tile at a time, so that both tiles stay in cache.
+			static const size_t TILE_SIZE = 16;
+			for (size_t tileX = 0; tileX < numColumns; tileX += TILE_SIZE)
+			{
+				for (size_t tileY = tileX; tileY < numRows; tileY += TILE_SIZE)
+				{
+					auto endX = MIN(tileX + TILE_SIZE, numColumns);
+					auto endY = MIN(tileY + TILE_SIZE, numRows);
+					for (auto x = tileX; x < endX; ++x)
+					{
+						for (auto y = MAX(tileY, x + 1); y < endY; ++y)
+						{
+							std::swap(points[x * numRows + y], points[y * numColumns + x]);
+						}
+					}
+				}
+			}
+		}
+		else if (points.size() > 2)
+		{
+			// Follow the cycles of the permutation, the point at index i moves to (i * numColumns) % (size - 1).
+			// Each cycle is only moved from its smallest index, the first and last points stay in place.
+			const auto last = points.size() - 1;
+			for (size_t start = 1; start < last; ++start)
+			{
+				auto index = (start * numColumns) % last;
+				while (index > start)
+				{
+					index = (index * numColumns) % last;
+				}
+				if (index < start) continue;
+
+				auto point = points[start];
+				do
+				{
+					index = (index * numColumns) % last;
+					std::swap(point, points[index]);
+				} while (index != start);
+			}
+		}
+
+		if (this->selectedIndex < points.size())
+		{
+			this->selectedIndex = (this->selectedIndex % numRows) * numColumns + this->selectedIndex / numRows;
+		}
+
+		std::swap(this->numControlsX, this->numControlsY);
 		this->dirty = true;
+		++this->controlPointsRevision;
+	}
 
-		// Find new closest control point.
-		float distance;
-		this->selectedIndex = this->findClosestControlPoint(glm::vec2(ofGetMouseX(), ofGetMouseY()), &distance);
+	//--------------------------------------------------------------
+	void WarpBilinear::rotateClockwise()
+	{
+		// The top row of the content ends up along the right column of the grid.
+		this->transposeControlPoints();
+		this->flipVertical();
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::rotateCounterclockwise()
+	{
+		// The top row of the content ends up along the left column of the grid.
+		this->transposeControlPoints();
+		this->flipHorizontal();
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::flipHorizontal()
+	{
+		// Columns are contiguous, so swap them whole from both ends.
+		auto begin = this->controlPoints.begin();
+		for (size_t x = 0; x < this->numControlsX / 2; ++x)
+		{
+			auto column = begin + x * this->numControlsY;
+			std::swap_ranges(column, column + this->numControlsY, begin + (this->numControlsX - 1 - x) * this->numControlsY);
+		}
+
+		if (this->selectedIndex < this->controlPoints.size())
+		{
+			auto x = this->selectedIndex / this->numControlsY;
+			auto y = this->selectedIndex % this->numControlsY;
+			this->selectedIndex = (this->numControlsX - 1 - x) * this->numControlsY + y;
+		}
+
+		this->dirty = true;
+		++this->controlPointsRevision;
+	}
+
+	//--------------------------------------------------------------
+	void WarpBilinear::flipVertical()
+	{
+		auto begin = this->controlPoints.begin();
+		for (size_t x = 0; x < this->numControlsX; ++x)
+		{
+			auto column = begin + x * this->numControlsY;
+			std::reverse(column, column + this->numControlsY);
+		}
+
+		if (this->selectedIndex < this->controlPoints.size())
+		{
+			auto x = this->selectedIndex / this->numControlsY;
+			auto y = this->selectedIndex % this->numControlsY;
+			this->selectedIndex = x * this->numControlsY + (this->numControlsY - 1 - y);
+		}
+
+		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 }
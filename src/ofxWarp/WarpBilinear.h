@@ -15,7 +15,9 @@ namespace ofxWarp
 		virtual ~WarpBilinear();
 
 		virtual void serialize(nlohmann::json & json) override;
-		virtual void deserialize(const nlohmann::json & json) override;
+
+		virtual void getState(State & state) const override;
+		virtual bool setState(const State & state) override;
 
 		virtual void setSize(float width, float height) override;
 
@@ -52,6 +54,29 @@ namespace ofxWarp
 
 		void setCorners(float left, float top, float right, float bottom);
 
+		//! convert a position in normalized screen space to the space the grid is evaluated in
+		virtual glm::vec2 screenToGrid(const glm::vec2 & pos) const;
+		//! return the control point as stored in the grid, before any perspective
+		glm::vec2 getGridPoint(size_t index) const;
+		//! convert a position in the space the grid is evaluated in to normalized screen space
+		virtual glm::vec2 gridToScreen(const glm::vec2 & pos) const;
+
+		//! map a position in content pixels to window pixels, positions outside of the content are clamped to its edges
+		virtual glm::vec2 mapContentToScreen(const glm::vec2 & pos) const override;
+		//! map a position in window pixels back to content pixels, return false and leave content untouched if the warp does not cover it
+		virtual bool mapScreenToContent(const glm::vec2 & pos, glm::vec2 & content) const override;
+		//! map count positions in content pixels to window pixels
+		virtual void mapContentToScreen(const glm::vec2 * content, glm::vec2 * screen, size_t count) const override;
+		//! map count positions in window pixels back to content pixels, valid (if set) receives whether each one is covered, return the number covered
+		virtual size_t mapScreenToContent(const glm::vec2 * screen, glm::vec2 * content, bool * valid, size_t count) const override;
+		//! return the bounds of the area covered by the warp, in window pixels
+		virtual ofRectangle getScreenBounds() const override;
+		//! build the triangles drawn for the content, with homogeneous window positions (x, y, w) and normalized content coordinates
+		virtual void getMesh(std::vector<glm::vec3> & positions, std::vector<glm::vec2> & texCoords, std::vector<uint32_t> & indices) const override;
+
+		//! return the memory currently held by the warp, including its frame buffer and mesh
+		virtual MemoryUsage getMemoryUsage() const override;
+
 		virtual void rotateClockwise() override;
 		virtual void rotateCounterclockwise() override;
 
@@ -70,8 +95,21 @@ namespace ofxWarp
 		void setupVbo();
 		//! set up the vbo mesh
 		void setupMesh(int resolutionX = 36, int resolutionY = 36);
+		//! return the number of quads along each axis of the mesh, based on the resolution settings
+		glm::ivec2 getMeshQuads() const;
+		//! return the number of vertices along an axis for the number of quads, adjusted so that every control point falls on a vertex
+		int getMeshVertices(int numQuads, int numControls) const;
 		//! update the vbo mesh based on the control points
 		void updateMesh();
+		//! evaluate the vertices of a range of mesh columns for any grid size
+		void updateMeshGeneric(int firstColumn, int numColumns, glm::vec3 * vertices) const;
+		//! evaluate the vertices of a range of mesh columns with a kernel sized at compile time if there is one for the grid size (2x2, 3x3, 5x5 or 9x9), return false otherwise
+		bool updateMeshFixed(int firstColumn, int numColumns, glm::vec3 * vertices) const;
+		//! evaluate the vertices of a range of mesh columns of a NX by NY grid from a local copy of its knots
+		template<int NX, int NY>
+		void updateMeshKernel(int firstColumn, int numColumns, glm::vec3 * vertices) const;
+		//! transpose the grid of control points in place, swapping the number of controls along each axis
+		void transposeControlPoints();
 		//!	return the specified control point, values for col and row are clamped to prevent errors.
 		glm::vec2 getPoint(int col, int row) const;
 		//! perform fast Catmull-Rom interpolation, and return the interpolated value at t
@@ -79,11 +117,30 @@ namespace ofxWarp
 		//!
 		ofRectangle getMeshBounds() const;
 
+		//! evaluate the grid at the normalized content position exactly as updateMesh does, optionally returning the partial derivatives
+		glm::vec2 evaluateGrid(const glm::vec2 & uv, glm::vec2 * du = nullptr, glm::vec2 * dv = nullptr) const;
+		//! find the normalized content position where the grid evaluates to pos, return false if the grid does not cover it
+		bool invertGrid(const glm::vec2 & pos, glm::vec2 & uv) const;
+		//! copy the control points into a grid padded with the extrapolated edges, if they changed
+		void updateKnots() const;
+		//! tessellate the grid and bin its cells for inverse queries, if the control points changed
+		void updateInverseGrid() const;
+
 	protected:
 		ofFbo fbo;
 		ofFbo::Settings fboSettings;
-		ofVbo vbo;
-		ofShader shader;
+
+		//! part of the mesh drawn in one call, a range of vertex columns sharing its edge columns with the neighboring chunks
+		typedef struct MeshChunk
+		{
+			int firstColumn;
+			int numColumns;
+			ofVbo vbo;
+		} MeshChunk;
+
+		std::vector<MeshChunk> meshChunks;
+		//! corners the texture coordinates of the mesh were built for
+		glm::vec4 meshCorners;
 
 		//! linear or curved interpolation
 		bool linear;
@@ -101,6 +158,50 @@ namespace ofxWarp
 		//! number of vertical quads
 		int resolutionY;
 
+		//! acceleration structure for inverse queries, in the space the grid is evaluated in
+		typedef struct InverseGrid
+		{
+			//! control points padded with one extrapolated column and row on each side
+			std::vector<glm::vec2> knots;
+			size_t knotsRevision;
+
+			//! tessellated grid, column major
+			std::vector<glm::vec2> vertices;
+			size_t numVerticesX;
+			size_t numVerticesY;
+			size_t verticesRevision;
+			bool verticesLinear;
+
+			//! cells of the tessellated grid sorted into uniform bins by their bounds
+			glm::vec2 binOrigin;
+			glm::vec2 binScale;
+			size_t numBinsX;
+			size_t numBinsY;
+			std::vector<uint32_t> binStarts;
+			std::vector<uint32_t> binCells;
+
+			InverseGrid()
+				: knotsRevision(-1)
+				, numVerticesX(0)
+				, numVerticesY(0)
+				, verticesRevision(-1)
+				, verticesLinear(false)
+				, numBinsX(0)
+				, numBinsY(0)
+			{}
+		} InverseGrid;
+
+		mutable InverseGrid inverseGrid;
+
+		//! maximum number of tessellated cells per control point cell, and in total along each axis
+		static const int MAX_INVERSE_SUBDIVISIONS = 8;
+		static const int MAX_INVERSE_VERTICES = 256;
+		//! iteration limit of the Newton refinement, which stops once the position is within the tolerance in grid space
+		static const int MAX_NEWTON_ITERATIONS = 8;
+		static constexpr float NEWTON_TOLERANCE = 1e-6f;
+		//! maximum number of vertices in a mesh chunk, so that indices fit in 16 bits on OpenGL ES and each buffer stays quick to update
+		static const int MAX_CHUNK_VERTICES = 65536;
+
 	private:
 		//! greatest common divisor using Euclidian algorithm (from: http://en.wikipedia.org/wiki/Greatest_common_divisor)
 		inline int gcd(int a, int b) const
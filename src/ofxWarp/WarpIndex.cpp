@@ -0,0 +1,279 @@
+#include "WarpIndex.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ofxWarp
+{
+	//--------------------------------------------------------------
+	WarpIndex::WarpIndex()
+		: builtCost(0.0f)
+		, numRebuilds(0)
+		, numRefits(0)
+	{}
+
+	//--------------------------------------------------------------
+	void WarpIndex::update(const std::vector<std::shared_ptr<WarpBase>> & warps)
+	{
+		// Rebuild from scratch if warps were added, removed or reordered.
+		auto rebuild = (warps.size() != this->entries.size());
+		for (size_t i = 0; i < warps.size() && !rebuild; ++i)
+		{
+			rebuild = (warps[i].get() != this->entries[i].warp);
+		}
+		if (rebuild)
+		{
+			this->clear();
+
+			this->entries.resize(warps.size());
+			for (size_t i = 0; i < warps.size(); ++i)
+			{
+				this->entries[i].warp = warps[i].get();
+				this->entries[i].revision = -1;
+			}
+		}
+
+		// Pick up the footprints of warps that changed.
+		auto changed = false;
+		for (size_t i = 0; i < warps.size(); ++i)
+		{
+			auto & entry = this->entries[i];
+
+			auto revision = warps[i]->getControlPointsRevision();
+			if (revision == entry.revision) continue;
+
+			auto bounds = warps[i]->getScreenBounds();
+			entry.min = glm::vec2(bounds.getMin());
+			entry.max = glm::vec2(bounds.getMax());
+			entry.revision = revision;
+			changed = true;
+		}
+
+		if (rebuild)
+		{
+			this->order.resize(this->entries.size());
+			for (size_t i = 0; i < this->order.size(); ++i)
+			{
+				this->order[i] = i;
+			}
+
+			if (!this->entries.empty())
+			{
+				this->build(0, this->entries.size());
+			}
+			this->builtCost = this->refit();
+			++this->numRebuilds;
+		}
+		else if (changed)
+		{
+			// Moving warps around only loosens the tree, rebuild once queries would visit too many nodes.
+			auto cost = this->refit();
+			++this->numRefits;
+			if (cost > 2.0f * this->builtCost)
+			{
+				this->nodes.clear();
+				this->build(0, this->entries.size());
+				this->builtCost = this->refit();
+				++this->numRebuilds;
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+	void WarpIndex::clear()
+	{
+		this->entries.clear();
+		this->nodes.clear();
+		this->order.clear();
+		this->builtCost = 0.0f;
+	}
+
+	//--------------------------------------------------------------
+	bool WarpIndex::findTopmost(const glm::vec2 & pos, Hit & hit) const
+	{
+		if (this->nodes.empty()) return false;
+
+		auto found = false;
+
+		uint32_t stack[MAX_DEPTH];
+		size_t stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const auto & node = this->nodes[stack[--stackSize]];
+			if (found && node.maxWarpIndex < hit.warpIndex) continue;
+			if (pos.x < node.min.x || pos.y < node.min.y || pos.x > node.max.x || pos.y > node.max.y) continue;
+
+			if (node.count == 0)
+			{
+				// Visit the child holding the later drawn warps first, so that it is more likely to prune the other.
+				uint32_t left = &node - this->nodes.data() + 1;
+				uint32_t right = node.offset;
+				if (this->nodes[left].maxWarpIndex > this->nodes[right].maxWarpIndex)
+				{
+					std::swap(left, right);
+				}
+				stack[stackSize++] = left;
+				stack[stackSize++] = right;
+				continue;
+			}
+
+			for (auto i = node.offset; i < node.offset + node.count; ++i)
+			{
+				// Only warps drawn later than the current hit can be on top of it.
+				auto warpIndex = this->order[i];
+				if (found && warpIndex < hit.warpIndex) continue;
+
+				const auto & entry = this->entries[warpIndex];
+				if (pos.x < entry.min.x || pos.y < entry.min.y || pos.x > entry.max.x || pos.y > entry.max.y) continue;
+
+				glm::vec2 content;
+				if (entry.warp->mapScreenToContent(pos, content))
+				{
+					hit = Hit(warpIndex, content);
+					found = true;
+				}
+			}
+		}
+
+		return found;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpIndex::findAll(const glm::vec2 & pos, std::vector<Hit> & hits) const
+	{
+		hits.clear();
+		if (this->nodes.empty()) return 0;
+
+		uint32_t stack[MAX_DEPTH];
+		size_t stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const auto & node = this->nodes[stack[--stackSize]];
+			if (pos.x < node.min.x || pos.y < node.min.y || pos.x > node.max.x || pos.y > node.max.y) continue;
+
+			if (node.count == 0)
+			{
+				stack[stackSize++] = node.offset;
+				stack[stackSize++] = &node - this->nodes.data() + 1;
+				continue;
+			}
+
+			for (auto i = node.offset; i < node.offset + node.count; ++i)
+			{
+				auto warpIndex = this->order[i];
+				const auto & entry = this->entries[warpIndex];
+				if (pos.x < entry.min.x || pos.y < entry.min.y || pos.x > entry.max.x || pos.y > entry.max.y) continue;
+
+				glm::vec2 content;
+				if (entry.warp->mapScreenToContent(pos, content))
+				{
+					hits.push_back(Hit(warpIndex, content));
+				}
+			}
+		}
+
+		// Topmost first.
+		std::sort(hits.begin(), hits.end(), [](const Hit & a, const Hit & b)
+		{
+			return (a.warpIndex > b.warpIndex);
+		});
+
+		return hits.size();
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpIndex::getNumWarps() const
+	{
+		return this->entries.size();
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpIndex::getNumRebuilds() const
+	{
+		return this->numRebuilds;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpIndex::getNumRefits() const
+	{
+		return this->numRefits;
+	}
+
+	//--------------------------------------------------------------
+	uint32_t WarpIndex::build(size_t begin, size_t end)
+	{
+		auto index = (uint32_t)this->nodes.size();
+		this->nodes.push_back(Node());
+
+		if (end - begin <= MAX_LEAF_SIZE)
+		{
+			this->nodes[index].offset = begin;
+			this->nodes[index].count = end - begin;
+			return index;
+		}
+
+		// Split at the median center along the longest axis of the centers.
+		auto minCenter = glm::vec2(std::numeric_limits<float>::max());
+		auto maxCenter = glm::vec2(std::numeric_limits<float>::lowest());
+		for (auto i = begin; i < end; ++i)
+		{
+			const auto & entry = this->entries[this->order[i]];
+			auto center = (entry.min + entry.max) * 0.5f;
+			minCenter = glm::min(minCenter, center);
+			maxCenter = glm::max(maxCenter, center);
+		}
+		auto axis = ((maxCenter.x - minCenter.x) >= (maxCenter.y - minCenter.y)) ? 0 : 1;
+
+		auto middle = begin + (end - begin) / 2;
+		std::nth_element(this->order.begin() + begin, this->order.begin() + middle, this->order.begin() + end, [&](uint32_t a, uint32_t b)
+		{
+			return (this->entries[a].min[axis] + this->entries[a].max[axis] < this->entries[b].min[axis] + this->entries[b].max[axis]);
+		});
+
+		// The left child directly follows its parent.
+		this->build(begin, middle);
+		auto right = this->build(middle, end);
+		this->nodes[index].offset = right;
+		this->nodes[index].count = 0;
+
+		return index;
+	}
+
+	//--------------------------------------------------------------
+	float WarpIndex::refit()
+	{
+		// Children always come after their parent, so walking backwards visits them first.
+		auto cost = 0.0f;
+		for (auto i = (int)this->nodes.size() - 1; i >= 0; --i)
+		{
+			auto & node = this->nodes[i];
+			if (node.count > 0)
+			{
+				node.min = glm::vec2(std::numeric_limits<float>::max());
+				node.max = glm::vec2(std::numeric_limits<float>::lowest());
+				node.maxWarpIndex = 0;
+				for (auto j = node.offset; j < node.offset + node.count; ++j)
+				{
+					const auto & entry = this->entries[this->order[j]];
+					node.min = glm::min(node.min, entry.min);
+					node.max = glm::max(node.max, entry.max);
+					node.maxWarpIndex = MAX(node.maxWarpIndex, this->order[j]);
+				}
+			}
+			else
+			{
+				const auto & left = this->nodes[i + 1];
+				const auto & right = this->nodes[node.offset];
+				node.min = glm::min(left.min, right.min);
+				node.max = glm::max(left.max, right.max);
+				node.maxWarpIndex = MAX(left.maxWarpIndex, right.maxWarpIndex);
+			}
+
+			auto size = node.max - node.min;
+			cost += size.x + size.y;
+		}
+		return cost;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "WarpBase.h"
+
+namespace ofxWarp
+{
+	//! bounding volume hierarchy over the screen footprints of all warps, for fast point in warp queries
+	class WarpIndex
+	{
+	public:
+		typedef struct Hit
+		{
+			//! index of the warp in drawing order
+			size_t warpIndex;
+			//! position in the content of the warp, in pixels
+			glm::vec2 content;
+
+			Hit()
+				: warpIndex(-1)
+				, content(0.0f)
+			{}
+
+			Hit(size_t warpIndex, const glm::vec2 & content)
+				: warpIndex(warpIndex)
+				, content(content)
+			{}
+		} Hit;
+
+		WarpIndex();
+
+		//! bring the hierarchy up to date, refitting the bounds of warps that changed and rebuilding when warps were added, removed or reordered
+		void update(const std::vector<std::shared_ptr<WarpBase>> & warps);
+		//! remove all warps from the hierarchy
+		void clear();
+
+		//! find the topmost warp (the last one drawn) covering the position in pixels, return false if there is none
+		bool findTopmost(const glm::vec2 & pos, Hit & hit) const;
+		//! find all warps covering the position in pixels, topmost first, return the number found
+		size_t findAll(const glm::vec2 & pos, std::vector<Hit> & hits) const;
+
+		//! return the number of indexed warps
+		size_t getNumWarps() const;
+		//! return the number of times the hierarchy was rebuilt from scratch
+		size_t getNumRebuilds() const;
+		//! return the number of times the bounds of the hierarchy were refitted
+		size_t getNumRefits() const;
+
+	protected:
+		typedef struct Entry
+		{
+			const WarpBase * warp;
+			size_t revision;
+			glm::vec2 min;
+			glm::vec2 max;
+		} Entry;
+
+		//! nodes are stored depth first, so the left child of an inner node directly follows it
+		typedef struct Node
+		{
+			glm::vec2 min;
+			glm::vec2 max;
+			//! index of the right child for inner nodes, or of the first entry in the order list for leaves
+			uint32_t offset;
+			//! number of entries in a leaf, 0 for inner nodes
+			uint32_t count;
+			//! highest warp index in the subtree, topmost queries skip subtrees drawn below their current hit
+			uint32_t maxWarpIndex;
+		} Node;
+
+		//! build the subtree over the range of the order list, return the index of its root
+		uint32_t build(size_t begin, size_t end);
+		//! recompute the bounds of all nodes from the bounds of the entries, return the summed node perimeters
+		float refit();
+
+	protected:
+		std::vector<Entry> entries;
+		std::vector<Node> nodes;
+		//! entry indices, leaves reference ranges of this list
+		std::vector<uint32_t> order;
+
+		//! summed node perimeters after the last build, refits that degrade it too much trigger a rebuild
+		float builtCost;
+
+		size_t numRebuilds;
+		size_t numRefits;
+
+		static const size_t MAX_LEAF_SIZE = 4;
+		static const size_t MAX_DEPTH = 64;
+	};
+}
@@ -2,6 +2,9 @@
 
 #include "ofGraphics.h"
 
+#include "Homography.h"
+#include "Trace.h"
+
 namespace ofxWarp
 {
 	//--------------------------------------------------------------
@@ -14,8 +17,6 @@ namespace ofxWarp
 		this->srcPoints[3] = glm::vec2(0.0f, this->height);
 
 		this->reset();
-
-		this->shader.load(WarpBase::shaderPath / "WarpPerspective");
 	}
 
 	//--------------------------------------------------------------
@@ -25,8 +26,12 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	const glm::mat4 & WarpPerspective::getTransform()
 	{
+		this->pollCalibrationChannel();
+
 		// Calculate warp matrix.
 		if (this->dirty) {
+			OFXWARP_TRACE_SCOPE("WarpPerspective::getTransform");
+
 			// Update source size.
 			this->srcPoints[1].x = this->width;
 			this->srcPoints[2].x = this->width;
@@ -40,8 +45,9 @@ namespace ofxWarp
 			}
 
 			// Calculate warp matrix.
-			this->transform = getPerspectiveTransform(this->srcPoints, this->dstPoints);
-			this->transformInverted = glm::inverse(this->transform);
+			auto homography = this->getHomography();
+			this->transform = Homography::toMat4(homography);
+			this->transformInverted = Homography::toMat4(Homography::invert(homography));
 
 			this->dirty = false;
 		}
@@ -60,6 +66,105 @@ namespace ofxWarp
 		return this->transformInverted;
 	}
 
+	//--------------------------------------------------------------
+	glm::dmat3 WarpPerspective::getHomography() const
+	{
+		// Double precision, to stay accurate on large canvases.
+		glm::dvec2 src[4] =
+		{
+			glm::dvec2(0.0, 0.0),
+			glm::dvec2(this->width, 0.0),
+			glm::dvec2(this->width, this->height),
+			glm::dvec2(0.0, this->height)
+		};
+		glm::dvec2 dst[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			dst[i] = glm::dvec2(this->controlPoints[i]) * glm::dvec2(this->windowSize);
+		}
+		return Homography::quadToQuad(src, dst);
+	}
+
+	//--------------------------------------------------------------
+	glm::vec2 WarpPerspective::mapContentToScreen(const glm::vec2 & pos) const
+	{
+		return glm::vec2(Homography::transform(this->getHomography(), glm::dvec2(pos)));
+	}
+
+	//--------------------------------------------------------------
+	bool WarpPerspective::mapScreenToContent(const glm::vec2 & pos, glm::vec2 & content) const
+	{
+		// The homography maps the content onto the quad one to one, so only positions within the content are covered.
+		auto pt = Homography::transform(Homography::invert(this->getHomography()), glm::dvec2(pos));
+		if (pt.x < 0.0 || pt.y < 0.0 || pt.x > this->width || pt.y > this->height) return false;
+
+		content = glm::vec2(pt);
+		return true;
+	}
+
+	//--------------------------------------------------------------
+	void WarpPerspective::mapContentToScreen(const glm::vec2 * content, glm::vec2 * screen, size_t count) const
+	{
+		auto homography = this->getHomography();
+		for (size_t i = 0; i < count; ++i)
+		{
+			screen[i] = glm::vec2(Homography::transform(homography, glm::dvec2(content[i])));
+		}
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpPerspective::mapScreenToContent(const glm::vec2 * screen, glm::vec2 * content, bool * valid, size_t count) const
+	{
+		auto homographyInverted = Homography::invert(this->getHomography());
+
+		size_t numCovered = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto pt = Homography::transform(homographyInverted, glm::dvec2(screen[i]));
+			auto covered = (pt.x >= 0.0 && pt.y >= 0.0 && pt.x <= this->width && pt.y <= this->height);
+			if (covered)
+			{
+				content[i] = glm::vec2(pt);
+				++numCovered;
+			}
+			if (valid)
+			{
+				valid[i] = covered;
+			}
+		}
+		return numCovered;
+	}
+
+	//--------------------------------------------------------------
+	ofRectangle WarpPerspective::getScreenBounds() const
+	{
+		auto minPos = glm::min(glm::min(this->controlPoints[0], this->controlPoints[1]), glm::min(this->controlPoints[2], this->controlPoints[3]));
+		auto maxPos = glm::max(glm::max(this->controlPoints[0], this->controlPoints[1]), glm::max(this->controlPoints[2], this->controlPoints[3]));
+		return ofRectangle(minPos * this->windowSize, maxPos * this->windowSize);
+	}
+
+	//--------------------------------------------------------------
+	void WarpPerspective::getMesh(std::vector<glm::vec3> & positions, std::vector<glm::vec2> & texCoords, std::vector<uint32_t> & indices) const
+	{
+		// The content quad, projected by the homography like the modelview matrix does.
+		auto homography = this->getHomography();
+		texCoords = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+		positions.resize(4);
+		for (int i = 0; i < 4; ++i)
+		{
+			positions[i] = glm::vec3(homography * glm::dvec3(texCoords[i].x * this->width, texCoords[i].y * this->height, 1.0));
+		}
+		indices = { 0, 1, 2, 0, 2, 3 };
+	}
+
+	//--------------------------------------------------------------
+	WarpBase::MemoryUsage WarpPerspective::getMemoryUsage() const
+	{
+		auto usage = WarpBase::getMemoryUsage();
+		usage.vboBytes += WarpBase::getVboBytes(this->quadVbo);
+		return usage;
+	}
+
 	//--------------------------------------------------------------
 	void WarpPerspective::reset(const glm::vec2 & scale, const glm::vec2 & offset)
 	{
@@ -71,6 +176,7 @@ namespace ofxWarp
 		this->controlPoints.push_back(glm::vec2(0.0f, 1.0f) * scale + offset);
 
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -78,11 +184,15 @@ namespace ofxWarp
 	{
 		ofPushMatrix();
 		ofMultMatrix(this->getTransform());
+
+		if (this->gpuTimingEnabled) this->contentGpuTimer.begin();
 	}
 
 	//--------------------------------------------------------------
 	void WarpPerspective::end()
 	{
+		if (this->gpuTimingEnabled) this->contentGpuTimer.end();
+
 		ofPopMatrix();
 
 		this->drawControls();
@@ -91,6 +201,8 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	void WarpPerspective::drawTexture(const ofTexture & texture, const ofRectangle & srcBounds, const ofRectangle & dstBounds)
 	{
+		OFXWARP_TRACE_SCOPE("WarpPerspective::drawTexture");
+
 		// Clip against bounds.
 		auto srcClip = srcBounds;
 		auto dstClip = dstBounds;
@@ -121,6 +233,11 @@ namespace ofxWarp
 			}
 		}
 		
+		if (this->blendLutEnabled)
+		{
+			this->setupBlendLut();
+		}
+
 		ofPushMatrix();
 		{
 			ofMultMatrix(this->getTransform());
@@ -135,20 +252,23 @@ namespace ofxWarp
 					ofSetColor(currentColor);
 				}
 
-				// Draw texture.
-				this->shader.begin();
+				// Pick the cheapest shader variant for the current settings, the editing grid is drawn separately.
+				this->setupShader("WarpPerspective", this->getShaderFeatures(currentColor) & ~SHADER_EDITING);
+				if (this->shader)
 				{
-					this->shader.setUniformTexture("uTexture", texture, 1);
-					this->shader.setUniform3f("uLuminance", this->luminance);
-					this->shader.setUniform3f("uGamma", this->gamma);
-					this->shader.setUniform4f("uEdges", this->edges);
-					this->shader.setUniform4f("uCorners", corners);
-					this->shader.setUniform1f("uExponent", this->exponent);
-
-					const auto mesh = texture.getMeshForSubsection(dstClip.x, dstClip.y, 0.0f, dstClip.width, dstClip.height, srcClip.x, srcClip.y, srcClip.width, srcClip.height, ofIsVFlipped(), OF_RECTMODE_CORNER);
-					mesh.draw();
+					// Draw texture.
+					this->shader->begin();
+					{
+						this->shader->setUniformTexture("uTexture", texture, 1);
+						this->shader->setUniform4f("uCorners", corners);
+						this->counters.numUniformUpdates += 2 + this->setBlendUniforms();
+
+						this->setupQuad(texture, srcClip, dstClip);
+						this->quadVbo.draw(GL_TRIANGLE_FAN, 0, 4);
+						++this->counters.numDrawCalls;
+					}
+					this->shader->end();
 				}
-				this->shader.end();
 			}
 			ofPopStyle();
 
@@ -193,86 +313,62 @@ namespace ofxWarp
 	}
 
 	//--------------------------------------------------------------
-	// Adapted from: http://forum.openframeworks.cc/t/quad-warping-homography-without-opencv/3121/19
-	glm::mat4 WarpPerspective::getPerspectiveTransform(const glm::vec2 src[4], const glm::vec2 dst[4]) const
+	void WarpPerspective::setupQuad(const ofTexture & texture, const ofRectangle & srcBounds, const ofRectangle & dstBounds)
 	{
-		float p[8][9] = 
+		OFXWARP_TRACE_SCOPE("WarpPerspective::setupQuad");
+
+		// Same layout as ofTexture::getMeshForSubsection(), without building a new mesh every frame.
+		auto x0 = dstBounds.getMinX();
+		auto y0 = dstBounds.getMinY();
+		auto x1 = dstBounds.getMaxX();
+		auto y1 = dstBounds.getMaxY();
+		if (texture.getTextureData().bFlipTexture == ofIsVFlipped())
 		{
-			{ -src[0][0], -src[0][1], -1, 0, 0, 0, src[0][0] * dst[0][0], src[0][1] * dst[0][0], -dst[0][0] }, // h11
-			{ 0, 0, 0, -src[0][0], -src[0][1], -1, src[0][0] * dst[0][1], src[0][1] * dst[0][1], -dst[0][1] }, // h12
-			{ -src[1][0], -src[1][1], -1, 0, 0, 0, src[1][0] * dst[1][0], src[1][1] * dst[1][0], -dst[1][0] }, // h13
-			{ 0, 0, 0, -src[1][0], -src[1][1], -1, src[1][0] * dst[1][1], src[1][1] * dst[1][1], -dst[1][1] }, // h21
-			{ -src[2][0], -src[2][1], -1, 0, 0, 0, src[2][0] * dst[2][0], src[2][1] * dst[2][0], -dst[2][0] }, // h22
-			{ 0, 0, 0, -src[2][0], -src[2][1], -1, src[2][0] * dst[2][1], src[2][1] * dst[2][1], -dst[2][1] }, // h23
-			{ -src[3][0], -src[3][1], -1, 0, 0, 0, src[3][0] * dst[3][0], src[3][1] * dst[3][0], -dst[3][0] }, // h31
-			{ 0, 0, 0, -src[3][0], -src[3][1], -1, src[3][0] * dst[3][1], src[3][1] * dst[3][1], -dst[3][1] }, // h32
-		};
+			std::swap(y0, y1);
+		}
 
-		this->gaussianElimination(&p[0][0], 9);
+		auto topLeft = texture.getCoordFromPoint(srcBounds.getMinX(), srcBounds.getMinY());
+		auto bottomRight = texture.getCoordFromPoint(srcBounds.getMaxX(), srcBounds.getMaxY());
 
-		return glm::mat4(p[0][8], p[3][8], 0, p[6][8], 
-						 p[1][8], p[4][8], 0, p[7][8], 
-						 0, 0, 1, 0, 
-						 p[2][8], p[5][8], 0, 1);
-	}
-	
-	//--------------------------------------------------------------
-	void WarpPerspective::gaussianElimination(float * input, int n) const
-	{
-		auto i = 0;
-		auto j = 0;
-		auto m = n - 1;
+		const glm::vec3 vertices[4] = 
+		{
+			glm::vec3(x0, y0, 0.0f),
+			glm::vec3(x1, y0, 0.0f),
+			glm::vec3(x1, y1, 0.0f),
+			glm::vec3(x0, y1, 0.0f)
+		};
+		const glm::vec2 texCoords[4] = 
+		{
+			glm::vec2(topLeft.x, topLeft.y),
+			glm::vec2(bottomRight.x, topLeft.y),
+			glm::vec2(bottomRight.x, bottomRight.y),
+			glm::vec2(topLeft.x, bottomRight.y)
+		};
 
-		while (i < m && j < n) 
+		if (!this->quadVbo.getIsAllocated())
 		{
-			auto iMax = i;
-			for (auto k = i + 1; k < m; ++k)
+			this->quadVbo.setVertexData(vertices, 4, GL_DYNAMIC_DRAW);
+			this->quadVbo.setTexCoordData(texCoords, 4, GL_DYNAMIC_DRAW);
+			this->counters.numVerticesUploaded += 4;
+			this->counters.numBytesUploaded += sizeof(vertices) + sizeof(texCoords);
+		}
+		else
+		{
+			if (!std::equal(vertices, vertices + 4, this->quadVertices))
 			{
-				if (fabs(input[k * n + j]) > fabs(input[iMax * n + j])) 
-				{
-					iMax = k;
-				}
+				this->quadVbo.updateVertexData(vertices, 4);
+				this->counters.numVerticesUploaded += 4;
+				this->counters.numBytesUploaded += sizeof(vertices);
 			}
-
-			if (input[iMax * n + j] != 0) 
+			if (!std::equal(texCoords, texCoords + 4, this->quadTexCoords))
 			{
-				if (i != iMax)
-				{
-					for (auto k = 0; k < n; ++k)
-					{
-						auto ikIn = input[i * n + k];
-						input[i * n + k] = input[iMax * n + k];
-						input[iMax * n + k] = ikIn;
-					}
-				}
-
-				float ijIn = input[i * n + j];
-				for (auto k = 0; k < n; ++k)
-				{
-					input[i * n + k] /= ijIn;
-				}
-
-				for (auto u = i + 1; u < m; ++u)
-				{
-					auto ujIn = input[u * n + j];
-					for (auto k = 0; k < n; ++k)
-					{
-						input[u * n + k] -= ujIn * input[i * n + k];
-					}
-				}
-
-				++i;
+				this->quadVbo.updateTexCoordData(texCoords, 4);
+				this->counters.numBytesUploaded += sizeof(texCoords);
 			}
-			++j;
 		}
 
-		for (auto i = m - 2; i >= 0; --i)
-		{
-			for (auto j = i + 1; j < n - 1; ++j)
-			{
-				input[i * n + m] -= input[i * n + j] * input[j * n + m];
-			}
-		}
+		std::copy(vertices, vertices + 4, this->quadVertices);
+		std::copy(texCoords, texCoords + 4, this->quadTexCoords);
 	}
 
 	//--------------------------------------------------------------
@@ -283,6 +379,7 @@ namespace ofxWarp
 		std::swap(this->controlPoints[1], this->controlPoints[2]);
 		this->selectedIndex = (this->selectedIndex + 3) % 4;
 		this->dirty = true; 
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -293,6 +390,7 @@ namespace ofxWarp
 		std::swap(this->controlPoints[3], this->controlPoints[0]);
 		this->selectedIndex = (this->selectedIndex + 1) % 4;
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -309,6 +407,7 @@ namespace ofxWarp
 			++this->selectedIndex;
 		}
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 
 	//--------------------------------------------------------------
@@ -318,5 +417,6 @@ namespace ofxWarp
 		std::swap(this->controlPoints[1], this->controlPoints[2]);
 		this->selectedIndex = (this->controlPoints.size() - 1) - this->selectedIndex;
 		this->dirty = true;
+		++this->controlPointsRevision;
 	}
 }
\ No newline at end of file
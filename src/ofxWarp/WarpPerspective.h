@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ofVbo.h"
+
 #include "WarpBase.h"
 
 namespace ofxWarp
@@ -13,6 +15,24 @@ namespace ofxWarp
 
 		const glm::mat4 & getTransform();
 		const glm::mat4 & getTransformInverted();
+		//! return the homography from content pixels to window pixels in double precision, computed from the current control points
+		glm::dmat3 getHomography() const;
+
+		//! map a position in content pixels to window pixels
+		virtual glm::vec2 mapContentToScreen(const glm::vec2 & pos) const override;
+		//! map a position in window pixels back to content pixels, return false and leave content untouched if the warp does not cover it
+		virtual bool mapScreenToContent(const glm::vec2 & pos, glm::vec2 & content) const override;
+		//! map count positions in content pixels to window pixels
+		virtual void mapContentToScreen(const glm::vec2 * content, glm::vec2 * screen, size_t count) const override;
+		//! map count positions in window pixels back to content pixels, valid (if set) receives whether each one is covered, return the number covered
+		virtual size_t mapScreenToContent(const glm::vec2 * screen, glm::vec2 * content, bool * valid, size_t count) const override;
+		//! return the bounds of the area covered by the warp, in window pixels
+		virtual ofRectangle getScreenBounds() const override;
+		//! build the triangles drawn for the content, with homogeneous window positions (x, y, w) and normalized content coordinates
+		virtual void getMesh(std::vector<glm::vec3> & positions, std::vector<glm::vec2> & texCoords, std::vector<uint32_t> & indices) const override;
+
+		//! return the memory currently held by the warp, including its quad
+		virtual MemoryUsage getMemoryUsage() const override;
 
 		//! reset control points to undistorted image
 		virtual void reset(const glm::vec2 & scale = glm::vec2(1.0f), const glm::vec2 & offset = glm::vec2(0.0f)) override;
@@ -33,8 +53,8 @@ namespace ofxWarp
 		//! draw the warp's controls interface
 		virtual void drawControls() override;
 
-		glm::mat4 getPerspectiveTransform(const glm::vec2 src[4], const glm::vec2 dst[4]) const;
-		void gaussianElimination(float * input, int n) const;
+		//! update the persistent quad, only uploading to the vbo when the bounds or texture flip state changed
+		void setupQuad(const ofTexture & texture, const ofRectangle & srcBounds, const ofRectangle & dstBounds);
 
 	protected:
 		glm::vec2 srcPoints[4];
@@ -43,7 +63,8 @@ namespace ofxWarp
 		glm::mat4 transform;
 		glm::mat4 transformInverted;
 
-		ofShader shader;
-		ofVboMesh quadMesh;
+		ofVbo quadVbo;
+		glm::vec3 quadVertices[4];
+		glm::vec2 quadTexCoords[4];
 	};
 }
\ No newline at end of file
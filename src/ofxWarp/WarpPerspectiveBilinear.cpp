@@ -7,6 +7,7 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	WarpPerspectiveBilinear::WarpPerspectiveBilinear(const ofFbo::Settings & fboSettings)
 		: WarpBilinear(fboSettings)
+		, screenPointsRevision(-1)
 	{
 		this->type = TYPE_PERSPECTIVE_BILINEAR;
 
@@ -35,21 +36,30 @@ namespace ofxWarp
 	}
 	
 	//--------------------------------------------------------------
-	void WarpPerspectiveBilinear::deserialize(const nlohmann::json & json)
+	void WarpPerspectiveBilinear::getState(State & state) const
 	{
-		WarpBilinear::deserialize(json);
+		WarpBilinear::getState(state);
 
-		auto i = 0;
-		for (const auto & jsonPoint : json["corners"])
+		for (auto i = 0; i < 4; ++i)
 		{
-			glm::vec2 corner;
-			std::istringstream iss;
-			iss.str(jsonPoint);
-			iss >> corner;
-			this->warpPerspective->setControlPoint(i, corner);
+			state.corners[i] = this->warpPerspective->getControlPoint(i);
+		}
+	}
+
+	//--------------------------------------------------------------
+	bool WarpPerspectiveBilinear::setState(const State & state)
+	{
+		if (!WarpBilinear::setState(state)) return false;
 
-			++i;
+		for (auto i = 0; i < 4; ++i)
+		{
+			if (state.corners[i] != this->warpPerspective->getControlPoint(i))
+			{
+				this->warpPerspective->setControlPoint(i, state.corners[i]);
+			}
 		}
+
+		return true;
 	}
 
 	//--------------------------------------------------------------
@@ -79,23 +89,11 @@ namespace ofxWarp
 	//--------------------------------------------------------------
 	glm::vec2 WarpPerspectiveBilinear::getControlPoint(size_t index) const
 	{
-		// Depending on index, return perspective or bilinear control point.
-		if (this->isCorner(index)) 
-		{
-			// Perspective: simply return one of the corners.
-			return this->warpPerspective->getControlPoint(this->convertIndex(index));
-		}
-		else 
-		{
-			// Bilinear: transform control point from warped space to normalized screen space.
-			auto cp = WarpBase::getControlPoint(index) * this->warpPerspective->getSize();
-			auto pt = this->warpPerspective->getTransform() * glm::vec4(cp.x, cp.y, 0.0f, 1.0f);
-
-			if (pt.w != 0) pt.w = 1.0f / pt.w;
-			pt *= pt.w;
+		// Both perspective and bilinear control points are cached in normalized screen space.
+		const auto & points = this->getControlPoints();
+		if (index >= points.size()) return glm::vec2(0.0f);
 
-			return glm::vec2(pt.x, pt.y) / this->windowSize;
-		}
+		return points[index];
 	}
 
 	//--------------------------------------------------------------
@@ -110,16 +108,56 @@ namespace ofxWarp
 		else 
 		{
 			// Bilinear:: transform control point from normalized screen space to warped space.
-			auto cp = pos * this->windowSize;
-			auto pt = this->warpPerspective->getTransformInverted() * glm::vec4(cp.x, cp.y, 0.0f, 1.0f);
+			WarpBase::setControlPoint(index, this->screenToGrid(pos));
+		}
+	}
+
+	//--------------------------------------------------------------
+	glm::vec2 WarpPerspectiveBilinear::screenToGrid(const glm::vec2 & pos) const
+	{
+		auto cp = pos * this->windowSize;
+		auto pt = this->warpPerspective->getTransformInverted() * glm::vec4(cp.x, cp.y, 0.0f, 1.0f);
 
-			if (pt.w != 0) pt.w = 1.0f / pt.w;
-			pt *= pt.w;
+		if (pt.w != 0) pt.w = 1.0f / pt.w;
+		pt *= pt.w;
+
+		return glm::vec2(pt.x, pt.y) / this->warpPerspective->getSize();
+	}
 
-			WarpBase::setControlPoint(index, glm::vec2(pt.x, pt.y) / this->warpPerspective->getSize());
+	//--------------------------------------------------------------
+	void WarpPerspectiveBilinear::getMesh(std::vector<glm::vec3> & positions, std::vector<glm::vec2> & texCoords, std::vector<uint32_t> & indices) const
+	{
+		WarpBilinear::getMesh(positions, texCoords, indices);
+
+		// The bilinear mesh is drawn in the content space of the perspective warp.
+		auto homography = this->warpPerspective->getHomography();
+		for (auto & pos : positions)
+		{
+			pos = glm::vec3(homography * glm::dvec3(pos));
 		}
 	}
 
+	//--------------------------------------------------------------
+	WarpBase::MemoryUsage WarpPerspectiveBilinear::getMemoryUsage() const
+	{
+		auto usage = WarpBilinear::getMemoryUsage();
+		usage.cpuBytes += this->screenPoints.capacity() * sizeof(glm::vec2);
+		usage += this->warpPerspective->getMemoryUsage();
+		return usage;
+	}
+
+	//--------------------------------------------------------------
+	glm::vec2 WarpPerspectiveBilinear::gridToScreen(const glm::vec2 & pos) const
+	{
+		auto cp = pos * this->warpPerspective->getSize();
+		auto pt = this->warpPerspective->getTransform() * glm::vec4(cp.x, cp.y, 0.0f, 1.0f);
+
+		if (pt.w != 0) pt.w = 1.0f / pt.w;
+		pt *= pt.w;
+
+		return glm::vec2(pt.x, pt.y) / this->windowSize;
+	}
+
 	//--------------------------------------------------------------
 	void WarpPerspectiveBilinear::moveControlPoint(size_t index, const glm::vec2 & shift)
 	{
@@ -160,6 +198,57 @@ namespace ofxWarp
 		WarpBase::deselectControlPoint();
 	}
 
+	//--------------------------------------------------------------
+	const std::vector<glm::vec2> & WarpPerspectiveBilinear::getControlPoints() const
+	{
+		this->updateScreenPoints();
+
+		return this->screenPoints;
+	}
+
+	//--------------------------------------------------------------
+	size_t WarpPerspectiveBilinear::getControlPointsRevision() const
+	{
+		// Both counters only ever increase, so their sum changes whenever either of them does.
+		return this->controlPointsRevision + this->warpPerspective->getControlPointsRevision();
+	}
+
+	//--------------------------------------------------------------
+	void WarpPerspectiveBilinear::updateScreenPoints() const
+	{
+		auto revision = this->getControlPointsRevision();
+		if (revision == this->screenPointsRevision && this->screenPoints.size() == this->controlPoints.size()) return;
+
+		const auto & transform = this->warpPerspective->getTransform();
+		const auto size = this->warpPerspective->getSize();
+		const auto invWindowSize = 1.0f / this->windowSize;
+
+		// Bilinear: transform control points from warped space to normalized screen space.
+		this->screenPoints.resize(this->controlPoints.size());
+		for (size_t i = 0; i < this->controlPoints.size(); ++i)
+		{
+			auto cp = this->controlPoints[i] * size;
+			auto x = transform[0][0] * cp.x + transform[1][0] * cp.y + transform[3][0];
+			auto y = transform[0][1] * cp.x + transform[1][1] * cp.y + transform[3][1];
+			auto w = transform[0][3] * cp.x + transform[1][3] * cp.y + transform[3][3];
+			if (w != 0.0f) w = 1.0f / w;
+
+			this->screenPoints[i] = glm::vec2(x * w, y * w) * invWindowSize;
+		}
+
+		// Perspective: simply use the corners.
+		if (!this->screenPoints.empty())
+		{
+			auto numControls = this->numControlsX * this->numControlsY;
+			this->screenPoints[0] = this->warpPerspective->getControlPoint(0);
+			this->screenPoints[this->numControlsY - 1] = this->warpPerspective->getControlPoint(1);
+			this->screenPoints[numControls - this->numControlsY] = this->warpPerspective->getControlPoint(2);
+			this->screenPoints[numControls - 1] = this->warpPerspective->getControlPoint(3);
+		}
+
+		this->screenPointsRevision = revision;
+	}
+
 	//--------------------------------------------------------------
 	void WarpPerspectiveBilinear::rotateClockwise()
 	{
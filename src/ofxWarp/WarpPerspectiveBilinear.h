@@ -13,7 +13,9 @@ namespace ofxWarp
 		virtual ~WarpPerspectiveBilinear();
 
 		virtual void serialize(nlohmann::json & json) override;
-		virtual void deserialize(const nlohmann::json & json) override;
+
+		virtual void getState(State & state) const override;
+		virtual bool setState(const State & state) override;
 
 		virtual void setEditing(bool editing) override;
 
@@ -32,6 +34,21 @@ namespace ofxWarp
 		virtual void selectControlPoint(size_t index) override;
 		//! deselect the selected control point
 		virtual void deselectControlPoint() override;
+		//! return the coordinates of all control points in normalized screen space
+		virtual const std::vector<glm::vec2> & getControlPoints() const override;
+		//! return a counter that changes whenever the screen position of any control point, or the shape of the warp between them, may have changed
+		virtual size_t getControlPointsRevision() const override;
+
+		//! convert a position in normalized screen space to normalized warped space, through the inverse perspective
+		virtual glm::vec2 screenToGrid(const glm::vec2 & pos) const override;
+		//! convert a position in normalized warped space to normalized screen space, through the perspective
+		virtual glm::vec2 gridToScreen(const glm::vec2 & pos) const override;
+
+		//! build the triangles drawn for the content, with homogeneous window positions (x, y, w) and normalized content coordinates
+		virtual void getMesh(std::vector<glm::vec3> & positions, std::vector<glm::vec2> & texCoords, std::vector<uint32_t> & indices) const override;
+
+		//! return the memory currently held by the warp, including its perspective warp
+		virtual MemoryUsage getMemoryUsage() const override;
 
 		virtual void rotateClockwise() override;
 		virtual void rotateCounterclockwise() override;
@@ -50,7 +67,14 @@ namespace ofxWarp
 		//! convert the control point index to the appropriate perspective warp index
 		size_t convertIndex(size_t index) const;
 
+		//! transform all control points to normalized screen space, if the perspective corners, the bilinear grid or the window size changed
+		void updateScreenPoints() const;
+
 	protected:
 		std::shared_ptr<WarpPerspective> warpPerspective;
+
+		//! cached control points in normalized screen space
+		mutable std::vector<glm::vec2> screenPoints;
+		mutable size_t screenPointsRevision;
 	};
 }
\ No newline at end of file